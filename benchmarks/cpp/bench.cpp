@@ -0,0 +1,237 @@
+/**
+ * Benchmarks of the hot paths of cppcolormap.
+ *
+ * Usage::
+ *
+ *     bench [--json benchmark.json] [--filter as_colors] [--min-time 0.2]
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#include <cppcolormap.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <xtensor/xrandom.hpp>
+
+#include "harness.h"
+
+template <class T>
+std::string dtype_name();
+
+template <>
+std::string dtype_name<double>()
+{
+    return "double";
+}
+
+template <>
+std::string dtype_name<float>()
+{
+    return "float";
+}
+
+template <>
+std::string dtype_name<int16_t>()
+{
+    return "int16";
+}
+
+template <>
+std::string dtype_name<uint8_t>()
+{
+    return "uint8";
+}
+
+template <class T, size_t rank>
+void bench_as_colors(
+    harness::Runner& runner,
+    const std::array<size_t, rank>& shape,
+    size_t N,
+    size_t threads
+)
+{
+    cppcolormap::array_type::tensor<double, 2> colors = cppcolormap::viridis(N);
+    cppcolormap::array_type::tensor<double, rank> r = xt::random::rand<double>(shape);
+    cppcolormap::array_type::tensor<T, rank> data = xt::cast<T>(100.0 * r);
+    size_t n = data.size();
+
+    std::string name = "as_colors/rank=" + std::to_string(rank) + "/dtype=" + dtype_name<T>() +
+                       "/N=" + std::to_string(N) + "/threads=" + std::to_string(threads);
+
+    size_t nthreads = cppcolormap::get_num_threads();
+    cppcolormap::set_num_threads(threads);
+    runner.run(name, n, n * (sizeof(T) + 3 * sizeof(double)), [&]() {
+        auto c = cppcolormap::as_colors(data, colors, T(0), T(100));
+        harness::do_not_optimize(c.data());
+    });
+    cppcolormap::set_num_threads(nthreads);
+}
+
+template <class T>
+void bench_as_colors_all(harness::Runner& runner, size_t threads)
+{
+    for (size_t N : {16, 256, 65536}) {
+        bench_as_colors<T, 1>(runner, {1048576}, N, threads);
+        bench_as_colors<T, 2>(runner, {1024, 1024}, N, threads);
+        bench_as_colors<T, 3>(runner, {64, 128, 128}, N, threads);
+    }
+}
+
+template <typename O>
+void bench_as_colors_pointer(harness::Runner& runner, cppcolormap::pixel_format format)
+{
+    size_t n = 1048576;
+    cppcolormap::CompiledColormap<O> cmap(cppcolormap::viridis(256), format);
+    std::vector<double> data(n);
+    std::vector<O> out(n * cmap.channels());
+
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = static_cast<double>(i % 1000) / 1000.0;
+    }
+
+    std::string name = "as_colors_pointer/out=" + std::string(sizeof(O) == 1 ? "uint8" : "float") +
+                       "/channels=" + std::to_string(cmap.channels());
+
+    runner.run(name, n, n * (sizeof(double) + cmap.channels() * sizeof(O)), [&]() {
+        cppcolormap::as_colors(data.data(), n, 1, cmap, 0.0, 1.0, out.data());
+        harness::do_not_optimize(out.data());
+    });
+}
+
+void bench_interp(harness::Runner& runner)
+{
+    cppcolormap::array_type::tensor<double, 2> colors = cppcolormap::Reds(9);
+
+    for (size_t N : {256, 65536}) {
+        runner.run("interp/N=" + std::to_string(N), N, 3 * N * sizeof(double), [&]() {
+            cppcolormap::array_type::tensor<double, 2> c = cppcolormap::interp(colors, N);
+            harness::do_not_optimize(c.data());
+        });
+        runner.run("interp/Oklab/N=" + std::to_string(N), N, 3 * N * sizeof(double), [&]() {
+            auto c = cppcolormap::interp(colors, N, cppcolormap::Oklab);
+            harness::do_not_optimize(c.data());
+        });
+    }
+}
+
+void bench_colormap(harness::Runner& runner)
+{
+    size_t N = 256;
+
+    for (auto& cmap : cppcolormap::registered_colormaps()) {
+        runner.run("colormap/" + cmap + "/N=256", N, 3 * N * sizeof(double), [&]() {
+            auto c = cppcolormap::colormap(cmap, N);
+            harness::do_not_optimize(c.data());
+        });
+    }
+}
+
+void bench_match(harness::Runner& runner)
+{
+    size_t n = 65536;
+    cppcolormap::array_type::tensor<double, 2> A = xt::random::rand<double>({n, size_t(3)});
+
+    std::vector<std::pair<std::string, cppcolormap::metric>> metrics = {
+        {"euclidean", cppcolormap::euclidean},
+        {"fast_perceptual", cppcolormap::fast_perceptual},
+        {"perceptual", cppcolormap::perceptual},
+        {"delta_e_cie76", cppcolormap::delta_e_cie76},
+        {"delta_e_oklab", cppcolormap::delta_e_oklab},
+    };
+
+    for (size_t m : {16, 256}) {
+        cppcolormap::array_type::tensor<double, 2> B = xt::random::rand<double>({m, size_t(3)});
+        for (auto& metric : metrics) {
+            std::string name = "match/" + metric.first + "/palette=" + std::to_string(m);
+            runner.run(name, n, n * (3 * sizeof(double) + sizeof(size_t)), [&]() {
+                auto idx = cppcolormap::match(A, B, metric.second);
+                harness::do_not_optimize(idx.data());
+            });
+        }
+    }
+}
+
+void bench_hex(harness::Runner& runner)
+{
+    size_t n = 1048576;
+    cppcolormap::array_type::tensor<double, 2> rgb = xt::random::rand<double>({n, size_t(3)});
+    cppcolormap::HexArray hex = cppcolormap::rgb2hex_array(rgb);
+    std::vector<std::string> strings = cppcolormap::rgb2hex(rgb);
+
+    runner.run("rgb2hex_array", n, n * (3 * sizeof(double) + 7), [&]() {
+        auto h = cppcolormap::rgb2hex_array(rgb);
+        harness::do_not_optimize(h.data());
+    });
+
+    runner.run("rgb2hex", n, n * (3 * sizeof(double) + 7), [&]() {
+        auto h = cppcolormap::rgb2hex(rgb);
+        harness::do_not_optimize(h.data());
+    });
+
+    runner.run("hex2rgb/HexArray", n, n * (7 + 3 * sizeof(double)), [&]() {
+        auto c = cppcolormap::hex2rgb(hex);
+        harness::do_not_optimize(c.data());
+    });
+
+    runner.run("hex2rgb/vector", n, n * (7 + 3 * sizeof(double)), [&]() {
+        auto c = cppcolormap::hex2rgb(strings);
+        harness::do_not_optimize(c.data());
+    });
+}
+
+int main(int argc, char** argv)
+{
+    std::string json;
+    std::string filter;
+    double min_time = 0.2;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            json = argv[++i];
+        }
+        else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (arg == "--min-time" && i + 1 < argc) {
+            min_time = std::atof(argv[++i]);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--json FILE] [--filter SUBSTRING] [--min-time SECONDS]\n";
+            return 1;
+        }
+    }
+
+    harness::Runner runner(filter, min_time);
+    std::vector<size_t> threads = {1};
+
+    if (std::thread::hardware_concurrency() > 1) {
+        threads.push_back(std::thread::hardware_concurrency());
+    }
+
+    for (size_t t : threads) {
+        bench_as_colors_all<double>(runner, t);
+        bench_as_colors_all<float>(runner, t);
+        bench_as_colors_all<int16_t>(runner, t);
+        bench_as_colors_all<uint8_t>(runner, t);
+    }
+
+    bench_as_colors_pointer<uint8_t>(runner, cppcolormap::rgba);
+    bench_as_colors_pointer<uint8_t>(runner, cppcolormap::rgb);
+    bench_as_colors_pointer<float>(runner, cppcolormap::rgb);
+    bench_interp(runner);
+    bench_colormap(runner);
+    bench_match(runner);
+    bench_hex(runner);
+
+    if (!json.empty()) {
+        runner.write_json(json, cppcolormap::version());
+    }
+
+    return 0;
+}
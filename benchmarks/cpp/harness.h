@@ -0,0 +1,151 @@
+/**
+ * Minimal benchmark harness: timing, throughput, and JSON output.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_BENCHMARKS_HARNESS_H
+#define CPPCOLORMAP_BENCHMARKS_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace harness {
+
+/**
+ * Prevent the compiler from optimising away a result.
+ */
+template <class T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Result of one benchmark.
+ */
+struct Result {
+    std::string name; ///< Name, e.g. "as_colors/rank=2/dtype=double/N=256/threads=1".
+    size_t iterations; ///< Number of timed calls.
+    double seconds; ///< Median wall-time per call.
+    double min_seconds; ///< Fastest call.
+    size_t items; ///< Number of items processed per call.
+    size_t bytes; ///< Number of bytes processed (read + written) per call.
+
+    double items_per_second() const
+    {
+        return static_cast<double>(items) / seconds;
+    }
+
+    double bytes_per_second() const
+    {
+        return static_cast<double>(bytes) / seconds;
+    }
+};
+
+/**
+ * Collection of benchmarks.
+ */
+class Runner {
+public:
+    /**
+     * @param filter Only run benchmarks whose name contains this string.
+     * @param min_time Minimal total time per benchmark [s].
+     */
+    Runner(std::string filter, double min_time) : m_filter(std::move(filter)), m_min_time(min_time)
+    {
+    }
+
+    /**
+     * Time `func()`: calls are repeated until `min_time` has passed (at least three times).
+     *
+     * @param name Name of the benchmark.
+     * @param items Number of items processed per call.
+     * @param bytes Number of bytes processed (read + written) per call.
+     * @param func Function to time.
+     */
+    template <class F>
+    void run(const std::string& name, size_t items, size_t bytes, const F& func)
+    {
+        if (name.find(m_filter) == std::string::npos) {
+            return;
+        }
+
+        using clock = std::chrono::steady_clock;
+        std::vector<double> t;
+        double total = 0.0;
+
+        func(); // warm-up
+
+        while (t.size() < 3 || total < m_min_time) {
+            auto tic = clock::now();
+            func();
+            double dt = std::chrono::duration<double>(clock::now() - tic).count();
+            t.push_back(dt);
+            total += dt;
+        }
+
+        std::sort(t.begin(), t.end());
+        Result r{name, t.size(), t[t.size() / 2], t.front(), items, bytes};
+        m_results.push_back(r);
+
+        std::printf(
+            "%-60s %10.3f us %12.4g items/s %12.4g B/s\n",
+            name.c_str(),
+            1e6 * r.seconds,
+            r.items_per_second(),
+            r.bytes_per_second()
+        );
+        std::fflush(stdout);
+    }
+
+    /**
+     * Write all results as JSON.
+     *
+     * @param path Output file.
+     * @param version Library version.
+     */
+    void write_json(const std::string& path, const std::string& version) const
+    {
+        std::ofstream out(path);
+        out << "{\n";
+        out << "  \"library\": \"cppcolormap\",\n";
+        out << "  \"version\": \"" << version << "\",\n";
+        out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"benchmarks\": [\n";
+
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            const auto& r = m_results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"seconds\": " << r.seconds << ", \"min_seconds\": " << r.min_seconds
+                << ", \"items\": " << r.items << ", \"bytes\": " << r.bytes
+                << ", \"items_per_second\": " << r.items_per_second()
+                << ", \"bytes_per_second\": " << r.bytes_per_second() << "}"
+                << (i + 1 < m_results.size() ? ",\n" : "\n");
+        }
+
+        out << "  ]\n";
+        out << "}\n";
+    }
+
+private:
+    std::string m_filter;
+    double m_min_time;
+    std::vector<Result> m_results;
+};
+
+} // namespace harness
+
+#endif
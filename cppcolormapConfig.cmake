@@ -3,6 +3,7 @@
 # This module sets the target:
 #
 #   cppcolormap
+#   cppcolormap_c - C API (shared library), if installed with BUILD_C_API
 #
 # In addition, it sets the following variables:
 #
@@ -12,10 +13,14 @@
 # The following support targets are defined to simplify things:
 #
 #   cppcolormap::compiler_warnings - enable compiler warnings
+#   cppcolormap::use_serial - run all kernels on the calling thread (by default)
+#   cppcolormap::use_openmp - use OpenMP as parallel backend (by default), if OpenMP is found
+#   cppcolormap::use_tbb - use TBB as parallel backend (by default), if TBB is found
 
 include(CMakeFindDependencyMacro)
 
 find_dependency(xtensor)
+find_dependency(Threads)
 
 if(NOT TARGET cppcolormap)
     include("${CMAKE_CURRENT_LIST_DIR}/cppcolormapTargets.cmake")
@@ -38,3 +43,47 @@ if(NOT TARGET cppcolormap::compiler_warnings)
             -Wall -Wextra -pedantic -Wno-unknown-pragmas)
     endif()
 endif()
+
+# Define support target "cppcolormap::use_serial"
+
+if(NOT TARGET cppcolormap::use_serial)
+    add_library(cppcolormap::use_serial INTERFACE IMPORTED)
+    set_property(
+        TARGET cppcolormap::use_serial
+        PROPERTY INTERFACE_COMPILE_DEFINITIONS
+        CPPCOLORMAP_USE_SERIAL)
+endif()
+
+# Define support target "cppcolormap::use_openmp"
+
+if(NOT TARGET cppcolormap::use_openmp)
+    find_package(OpenMP QUIET)
+    if(OpenMP_CXX_FOUND)
+        add_library(cppcolormap::use_openmp INTERFACE IMPORTED)
+        set_property(
+            TARGET cppcolormap::use_openmp
+            PROPERTY INTERFACE_COMPILE_DEFINITIONS
+            CPPCOLORMAP_USE_OPENMP)
+        set_property(
+            TARGET cppcolormap::use_openmp
+            PROPERTY INTERFACE_LINK_LIBRARIES
+            OpenMP::OpenMP_CXX)
+    endif()
+endif()
+
+# Define support target "cppcolormap::use_tbb"
+
+if(NOT TARGET cppcolormap::use_tbb)
+    find_package(TBB QUIET CONFIG)
+    if(TBB_FOUND)
+        add_library(cppcolormap::use_tbb INTERFACE IMPORTED)
+        set_property(
+            TARGET cppcolormap::use_tbb
+            PROPERTY INTERFACE_COMPILE_DEFINITIONS
+            CPPCOLORMAP_USE_TBB)
+        set_property(
+            TARGET cppcolormap::use_tbb
+            PROPERTY INTERFACE_LINK_LIBRARIES
+            TBB::tbb)
+    endif()
+endif()
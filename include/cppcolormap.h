@@ -46,6 +46,31 @@
 #define CPPCOLORMAP_ASSERT(expr)
 #endif
 
+/**
+ * Statistics of the hot paths (calls, elements, bytes, wall time, threads) are recorded by:
+ *
+ *     CPPCOLORMAP_STATS_SCOPE(...)
+ *     CPPCOLORMAP_STATS_COUNT(...)
+ *
+ * They can be enabled by:
+ *
+ *     #define CPPCOLORMAP_ENABLE_STATS
+ *
+ * (before including cppcolormap).
+ * They are read using cppcolormap::stats.
+ */
+#ifdef CPPCOLORMAP_ENABLE_STATS
+#define CPPCOLORMAP_STATS_SCOPE(name) \
+    cppcolormap::detail::stats_scope cppcolormap_stats_scope( \
+        cppcolormap::detail::stats_counters().name \
+    )
+#define CPPCOLORMAP_STATS_COUNT(elements, bytes, threads) \
+    cppcolormap_stats_scope.count(elements, bytes, threads)
+#else
+#define CPPCOLORMAP_STATS_SCOPE(name)
+#define CPPCOLORMAP_STATS_COUNT(elements, bytes, threads)
+#endif
+
 /**
  * Current version.
  *
@@ -79,12 +104,38 @@
  * \endcond
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <math.h>
-#include <sstream>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#define CPPCOLORMAP_HAS_STRING_VIEW
+#endif
+
 #include <xtensor/xarray.hpp>
 #include <xtensor/xmanipulation.hpp>
 #include <xtensor/xmath.hpp>
@@ -92,6 +143,12 @@
 #include <xtensor/xtensor.hpp>
 #include <xtensor/xview.hpp>
 
+#ifdef CPPCOLORMAP_USE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
 namespace cppcolormap {
 
 /**
@@ -119,6 +176,82 @@ using tensor = xt::xtensor<T, N>;
 
 } // namespace array_type
 
+#ifdef CPPCOLORMAP_HAS_STRING_VIEW
+
+/**
+ * Non-owning view on a string: `std::string_view` (C++17) or a minimal replacement (C++14).
+ */
+using string_view = std::string_view;
+
+#else
+
+/**
+ * Non-owning view on a string: `std::string_view` (C++17) or a minimal replacement (C++14).
+ */
+class string_view {
+public:
+    string_view() = default;
+
+    string_view(const char* data, size_t size) : m_data(data), m_size(size)
+    {
+    }
+
+    string_view(const char* data) : m_data(data), m_size(std::strlen(data))
+    {
+    }
+
+    string_view(const std::string& str) : m_data(str.data()), m_size(str.size())
+    {
+    }
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    const char& operator[](size_t i) const
+    {
+        return m_data[i];
+    }
+
+    void remove_prefix(size_t n)
+    {
+        m_data += n;
+        m_size -= n;
+    }
+
+    operator std::string() const
+    {
+        return std::string(m_data, m_size);
+    }
+
+    friend bool operator==(string_view a, string_view b)
+    {
+        return a.m_size == b.m_size && std::equal(a.m_data, a.m_data + a.m_size, b.m_data);
+    }
+
+    friend bool operator!=(string_view a, string_view b)
+    {
+        return !(a == b);
+    }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+#endif
+
 namespace detail {
 
 inline std::string unquote(const std::string& arg)
@@ -128,6 +261,52 @@ inline std::string unquote(const std::string& arg)
     return ret;
 }
 
+/**
+ * Check if the data of an (evaluated) container is contiguous in row-major order,
+ * which is not the case for example for a column-major array or a strided NumPy view.
+ *
+ * @param e Container.
+ * @return `true` if item `i` (in row-major order) is ``e.data()[i]``.
+ */
+template <class E>
+inline bool is_row_major(const E& e)
+{
+    const auto& strides = e.strides();
+    ptrdiff_t expected = 1;
+
+    for (size_t i = e.dimension(); i-- > 0;) {
+        if (e.shape(i) != 1 && static_cast<ptrdiff_t>(strides[i]) != expected) {
+            return false;
+        }
+        expected *= static_cast<ptrdiff_t>(e.shape(i));
+    }
+
+    return true;
+}
+
+/**
+ * Evaluate an expression and call `func(const value_type* data)` with its data
+ * contiguous in row-major order.
+ * The data is copied only if the evaluated expression is not row-major.
+ *
+ * @param e Expression.
+ * @param func Function `void(const value_type* data)`.
+ */
+template <class E, class F>
+inline void with_row_major(const E& e, F&& func)
+{
+    auto&& d = xt::eval(e);
+    using value_type = typename std::decay_t<decltype(d)>::value_type;
+
+    if (is_row_major(d)) {
+        func(d.data());
+        return;
+    }
+
+    xt::xarray<value_type> copy = d;
+    func(copy.data());
+}
+
 } // namespace detail
 
 /**
@@ -164,228 +343,2041 @@ inline std::vector<std::string> version_dependencies()
     return ret;
 }
 
-namespace detail {
+/**
+ * Parallel backend used by the kernels of this library, see cppcolormap::set_parallel_backend.
+ * Backends parallel_backend::openmp and parallel_backend::tbb_arena are only available
+ * if ``CPPCOLORMAP_USE_OPENMP`` or ``CPPCOLORMAP_USE_TBB`` is defined
+ * (e.g. by linking to the CMake targets ``cppcolormap::use_openmp`` or ``cppcolormap::use_tbb``).
+ */
+enum class parallel_backend {
+    serial, ///< Everything on the calling thread.
+    thread_pool, ///< Built-in pool of ``std::thread`` (started on first use).
+    openmp, ///< OpenMP (``CPPCOLORMAP_USE_OPENMP``).
+    tbb_arena, ///< TBB, in a ``tbb::task_arena`` limited to cppcolormap::get_num_threads.
+    callback ///< User-supplied function, see cppcolormap::set_parallel_callback.
+};
 
 /**
- * See: https://www.codespeedy.com/convert-rgb-to-hex-color-code-in-cpp
- *
- * @param r Red [0..255].
- * @param g Green [0..255].
- * @param b Blue [0..255].
- * @return Hex string.
+ * Signature of a user-supplied parallel loop, see cppcolormap::set_parallel_callback.
+ * It must call `func(begin, end)` on blocks that exactly cover `[0, n)`,
+ * preferably of about `grain` items, and return once all blocks are done.
  */
-std::string rgb2hex(size_t r, size_t g, size_t b)
+using parallel_callback = std::function<
+    void(size_t n, size_t grain, const std::function<void(size_t begin, size_t end)>& func)>;
+
+namespace detail {
+
+constexpr parallel_backend default_parallel_backend()
 {
-    std::stringstream ss;
-    ss << "#" << std::hex << (r << 16 | g << 8 | b);
-    return ss.str();
+#if defined(CPPCOLORMAP_USE_TBB)
+    return parallel_backend::tbb_arena;
+#elif defined(CPPCOLORMAP_USE_OPENMP)
+    return parallel_backend::openmp;
+#elif defined(CPPCOLORMAP_USE_SERIAL)
+    return parallel_backend::serial;
+#else
+    return parallel_backend::thread_pool;
+#endif
 }
 
 /**
- * See: https://stackoverflow.com/questions/28104559/arduino-strange-behavior-converting-hex-to-rgb
- *
- * @param hex Hex string.
- * @return RGB data.
+ * Global configuration of the parallel backend.
+ * It may be changed while other threads run kernels:
+ * the settings are atomic, the callback is guarded by a mutex (and copied before it is called).
  */
-array_type::tensor<size_t, 1> hex2rgb(std::string hex)
-{
-    if (hex.at(0) == '#') {
-        hex.erase(0, 1);
-    }
+struct parallel_config {
+    std::atomic<size_t> threads{
+        std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t(1))};
+    std::atomic<size_t> grain{32768};
+    std::atomic<parallel_backend> backend{default_parallel_backend()};
+    std::mutex mutex;
+    parallel_callback func;
 
-    while (hex.length() != 6) {
-        hex += "0";
+    parallel_callback callback()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return func;
     }
+};
 
-    array_type::tensor<size_t, 1> rgb = xt::empty<size_t>({size_t(3)});
-
-    size_t h = (size_t)std::stol(&hex[0], nullptr, 16);
-
-    rgb(0) = h >> 16;
-    rgb(1) = h >> 8 & 0xFF;
-    rgb(2) = h & 0xFF;
-
-    return rgb;
+inline parallel_config& parallel()
+{
+    static parallel_config ret;
+    return ret;
 }
 
 } // namespace detail
 
 /**
- * Convert RGB -> HEX.
+ * Set the maximum number of threads used by the kernels of this library
+ * (e.g. cppcolormap::as_colors and cppcolormap::as_indices).
+ * By default the number of concurrent threads supported by the hardware is used.
+ * Small inputs are always processed on the calling thread.
  *
- * @param arg RGB data (values between 0 and 1).
- * @returns Vector of strings.
+ * @param n Number of threads (`n <= 1` disables threading).
  */
-template <class T, typename std::enable_if_t<xt::get_rank<T>::value != 1, int> = 0>
-std::vector<std::string> rgb2hex(const T& arg)
+inline void set_num_threads(size_t n)
 {
-    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
-    CPPCOLORMAP_ASSERT(arg.shape(1) == 3);
-    CPPCOLORMAP_ASSERT(xt::all(arg >= 0.0 && arg <= 1.0));
-
-    std::vector<std::string> ret;
-
-    for (size_t i = 0; i < arg.shape(0); ++i) {
-        ret.push_back(detail::rgb2hex(
-            static_cast<size_t>(arg(i, 0) * 255.0),
-            static_cast<size_t>(arg(i, 1) * 255.0),
-            static_cast<size_t>(arg(i, 2) * 255.0)
-        ));
-    }
-
-    return ret;
+    detail::parallel().threads = std::max(n, size_t(1));
 }
 
 /**
- * Convert RGB -> HEX.
+ * Maximum number of threads used by the kernels of this library, see cppcolormap::set_num_threads.
  *
- * @param arg RGB data (values between 0 and 1).
- * @returns String.
+ * @return Number of threads.
  */
-template <class T, typename std::enable_if_t<xt::get_rank<T>::value == 1, int> = 0>
-std::string rgb2hex(const T& arg)
+inline size_t get_num_threads()
 {
-    CPPCOLORMAP_ASSERT(arg.size() == 3);
-    CPPCOLORMAP_ASSERT(xt::all(arg >= 0.0 && arg <= 1.0));
+    return detail::parallel().threads;
+}
 
-    return detail::rgb2hex(
-        static_cast<size_t>(arg(0) * 255.0),
-        static_cast<size_t>(arg(1) * 255.0),
-        static_cast<size_t>(arg(2) * 255.0)
-    );
+/**
+ * Set the grain size: the minimal number of data-points processed per task
+ * (kernels that do more work per data-point use a proportionally smaller grain).
+ * Inputs smaller than the grain size are processed on the calling thread.
+ *
+ * @param n Number of data-points (default: 32768).
+ */
+inline void set_parallel_grain(size_t n)
+{
+    detail::parallel().grain = std::max(n, size_t(1));
 }
 
 /**
- * Convert HEX -> RGB.
+ * Grain size, see cppcolormap::set_parallel_grain.
  *
- * @param arg HEX data.
- * @returns RGB data.
+ * @return Number of data-points.
  */
-array_type::tensor<double, 2> hex2rgb(const std::vector<std::string>& arg)
+inline size_t get_parallel_grain()
 {
-    array_type::tensor<double, 2> out = xt::empty<double>({arg.size(), size_t(3)});
+    return detail::parallel().grain;
+}
 
-    for (size_t i = 0; i < arg.size(); ++i) {
-        xt::view(out, i, xt::all()) = detail::hex2rgb(arg[i]);
+/**
+ * Check if a parallel backend is available
+ * (i.e. compiled in, or for parallel_backend::callback: set).
+ *
+ * @param backend Parallel backend.
+ * @return Boolean.
+ */
+inline bool has_parallel_backend(parallel_backend backend)
+{
+    switch (backend) {
+    case parallel_backend::serial:
+    case parallel_backend::thread_pool:
+        return true;
+    case parallel_backend::openmp:
+#ifdef CPPCOLORMAP_USE_OPENMP
+        return true;
+#else
+        return false;
+#endif
+    case parallel_backend::tbb_arena:
+#ifdef CPPCOLORMAP_USE_TBB
+        return true;
+#else
+        return false;
+#endif
+    case parallel_backend::callback:
+        return static_cast<bool>(detail::parallel().callback());
     }
+    return false;
+}
 
-    return out / 255.0;
+/**
+ * Select the parallel backend used by all kernels of this library.
+ * The default is parallel_backend::thread_pool, or parallel_backend::tbb_arena /
+ * parallel_backend::openmp / parallel_backend::serial if ``CPPCOLORMAP_USE_TBB`` /
+ * ``CPPCOLORMAP_USE_OPENMP`` / ``CPPCOLORMAP_USE_SERIAL`` is defined.
+ * Kernels that are running finish on the backend with which they started.
+ *
+ * @param backend Parallel backend.
+ * @throw std::runtime_error if the backend is not available, see cppcolormap::has_parallel_backend.
+ */
+inline void set_parallel_backend(parallel_backend backend)
+{
+    if (!has_parallel_backend(backend)) {
+        throw std::runtime_error("Parallel backend not available");
+    }
+    detail::parallel().backend = backend;
 }
 
 /**
- * Convert HEX -> RGB.
+ * Parallel backend, see cppcolormap::set_parallel_backend.
  *
- * @param arg HEX data.
- * @returns RGB data.
+ * @return Parallel backend.
  */
-array_type::tensor<double, 1> hex2rgb(const std::string& arg)
+inline parallel_backend get_parallel_backend()
 {
-    return detail::hex2rgb(arg) / 255.0;
+    return detail::parallel().backend;
 }
 
 /**
- * Interpolate the individual colours.
+ * Run all parallel loops of this library through a user-supplied function
+ * (e.g. to schedule them on an existing task system), and select parallel_backend::callback.
+ * The function is called with the number of items, the grain size, and the function to call
+ * on each block, see cppcolormap::parallel_callback.
  *
- * @param arg RGB data.
- * @param N Number of colors to output.
- * @returns RGB data.
+ * @param func Parallel loop (an empty function restores the default backend).
  */
-template <class T, class R = array_type::tensor<double, 2>>
-inline R interp(const T& arg, size_t N)
+inline void set_parallel_callback(parallel_callback func)
 {
-    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
-    using size_type = typename T::shape_type::value_type;
-    size_type n = static_cast<size_type>(N);
-    size_type m = static_cast<size_type>(arg.shape(1));
+    auto& config = detail::parallel();
+    std::lock_guard<std::mutex> lock(config.mutex);
+    config.func = std::move(func);
+    config.backend = config.func ? parallel_backend::callback : detail::default_parallel_backend();
+}
 
-    if (n == arg.shape(0)) {
-        return arg;
+namespace detail {
+
+/**
+ * Non-owning reference to a function `void(size_t begin, size_t end)`.
+ */
+class range_func {
+public:
+    template <class F>
+    explicit range_func(const F& func)
+        : m_obj(&func), m_call([](const void* obj, size_t begin, size_t end) {
+              (*static_cast<const F*>(obj))(begin, end);
+          })
+    {
     }
 
-    R ret = xt::empty<typename R::value_type>({n, m});
+    void operator()(size_t begin, size_t end) const
+    {
+        m_call(m_obj, begin, end);
+    }
 
-    array_type::tensor<double, 1> x = xt::linspace(0.0, 1.0, arg.shape(0));
-    array_type::tensor<double, 1> xi = xt::linspace(0.0, 1.0, n);
+private:
+    const void* m_obj;
+    void (*m_call)(const void*, size_t, size_t);
+};
 
-    for (size_t j = 0; j < arg.shape(1); j++) {
-        auto c = xt::view(arg, xt::all(), j);
-        auto ci = xt::view(ret, xt::all(), j);
-        ci = xt::interp(xi, x, c);
+/**
+ * Persistent pool of threads that claim blocks of `grain` items of a loop in increasing order
+ * (from a shared counter, such that the load is balanced).
+ * Only one loop runs at a time:
+ * a loop started while another loop runs (or from within a loop) runs on the calling thread.
+ */
+class worker_pool {
+public:
+    static worker_pool& instance()
+    {
+        static worker_pool ret;
+        return ret;
     }
 
-    return ret;
-}
+    worker_pool() = default;
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
 
-namespace detail {
+    ~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
 
-template <class D, class C, typename V, class R>
-inline void as_colors_func(const D& data, const C& colors, V vmin, V vmax, R& ret)
-{
-    CPPCOLORMAP_ASSERT(vmax > vmin);
-    CPPCOLORMAP_ASSERT(colors.shape(0) > 0);
-    CPPCOLORMAP_ASSERT(colors.dimension() == 2);
+    /**
+     * @param n Number of items.
+     * @param grain Number of items per block.
+     * @param nthreads Number of threads (including the calling thread).
+     * @param func Function `void(size_t begin, size_t end)`.
+     */
+    void run(size_t n, size_t grain, size_t nthreads, range_func func)
+    {
+        if (in_worker() || !m_busy.try_lock()) {
+            func(0, n);
+            return;
+        }
 
-    auto d = xt::eval((data - vmin) / (vmax - vmin));
-    d = xt::where(data < vmin, 0, d);
-    d = xt::where(data > vmax, 1, d);
-    auto index = xt::eval(xt::cast<size_t>(d * (colors.shape(0) - 1)));
-    size_t stride = colors.shape(1);
+        std::lock_guard<std::mutex> busy(m_busy, std::adopt_lock);
+
+        while (m_threads.size() < nthreads - 1) {
+            size_t index = m_threads.size();
+            m_threads.emplace_back([this, index]() { loop(index); });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_func = &func;
+            m_n = n;
+            m_grain = grain;
+            m_next.store(0, std::memory_order_relaxed);
+            m_helpers = nthreads - 1;
+            m_running = nthreads - 1;
+            m_error = nullptr;
+            ++m_generation;
+        }
+
+        m_wake.notify_all();
+        work();
 
-    for (size_t i = 0; i < data.size(); ++i) {
-        size_t j = index.flat(i);
-        std::copy(&colors.flat(j * stride), &colors.flat((j + 1) * stride), &ret.flat(i * stride));
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_running == 0; });
+
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
     }
-}
 
-template <class E, typename = void>
-struct as_colors_impl {
-    template <class C, typename S>
-    static xt::xarray<typename C::value_type> run(const E& data, const C& colors, S vmin, S vmax)
+private:
+    static bool& in_worker()
     {
-        size_t N = data.dimension();
-        std::vector<size_t> shape(N + 1);
-        std::copy(data.shape().cbegin(), data.shape().cend(), shape.begin());
-        shape[N] = colors.shape(1);
-        xt::xarray<typename C::value_type> ret(shape);
-        as_colors_func(data, colors, vmin, vmax, ret);
+        static thread_local bool ret = false;
         return ret;
     }
-};
 
-template <class E>
-struct as_colors_impl<E, typename xt::has_fixed_rank_t<E>> {
-    using value_type = typename E::value_type;
-    constexpr static size_t N = xt::get_rank<E>::value;
+    void loop(size_t index)
+    {
+        in_worker() = true;
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
 
-    template <class C, typename S>
-    static array_type::tensor<typename C::value_type, N + 1>
-    run(const E& data, const C& colors, S vmin, S vmax)
+        while (true) {
+            m_wake.wait(lock, [&]() { return m_stop || m_generation != seen; });
+
+            if (m_stop) {
+                return;
+            }
+
+            seen = m_generation;
+
+            if (index >= m_helpers) {
+                continue;
+            }
+
+            lock.unlock();
+            work();
+            lock.lock();
+
+            if (--m_running == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    void work()
     {
-        std::array<size_t, N + 1> shape;
-        std::copy(data.shape().cbegin(), data.shape().cend(), shape.begin());
-        shape[N] = colors.shape(1);
-        array_type::tensor<typename C::value_type, N + 1> ret(shape);
-        as_colors_func(data, colors, vmin, vmax, ret);
-        return ret;
+        size_t begin;
+
+        while ((begin = m_next.fetch_add(m_grain, std::memory_order_relaxed)) < m_n) {
+            try {
+                (*m_func)(begin, std::min(begin + m_grain, m_n));
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) {
+                    m_error = std::current_exception();
+                }
+                m_next.store(m_n, std::memory_order_relaxed);
+            }
+        }
     }
+
+    std::mutex m_busy;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::vector<std::thread> m_threads;
+    bool m_stop = false;
+    size_t m_generation = 0;
+    const range_func* m_func = nullptr;
+    size_t m_n = 0;
+    size_t m_grain = 1;
+    std::atomic<size_t> m_next{0};
+    size_t m_helpers = 0;
+    size_t m_running = 0;
+    std::exception_ptr m_error;
 };
-} // namespace detail
 
+#ifdef CPPCOLORMAP_USE_TBB
 /**
- * Convert data to colors using a colormap.
- *
- * @param data The data.
- * @param colors The colormap, e.g. ``cppcolormap::jet()``.
- * @param vmin The lower limit of the color-axis.
- * @param vmax The upper limit of the color-axis.
+ * Arena limited to cppcolormap::get_num_threads.
+ * Shared: an arena that is replaced (after cppcolormap::set_num_threads) stays alive
+ * until the last thread executing in it is done.
  */
-template <class E, class C, typename S>
-inline auto as_colors(const E& data, const C& colors, S vmin, S vmax)
+inline std::shared_ptr<::tbb::task_arena> tbb_arena_instance()
 {
-    return detail::as_colors_impl<E>::run(data, colors, vmin, vmax);
-}
+    static std::mutex mutex;
+    static std::shared_ptr<::tbb::task_arena> arena;
+    std::lock_guard<std::mutex> lock(mutex);
+    int n = static_cast<int>(get_num_threads());
 
-/**
+    if (!arena || arena->max_concurrency() != n) {
+        arena = std::make_shared<::tbb::task_arena>(n);
+    }
+
+    return arena;
+}
+#endif
+
+/**
+ * Number of blocks (threads) used by cppcolormap::detail::parallel_for.
+ *
+ * @param n Number of items.
+ * @param grain Minimal number of items per block.
+ * @return Number of blocks.
+ */
+inline size_t parallel_blocks(size_t n, size_t grain)
+{
+    if (parallel().backend == parallel_backend::serial) {
+        return 1;
+    }
+
+    return std::max(
+        std::min(get_num_threads(), (n + grain - 1) / std::max(grain, size_t(1))), size_t(1)
+    );
+}
+
+/**
+ * Check if the parallel backend starts blocks in increasing order, each on a running thread,
+ * such that a block may wait for a preceding block (see cppcolormap::dither_floyd_steinberg).
+ *
+ * @return Boolean.
+ */
+inline bool parallel_ordered()
+{
+    parallel_backend backend = parallel().backend;
+    return backend == parallel_backend::serial || backend == parallel_backend::thread_pool ||
+           backend == parallel_backend::openmp;
+}
+
+/**
+ * Call `func(begin, end)` on contiguous blocks of about `grain` items that cover `[0, n)`,
+ * using the parallel backend (see cppcolormap::set_parallel_backend),
+ * if `n` is large enough (otherwise `func(0, n)` is called on the calling thread).
+ *
+ * @param n Number of items.
+ * @param grain Minimal number of items per block.
+ * @param func Function `void(size_t begin, size_t end)`.
+ */
+template <class F>
+inline void parallel_for(size_t n, size_t grain, const F& func)
+{
+    grain = std::max(grain, size_t(1));
+    size_t nthreads = parallel_blocks(n, grain);
+
+    if (nthreads <= 1) {
+        func(size_t(0), n);
+        return;
+    }
+
+    switch (parallel().backend.load()) {
+    case parallel_backend::serial:
+        func(size_t(0), n);
+        return;
+    case parallel_backend::thread_pool:
+        worker_pool::instance().run(n, grain, nthreads, range_func(func));
+        return;
+    case parallel_backend::openmp: {
+#ifdef CPPCOLORMAP_USE_OPENMP
+        long long nblock = static_cast<long long>((n + grain - 1) / grain);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(static_cast<int>(nthreads))
+        for (long long b = 0; b < nblock; ++b) {
+            size_t begin = static_cast<size_t>(b) * grain;
+            func(begin, std::min(begin + grain, n));
+        }
+#else
+        func(size_t(0), n);
+#endif
+        return;
+    }
+    case parallel_backend::tbb_arena: {
+#ifdef CPPCOLORMAP_USE_TBB
+        // hold a reference: the arena may be replaced by another thread (set_num_threads)
+        std::shared_ptr<::tbb::task_arena> arena = tbb_arena_instance();
+        arena->execute([&]() {
+            ::tbb::parallel_for(
+                ::tbb::blocked_range<size_t>(0, n, grain),
+                [&](const ::tbb::blocked_range<size_t>& r) { func(r.begin(), r.end()); }
+            );
+        });
+#else
+        func(size_t(0), n);
+#endif
+        return;
+    }
+    case parallel_backend::callback: {
+        // copy: the callback may be replaced (or reset) by another thread
+        parallel_callback loop = parallel().callback();
+        if (loop) {
+            loop(n, grain, [&](size_t begin, size_t end) { func(begin, end); });
+        }
+        else {
+            func(size_t(0), n);
+        }
+        return;
+    }
+    }
+}
+
+} // namespace detail
+
+/**
+ * Statistics of one function, see cppcolormap::stats.
+ */
+struct StatsEntry {
+    size_t calls = 0; ///< Number of calls.
+    size_t elements = 0; ///< Number of elements processed (data-points, or colours).
+    size_t bytes = 0; ///< Number of bytes allocated (output and temporaries).
+    double seconds = 0.0; ///< Total wall time [s].
+    size_t threads = 0; ///< Largest number of threads used by one call.
+};
+
+/**
+ * Snapshot of the statistics of the hot paths, see cppcolormap::stats.
+ */
+struct Stats {
+    StatsEntry as_colors; ///< cppcolormap::as_colors
+    StatsEntry match; ///< cppcolormap::match
+    StatsEntry interp; ///< cppcolormap::interp
+    StatsEntry colormap; ///< Colormap construction by cppcolormap::colormap
+};
+
+namespace detail {
+
+/**
+ * Thread-safe counters of one function.
+ */
+struct stats_counter {
+    std::atomic<size_t> calls{0};
+    std::atomic<size_t> elements{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<int64_t> nanoseconds{0};
+    std::atomic<size_t> threads{0};
+
+    StatsEntry snapshot() const
+    {
+        StatsEntry ret;
+        ret.calls = calls.load(std::memory_order_relaxed);
+        ret.elements = elements.load(std::memory_order_relaxed);
+        ret.bytes = bytes.load(std::memory_order_relaxed);
+        ret.seconds = 1e-9 * static_cast<double>(nanoseconds.load(std::memory_order_relaxed));
+        ret.threads = threads.load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    void reset()
+    {
+        calls.store(0, std::memory_order_relaxed);
+        elements.store(0, std::memory_order_relaxed);
+        bytes.store(0, std::memory_order_relaxed);
+        nanoseconds.store(0, std::memory_order_relaxed);
+        threads.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct stats_registry {
+    stats_counter as_colors;
+    stats_counter match;
+    stats_counter interp;
+    stats_counter colormap;
+};
+
+inline stats_registry& stats_counters()
+{
+    static stats_registry ret;
+    return ret;
+}
+
+/**
+ * Record one call: the wall time between construction and destruction,
+ * and the counts passed to count().
+ */
+class stats_scope {
+public:
+    explicit stats_scope(stats_counter& counter)
+        : m_counter(counter), m_tic(std::chrono::steady_clock::now())
+    {
+    }
+
+    stats_scope(const stats_scope&) = delete;
+    stats_scope& operator=(const stats_scope&) = delete;
+
+    void count(size_t elements, size_t bytes, size_t threads)
+    {
+        m_elements += elements;
+        m_bytes += bytes;
+        m_threads = std::max(m_threads, threads);
+    }
+
+    ~stats_scope()
+    {
+        auto dt = std::chrono::steady_clock::now() - m_tic;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count();
+        m_counter.calls.fetch_add(1, std::memory_order_relaxed);
+        m_counter.elements.fetch_add(m_elements, std::memory_order_relaxed);
+        m_counter.bytes.fetch_add(m_bytes, std::memory_order_relaxed);
+        m_counter.nanoseconds.fetch_add(static_cast<int64_t>(ns), std::memory_order_relaxed);
+
+        size_t t = m_counter.threads.load(std::memory_order_relaxed);
+        while (t < m_threads &&
+               !m_counter.threads.compare_exchange_weak(t, m_threads, std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    stats_counter& m_counter;
+    std::chrono::steady_clock::time_point m_tic;
+    size_t m_elements = 0;
+    size_t m_bytes = 0;
+    size_t m_threads = 1;
+};
+
+} // namespace detail
+
+/**
+ * Check if statistics are recorded (i.e. if ``CPPCOLORMAP_ENABLE_STATS`` is defined).
+ *
+ * @return Boolean.
+ */
+constexpr bool stats_enabled()
+{
+#ifdef CPPCOLORMAP_ENABLE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Snapshot of the statistics recorded since the start (or since cppcolormap::reset_stats).
+ * Statistics are only recorded if ``CPPCOLORMAP_ENABLE_STATS`` is defined
+ * (otherwise all entries are zero).
+ *
+ * @return Statistics.
+ */
+inline Stats stats()
+{
+    auto& c = detail::stats_counters();
+    Stats ret;
+    ret.as_colors = c.as_colors.snapshot();
+    ret.match = c.match.snapshot();
+    ret.interp = c.interp.snapshot();
+    ret.colormap = c.colormap.snapshot();
+    return ret;
+}
+
+/**
+ * Reset the statistics, see cppcolormap::stats.
+ */
+inline void reset_stats()
+{
+    auto& c = detail::stats_counters();
+    c.as_colors.reset();
+    c.match.reset();
+    c.interp.reset();
+    c.colormap.reset();
+}
+
+namespace detail {
+
+/**
+ * Lower-case hexadecimal representation of all bytes: "00", "01", ..., "ff".
+ */
+inline const std::array<char, 512>& hex_bytes()
+{
+    static const std::array<char, 512> table = [] {
+        const char* digits = "0123456789abcdef";
+        std::array<char, 512> ret{};
+        for (size_t i = 0; i < 256; ++i) {
+            ret[2 * i] = digits[i >> 4];
+            ret[2 * i + 1] = digits[i & 0xF];
+        }
+        return ret;
+    }();
+    return table;
+}
+
+/**
+ * Write the two hexadecimal digits of a byte.
+ *
+ * @param value Byte.
+ * @param out Output (two characters are written).
+ */
+inline void write_hex(size_t value, char* out)
+{
+    const char* t = hex_bytes().data() + 2 * value;
+    out[0] = t[0];
+    out[1] = t[1];
+}
+
+/**
+ * Colour component [0..1] -> [0..255].
+ * Values are truncated (not rounded), values outside [0..1] are clipped.
+ */
+inline size_t hex_channel(double value)
+{
+    if (!(value > 0.0)) {
+        return 0;
+    }
+    if (value >= 1.0) {
+        return 255;
+    }
+    return static_cast<size_t>(value * 255.0);
+}
+
+inline size_t hex_channel(uint8_t value)
+{
+    return value;
+}
+
+/**
+ * Write `n` colours as `#rrggbb` (`ncol == 3`) or `#rrggbbaa` (`ncol == 4`).
+ *
+ * @param data Colours, row-major [n, ncol].
+ * @param n Number of colours.
+ * @param ncol Number of components per colour.
+ * @param out Output, `n * (2 * ncol + 1)` characters, not null-terminated.
+ */
+template <typename T>
+inline void rgb2hex_kernel(const T* data, size_t n, size_t ncol, char* out)
+{
+    size_t width = 2 * ncol + 1;
+
+    for (size_t i = 0; i < n; ++i) {
+        char* o = out + i * width;
+        o[0] = '#';
+        for (size_t k = 0; k < ncol; ++k) {
+            write_hex(hex_channel(data[i * ncol + k]), o + 1 + 2 * k);
+        }
+    }
+}
+
+/**
+ * @param r Red [0..255].
+ * @param g Green [0..255].
+ * @param b Blue [0..255].
+ * @return Hex string.
+ */
+inline std::string rgb2hex(size_t r, size_t g, size_t b)
+{
+    std::string ret(7, '#');
+    write_hex(r, &ret[1]);
+    write_hex(g, &ret[3]);
+    write_hex(b, &ret[5]);
+    return ret;
+}
+
+/**
+ * Value of a hexadecimal digit.
+ *
+ * @param c Character.
+ * @return Value [0..15], or -1 if `c` is not a hexadecimal digit.
+ */
+inline int hex_value(char c)
+{
+    static const std::array<signed char, 256> table = [] {
+        std::array<signed char, 256> ret{};
+        ret.fill(-1);
+        for (int i = 0; i < 10; ++i) {
+            ret['0' + i] = static_cast<signed char>(i);
+        }
+        for (int i = 0; i < 6; ++i) {
+            ret['a' + i] = static_cast<signed char>(10 + i);
+            ret['A' + i] = static_cast<signed char>(10 + i);
+        }
+        return ret;
+    }();
+    return table[static_cast<unsigned char>(c)];
+}
+
+/**
+ * Parse a hex colour: `#rgb`, `#rrggbb`, or `#rrggbbaa` (the `#` is optional).
+ *
+ * @param hex Hex string.
+ * @param out Output, `ncol` components [0..1] (the alpha is 1 if not specified).
+ * @param ncol Number of components to write: 3 (RGB) or 4 (RGBA).
+ * @return `false` if `hex` is not a valid colour (`out` is then not written).
+ */
+inline bool parse_hex(string_view hex, double* out, size_t ncol)
+{
+    if (!hex.empty() && hex[0] == '#') {
+        hex.remove_prefix(1);
+    }
+
+    int v[4] = {0, 0, 0, 255};
+
+    if (hex.size() == 3) {
+        for (size_t k = 0; k < 3; ++k) {
+            int h = hex_value(hex[k]);
+            if (h < 0) {
+                return false;
+            }
+            v[k] = h * 17;
+        }
+    }
+    else if (hex.size() == 6 || hex.size() == 8) {
+        for (size_t k = 0; k < hex.size() / 2; ++k) {
+            int h = hex_value(hex[2 * k]);
+            int l = hex_value(hex[2 * k + 1]);
+            if (h < 0 || l < 0) {
+                return false;
+            }
+            v[k] = h * 16 + l;
+        }
+    }
+    else {
+        return false;
+    }
+
+    for (size_t k = 0; k < ncol; ++k) {
+        out[k] = static_cast<double>(v[k]) / 255.0;
+    }
+
+    return true;
+}
+
+/**
+ * Parse `n` hex colours in parallel, see detail::parse_hex.
+ *
+ * @param get Function `string_view(size_t i)` returning colour `i`.
+ * @param n Number of colours.
+ * @param out Output, row-major [n, ncol].
+ * @param ncol Number of components to write: 3 (RGB) or 4 (RGBA).
+ * @throw std::runtime_error, listing the (first) invalid colour and its index.
+ */
+template <class F>
+inline void parse_hex(const F& get, size_t n, double* out, size_t ncol)
+{
+    std::atomic<size_t> bad(n);
+
+    parallel_for(n, get_parallel_grain() / 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!parse_hex(get(i), out + i * ncol, ncol)) {
+                size_t b = bad.load();
+                while (i < b && !bad.compare_exchange_weak(b, i)) {
+                }
+                return;
+            }
+        }
+    });
+
+    if (bad < n) {
+        throw std::runtime_error(
+            "Invalid hex colour \"" + std::string(get(bad)) + "\" at index " +
+            std::to_string(bad.load())
+        );
+    }
+}
+
+} // namespace detail
+
+/**
+ * Fixed-width hex colours (`#rrggbb` or `#rrggbbaa`) stored in one contiguous buffer,
+ * see cppcolormap::rgb2hex_array.
+ */
+class HexArray {
+public:
+    HexArray() = default;
+
+    /**
+     * @param n Number of colours.
+     * @param width Number of characters per colour (7 for `#rrggbb`, 9 for `#rrggbbaa`).
+     */
+    HexArray(size_t n, size_t width) : m_size(n), m_width(width), m_data(n * width)
+    {
+    }
+
+    /**
+     * Number of colours.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Number of characters per colour.
+     */
+    size_t width() const
+    {
+        return m_width;
+    }
+
+    /**
+     * Colour `i` (view on the buffer, no allocation).
+     */
+    string_view operator[](size_t i) const
+    {
+        return string_view(m_data.data() + i * m_width, m_width);
+    }
+
+    /**
+     * Buffer: `size() * width()` characters, without separators or null-termination.
+     */
+    const char* data() const
+    {
+        return m_data.data();
+    }
+
+    /**
+     * Buffer: `size() * width()` characters, without separators or null-termination.
+     */
+    char* data()
+    {
+        return m_data.data();
+    }
+
+private:
+    size_t m_size = 0;
+    size_t m_width = 7;
+    std::vector<char> m_data;
+};
+
+/**
+ * Convert RGB(A) -> HEX, writing to a contiguous buffer.
+ *
+ * @param arg RGB data [N, 3] or RGBA data [N, 4], values between 0 and 1 (or `uint8_t`).
+ * @param out Output: `N * 7` (RGB) or `N * 9` (RGBA) characters, not null-terminated.
+ */
+template <class T>
+inline void rgb2hex_write(const T& arg, char* out)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    CPPCOLORMAP_ASSERT(arg.shape(1) == 3 || arg.shape(1) == 4);
+
+    size_t n = arg.shape(0);
+    size_t ncol = arg.shape(1);
+    size_t width = 2 * ncol + 1;
+
+    detail::with_row_major(arg, [&](const auto* pd) {
+        detail::parallel_for(n, get_parallel_grain(), [&](size_t begin, size_t end) {
+            detail::rgb2hex_kernel(pd + begin * ncol, end - begin, ncol, out + begin * width);
+        });
+    });
+}
+
+/**
+ * Convert RGB(A) -> HEX, as fixed-width `#rrggbb` (or `#rrggbbaa`) strings in one buffer.
+ *
+ * @param arg RGB data [N, 3] or RGBA data [N, 4], values between 0 and 1 (or `uint8_t`).
+ * @returns Hex colours.
+ */
+template <class T>
+inline HexArray rgb2hex_array(const T& arg)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    CPPCOLORMAP_ASSERT(arg.shape(1) == 3 || arg.shape(1) == 4);
+
+    HexArray ret(arg.shape(0), 2 * arg.shape(1) + 1);
+    rgb2hex_write(arg, ret.data());
+    return ret;
+}
+
+/**
+ * Convert RGB -> HEX.
+ *
+ * @param arg RGB data (values between 0 and 1).
+ * @returns Vector of strings.
+ */
+template <class T, typename std::enable_if_t<xt::get_rank<T>::value != 1, int> = 0>
+inline std::vector<std::string> rgb2hex(const T& arg)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    CPPCOLORMAP_ASSERT(arg.shape(1) == 3);
+    CPPCOLORMAP_ASSERT(xt::all(arg >= 0.0 && arg <= 1.0));
+
+    HexArray hex = rgb2hex_array(arg);
+    std::vector<std::string> ret;
+    ret.reserve(hex.size());
+
+    for (size_t i = 0; i < hex.size(); ++i) {
+        ret.emplace_back(hex[i]);
+    }
+
+    return ret;
+}
+
+/**
+ * Convert RGB -> HEX.
+ *
+ * @param arg RGB data (values between 0 and 1).
+ * @returns String.
+ */
+template <class T, typename std::enable_if_t<xt::get_rank<T>::value == 1, int> = 0>
+inline std::string rgb2hex(const T& arg)
+{
+    CPPCOLORMAP_ASSERT(arg.size() == 3);
+    CPPCOLORMAP_ASSERT(xt::all(arg >= 0.0 && arg <= 1.0));
+
+    return detail::rgb2hex(
+        detail::hex_channel(static_cast<double>(arg(0))),
+        detail::hex_channel(static_cast<double>(arg(1))),
+        detail::hex_channel(static_cast<double>(arg(2)))
+    );
+}
+
+/**
+ * Convert HEX -> RGB(A), writing to a contiguous buffer.
+ * Colours are specified as `#rgb`, `#rrggbb`, or `#rrggbbaa` (the `#` is optional).
+ *
+ * The colours are parsed in parallel, in place: `first` must be a random-access iterator
+ * to stored colours (e.g. of a `std::vector`), not to temporaries.
+ *
+ * @param first Iterator to the first colour (anything convertible to cppcolormap::string_view).
+ * @param last Iterator to the end.
+ * @param out Output, row-major [N, ncol].
+ * @param ncol Number of components to write: 3 (RGB; any alpha is ignored) or 4 (RGBA).
+ * @throw std::runtime_error, listing the (first) invalid colour and its index.
+ */
+template <class It>
+inline void hex2rgb_write(It first, It last, double* out, size_t ncol = 3)
+{
+    using traits = std::iterator_traits<It>;
+    static_assert(
+        std::is_base_of<std::random_access_iterator_tag, typename traits::iterator_category>::value,
+        "hex2rgb_write requires random-access iterators"
+    );
+    static_assert(
+        std::is_lvalue_reference<typename traits::reference>::value,
+        "hex2rgb_write requires iterators to stored colours (not to temporaries)"
+    );
+    CPPCOLORMAP_ASSERT(ncol == 3 || ncol == 4);
+    size_t n = static_cast<size_t>(last - first);
+    using diff = typename traits::difference_type;
+    auto get = [&](size_t i) { return string_view(first[static_cast<diff>(i)]); };
+    detail::parse_hex(get, n, out, ncol);
+}
+
+/**
+ * Convert HEX -> RGB(A).
+ * Colours are specified as `#rgb`, `#rrggbb`, or `#rrggbbaa` (the `#` is optional).
+ * See cppcolormap::hex2rgb_write for the requirements on the iterators.
+ *
+ * @param first Iterator to the first colour (anything convertible to cppcolormap::string_view).
+ * @param last Iterator to the end.
+ * @param ncol Number of components: 3 (RGB; any alpha is ignored) or 4 (RGBA).
+ * @returns RGB(A) data [N, ncol].
+ * @throw std::runtime_error, listing the (first) invalid colour and its index.
+ */
+template <class It>
+inline array_type::tensor<double, 2> hex2rgb(It first, It last, size_t ncol = 3)
+{
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    array_type::tensor<double, 2> out = xt::empty<double>({n, ncol});
+    hex2rgb_write(first, last, out.data(), ncol);
+    return out;
+}
+
+/**
+ * Convert HEX -> RGB.
+ *
+ * @param arg HEX data.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> hex2rgb(const std::vector<std::string>& arg)
+{
+    return hex2rgb(arg.cbegin(), arg.cend(), 3);
+}
+
+/**
+ * Convert HEX -> RGBA.
+ * The alpha is 1 for colours specified without alpha.
+ *
+ * @param arg HEX data.
+ * @returns RGBA data.
+ */
+inline array_type::tensor<double, 2> hex2rgba(const std::vector<std::string>& arg)
+{
+    return hex2rgb(arg.cbegin(), arg.cend(), 4);
+}
+
+/**
+ * Convert HEX -> RGB(A).
+ *
+ * @param arg HEX data, e.g. from cppcolormap::rgb2hex_array.
+ * @returns RGB data [N, 3] (or RGBA data [N, 4] if `arg` has alpha).
+ */
+inline array_type::tensor<double, 2> hex2rgb(const HexArray& arg)
+{
+    size_t ncol = arg.width() == 9 ? 4 : 3;
+    array_type::tensor<double, 2> out = xt::empty<double>({arg.size(), ncol});
+    detail::parse_hex([&](size_t i) { return arg[i]; }, arg.size(), out.data(), ncol);
+    return out;
+}
+
+/**
+ * Convert HEX -> RGB.
+ *
+ * @param arg HEX data.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 1> hex2rgb(string_view arg)
+{
+    array_type::tensor<double, 1> out = xt::empty<double>({size_t(3)});
+
+    if (!detail::parse_hex(arg, out.data(), 3)) {
+        throw std::runtime_error("Invalid hex colour \"" + std::string(arg) + "\"");
+    }
+
+    return out;
+}
+
+/**
+ * Colour spaces, see cppcolormap::convert.
+ * All colormaps in this library are specified in sRGB.
+ */
+enum colorspace {
+    sRGB, ///< Gamma encoded sRGB (D65), components in [0, 1].
+    linear_RGB, ///< Linear-light RGB with sRGB primaries, components in [0, 1].
+    XYZ, ///< CIE 1931 XYZ (D65 white point, Y in [0, 1]).
+    CIELAB, ///< CIE L*a*b* (D65 white point, L* in [0, 100]).
+    Oklab, ///< Oklab. See: https://bottosson.github.io/posts/oklab
+    HSV, ///< Hue, saturation, value, all in [0, 1].
+    HSL ///< Hue, saturation, lightness, all in [0, 1].
+};
+
+namespace detail {
+
+/**
+ * sRGB transfer function (decode), odd extension for out-of-gamut (negative) components.
+ *
+ * @param c Gamma encoded component.
+ * @return Linear component.
+ */
+inline double srgb_to_linear(double c)
+{
+    double a = std::abs(c);
+    double l = a <= 0.04045 ? a / 12.92 : std::pow((a + 0.055) / 1.055, 2.4);
+    return std::copysign(l, c);
+}
+
+/**
+ * Inverse sRGB transfer function (encode), odd extension for out-of-gamut (negative) components.
+ *
+ * @param l Linear component.
+ * @return Gamma encoded component.
+ */
+inline double linear_to_srgb(double l)
+{
+    double a = std::abs(l);
+    double c = a <= 0.0031308 ? 12.92 * a : 1.055 * std::pow(a, 1.0 / 2.4) - 0.055;
+    return std::copysign(c, l);
+}
+
+/**
+ * Lookup-table: 8-bit sRGB code value -> linear component.
+ *
+ * @return Reference to static table.
+ */
+inline const std::array<double, 256>& srgb8_to_linear_table()
+{
+    static const std::array<double, 256> table = [] {
+        std::array<double, 256> ret;
+        for (size_t i = 0; i < 256; ++i) {
+            ret[i] = srgb_to_linear(static_cast<double>(i) / 255.0);
+        }
+        return ret;
+    }();
+    return table;
+}
+
+/**
+ * Lookup-table: linear component at the decision boundary between 8-bit sRGB code values
+ * `i` and `i + 1`.
+ * Encoding by searching this table is exact, and avoids evaluating `std::pow`.
+ *
+ * @return Reference to static table.
+ */
+inline const std::array<double, 255>& srgb8_threshold_table()
+{
+    static const std::array<double, 255> table = [] {
+        std::array<double, 255> ret;
+        for (size_t i = 0; i < 255; ++i) {
+            ret[i] = srgb_to_linear((static_cast<double>(i) + 0.5) / 255.0);
+        }
+        return ret;
+    }();
+    return table;
+}
+
+/**
+ * Encode a linear component as 8-bit sRGB code value (rounded to nearest, clipped to [0, 255]).
+ *
+ * @param l Linear component.
+ * @return Code value.
+ */
+inline uint8_t linear_to_srgb8(double l)
+{
+    const auto& t = srgb8_threshold_table();
+    return static_cast<uint8_t>(std::upper_bound(t.cbegin(), t.cend(), l) - t.cbegin());
+}
+
+/**
+ * Quantise a gamma encoded component as 8-bit code value (rounded to nearest, clipped to [0, 255]).
+ *
+ * @param c Gamma encoded component.
+ * @return Code value.
+ */
+inline uint8_t srgb_to_srgb8(double c)
+{
+    double v = c * 255.0 + 0.5;
+    if (!(v > 0.0)) {
+        return 0;
+    }
+    if (v >= 255.0) {
+        return 255;
+    }
+    return static_cast<uint8_t>(v);
+}
+
+/*
+ * Batch kernels below operate in-place on `n` colours stored as contiguous (row-major) triplets.
+ * They are plain loops without cross-iteration dependencies, such that they can be vectorised.
+ */
+
+inline void srgb_to_linear(double* x, size_t n)
+{
+    for (size_t i = 0; i < 3 * n; ++i) {
+        x[i] = srgb_to_linear(x[i]);
+    }
+}
+
+inline void linear_to_srgb(double* x, size_t n)
+{
+    for (size_t i = 0; i < 3 * n; ++i) {
+        x[i] = linear_to_srgb(x[i]);
+    }
+}
+
+// Derived from the sRGB primaries and D65 white point (x = 0.3127, y = 0.3290), see:
+// http://www.brucelindbloom.com/index.html?Eqn_RGB_XYZ_Matrix.html
+inline void linear_to_xyz(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double r = c[0];
+        double g = c[1];
+        double b = c[2];
+        c[0] = 0.4123907992659595 * r + 0.357584339383878 * g + 0.1804807884018343 * b;
+        c[1] = 0.2126390058715104 * r + 0.7151686787677559 * g + 0.07219231536073371 * b;
+        c[2] = 0.01933081871559185 * r + 0.119194779794626 * g + 0.9505321522496606 * b;
+    }
+}
+
+inline void xyz_to_linear(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double X = c[0];
+        double Y = c[1];
+        double Z = c[2];
+        c[0] = 3.240969941904521 * X - 1.537383177570093 * Y - 0.4986107602930033 * Z;
+        c[1] = -0.9692436362808798 * X + 1.875967501507721 * Y + 0.04155505740717561 * Z;
+        c[2] = 0.05563007969699361 * X - 0.2039769588889766 * Y + 1.056971514242879 * Z;
+    }
+}
+
+// https://en.wikipedia.org/wiki/CIELAB_color_space
+inline double lab_f(double t)
+{
+    constexpr double delta = 6.0 / 29.0;
+    return t > delta * delta * delta ? std::cbrt(t) : t / (3.0 * delta * delta) + 4.0 / 29.0;
+}
+
+inline double lab_finv(double t)
+{
+    constexpr double delta = 6.0 / 29.0;
+    return t > delta ? t * t * t : 3.0 * delta * delta * (t - 4.0 / 29.0);
+}
+
+inline void xyz_to_lab(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double fx = lab_f(c[0] / 0.9504559270516717);
+        double fy = lab_f(c[1]);
+        double fz = lab_f(c[2] / 1.089057750759878);
+        c[0] = 116.0 * fy - 16.0;
+        c[1] = 500.0 * (fx - fy);
+        c[2] = 200.0 * (fy - fz);
+    }
+}
+
+inline void lab_to_xyz(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double fy = (c[0] + 16.0) / 116.0;
+        double fx = fy + c[1] / 500.0;
+        double fz = fy - c[2] / 200.0;
+        c[0] = 0.9504559270516717 * lab_finv(fx);
+        c[1] = lab_finv(fy);
+        c[2] = 1.089057750759878 * lab_finv(fz);
+    }
+}
+
+// https://bottosson.github.io/posts/oklab
+// (the inverse matrices are the exact inverses of the forward matrices, for lossless round-trips)
+inline void linear_to_oklab(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double l = std::cbrt(0.4122214708 * c[0] + 0.5363325363 * c[1] + 0.0514459929 * c[2]);
+        double m = std::cbrt(0.2119034982 * c[0] + 0.6806995451 * c[1] + 0.1073969566 * c[2]);
+        double s = std::cbrt(0.0883024619 * c[0] + 0.2817188376 * c[1] + 0.6299787005 * c[2]);
+        c[0] = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s;
+        c[1] = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s;
+        c[2] = 0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s;
+    }
+}
+
+inline void oklab_to_linear(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double L = c[0];
+        double A = c[1];
+        double B = c[2];
+        double l = 0.9999999984505199 * L + 0.3963377921737679 * A + 0.2158037580607588 * B;
+        double m = 1.000000008881761 * L - 0.1055613423236563 * A - 0.06385417477170589 * B;
+        double s = 1.000000054672411 * L - 0.08948418209496575 * A - 1.291485537864092 * B;
+        l = l * l * l;
+        m = m * m * m;
+        s = s * s * s;
+        c[0] = 4.076741661347994 * l - 3.307711590408194 * m + 0.2309699287294279 * s;
+        c[1] = -1.268438004092176 * l + 2.609757400663372 * m - 0.3413193963102196 * s;
+        c[2] = -0.004196086541837087 * l - 0.7034186144594495 * m + 1.707614700930945 * s;
+    }
+}
+
+/**
+ * Hue in [0, 1) of an RGB triplet.
+ */
+inline double rgb_hue(double r, double g, double b, double max, double delta)
+{
+    if (delta <= 0.0) {
+        return 0.0;
+    }
+
+    double h;
+
+    if (max == r) {
+        h = (g - b) / delta;
+    }
+    else if (max == g) {
+        h = (b - r) / delta + 2.0;
+    }
+    else {
+        h = (r - g) / delta + 4.0;
+    }
+
+    h /= 6.0;
+
+    return h < 0.0 ? h + 1.0 : h;
+}
+
+/**
+ * RGB triplet from hue in [0, 1), chroma, and offset.
+ */
+inline void hue_to_rgb(double h, double chroma, double m, double* c)
+{
+    double h6 = 6.0 * (h - std::floor(h));
+    double x = chroma * (1.0 - std::abs(std::fmod(h6, 2.0) - 1.0));
+    double r = 0.0;
+    double g = 0.0;
+    double b = 0.0;
+
+    switch (static_cast<int>(h6) % 6) {
+    case 0:
+        r = chroma;
+        g = x;
+        break;
+    case 1:
+        r = x;
+        g = chroma;
+        break;
+    case 2:
+        g = chroma;
+        b = x;
+        break;
+    case 3:
+        g = x;
+        b = chroma;
+        break;
+    case 4:
+        r = x;
+        b = chroma;
+        break;
+    default:
+        r = chroma;
+        b = x;
+        break;
+    }
+
+    c[0] = r + m;
+    c[1] = g + m;
+    c[2] = b + m;
+}
+
+inline void srgb_to_hsv(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double max = std::max({c[0], c[1], c[2]});
+        double delta = max - std::min({c[0], c[1], c[2]});
+        double h = rgb_hue(c[0], c[1], c[2], max, delta);
+        c[0] = h;
+        c[1] = max > 0.0 ? delta / max : 0.0;
+        c[2] = max;
+    }
+}
+
+inline void hsv_to_srgb(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double chroma = c[2] * c[1];
+        hue_to_rgb(c[0], chroma, c[2] - chroma, c);
+    }
+}
+
+inline void srgb_to_hsl(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double max = std::max({c[0], c[1], c[2]});
+        double min = std::min({c[0], c[1], c[2]});
+        double delta = max - min;
+        double l = 0.5 * (max + min);
+        double h = rgb_hue(c[0], c[1], c[2], max, delta);
+        double d = 1.0 - std::abs(2.0 * l - 1.0);
+        c[0] = h;
+        c[1] = d > 0.0 ? delta / d : 0.0;
+        c[2] = l;
+    }
+}
+
+inline void hsl_to_srgb(double* x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        double* c = &x[3 * i];
+        double chroma = (1.0 - std::abs(2.0 * c[2] - 1.0)) * c[1];
+        hue_to_rgb(c[0], chroma, c[2] - 0.5 * chroma, c);
+    }
+}
+
+/**
+ * Convert colours in-place.
+ * Colour spaces are grouped around two hubs: sRGB (HSV, HSL) and linear RGB (XYZ, CIELAB, Oklab).
+ * Conversions only pass through the hub(s) that they need.
+ *
+ * @param x Pointer to `n` contiguous triplets.
+ * @param n Number of colours.
+ * @param from Colour space of the input.
+ * @param to Colour space of the output.
+ */
+inline void convert(double* x, size_t n, colorspace from, colorspace to)
+{
+    if (from == to) {
+        return;
+    }
+
+    switch (from) {
+    case HSV:
+        hsv_to_srgb(x, n);
+        from = sRGB;
+        break;
+    case HSL:
+        hsl_to_srgb(x, n);
+        from = sRGB;
+        break;
+    case XYZ:
+        xyz_to_linear(x, n);
+        from = linear_RGB;
+        break;
+    case CIELAB:
+        lab_to_xyz(x, n);
+        if (to == XYZ) {
+            return;
+        }
+        xyz_to_linear(x, n);
+        from = linear_RGB;
+        break;
+    case Oklab:
+        oklab_to_linear(x, n);
+        from = linear_RGB;
+        break;
+    default:
+        break;
+    }
+
+    bool srgb_group = to == sRGB || to == HSV || to == HSL;
+
+    if (from == sRGB && !srgb_group) {
+        srgb_to_linear(x, n);
+        from = linear_RGB;
+    }
+    else if (from == linear_RGB && srgb_group) {
+        linear_to_srgb(x, n);
+        from = sRGB;
+    }
+
+    switch (to) {
+    case HSV:
+        srgb_to_hsv(x, n);
+        break;
+    case HSL:
+        srgb_to_hsl(x, n);
+        break;
+    case XYZ:
+        linear_to_xyz(x, n);
+        break;
+    case CIELAB:
+        linear_to_xyz(x, n);
+        xyz_to_lab(x, n);
+        break;
+    case Oklab:
+        linear_to_oklab(x, n);
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace detail
+
+/**
+ * Convert colours between colour spaces.
+ *
+ * Packed 8-bit input (`uint8_t`, values in [0, 255]) is supported for `source == sRGB`,
+ * it is decoded using a lookup-table.
+ *
+ * @param arg Colours [N, 3], e.g. a colormap or the output of cppcolormap::as_colors.
+ * @param source Colour space of the input.
+ * @param target Colour space of the output.
+ * @return Colours [N, 3].
+ */
+template <class T>
+inline array_type::tensor<double, 2> convert(const T& arg, colorspace source, colorspace target)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    CPPCOLORMAP_ASSERT(arg.shape(1) == 3);
+
+    size_t n = arg.shape(0);
+    array_type::tensor<double, 2> ret = xt::empty<double>({n, size_t(3)});
+
+    detail::with_row_major(arg, [&](const auto* pa) { std::copy(pa, pa + 3 * n, ret.data()); });
+
+    if (std::is_same<typename T::value_type, uint8_t>::value) {
+        CPPCOLORMAP_ASSERT(source == colorspace::sRGB);
+        bool srgb_group = target == colorspace::sRGB || target == colorspace::HSV ||
+                          target == colorspace::HSL;
+
+        if (srgb_group) {
+            for (size_t i = 0; i < ret.size(); ++i) {
+                ret.flat(i) /= 255.0;
+            }
+        }
+        else {
+            const auto& table = detail::srgb8_to_linear_table();
+            for (size_t i = 0; i < ret.size(); ++i) {
+                ret.flat(i) = table[static_cast<size_t>(ret.flat(i))];
+            }
+            source = colorspace::linear_RGB;
+        }
+    }
+
+    detail::convert(ret.data(), n, source, target);
+    return ret;
+}
+
+/**
+ * Convert colours to packed 8-bit sRGB.
+ * Components are rounded to the nearest code value, out-of-gamut components are clipped.
+ *
+ * @param arg Colours [N, 3].
+ * @param source Colour space of the input.
+ * @return Colours [N, 3], values in [0, 255].
+ */
+template <class T>
+inline array_type::tensor<uint8_t, 2> pack_srgb8(const T& arg, colorspace source = colorspace::sRGB)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    CPPCOLORMAP_ASSERT(arg.shape(1) == 3);
+
+    xt::xtensor<double, 2> c = arg; // row-major copy (also of a strided input)
+    array_type::tensor<uint8_t, 2> ret = xt::empty<uint8_t>({c.shape(0), size_t(3)});
+
+    if (source == colorspace::sRGB || source == colorspace::HSV || source == colorspace::HSL) {
+        detail::convert(c.data(), c.shape(0), source, colorspace::sRGB);
+        for (size_t i = 0; i < c.size(); ++i) {
+            ret.flat(i) = detail::srgb_to_srgb8(c.flat(i));
+        }
+    }
+    else {
+        detail::convert(c.data(), c.shape(0), source, colorspace::linear_RGB);
+        for (size_t i = 0; i < c.size(); ++i) {
+            ret.flat(i) = detail::linear_to_srgb8(c.flat(i));
+        }
+    }
+
+    return ret;
+}
+
+namespace detail {
+
+template <class R, class T>
+inline R interp_func(const T& arg, size_t N)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    using size_type = typename T::shape_type::value_type;
+    size_type n = static_cast<size_type>(N);
+    size_type m = static_cast<size_type>(arg.shape(1));
+
+    if (n == arg.shape(0)) {
+        return arg;
+    }
+
+    R ret = xt::empty<typename R::value_type>({n, m});
+
+    array_type::tensor<double, 1> x = xt::linspace(0.0, 1.0, arg.shape(0));
+    array_type::tensor<double, 1> xi = xt::linspace(0.0, 1.0, n);
+
+    for (size_t j = 0; j < arg.shape(1); j++) {
+        auto c = xt::view(arg, xt::all(), j);
+        auto ci = xt::view(ret, xt::all(), j);
+        ci = xt::interp(xi, x, c);
+    }
+
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * Interpolate the individual colours.
+ *
+ * @param arg RGB data.
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+template <class T, class R = array_type::tensor<double, 2>>
+inline R interp(const T& arg, size_t N)
+{
+    CPPCOLORMAP_STATS_SCOPE(interp);
+    CPPCOLORMAP_STATS_COUNT(N, N * arg.shape(1) * sizeof(typename R::value_type), 1);
+    return detail::interp_func<R>(arg, N);
+}
+
+/**
+ * Interpolate the individual colours in a different colour space.
+ * For example, interpolating in cppcolormap::Oklab gives perceptually smooth transitions.
+ * Note that hue (cppcolormap::HSV and cppcolormap::HSL) is interpolated linearly,
+ * i.e. without wrapping around.
+ *
+ * @param arg RGB data.
+ * @param N Number of colors to output.
+ * @param space Colour space in which to interpolate.
+ * @returns RGB data (clipped to [0, 1]).
+ */
+template <class T>
+inline array_type::tensor<double, 2> interp(const T& arg, size_t N, colorspace space)
+{
+    CPPCOLORMAP_ASSERT(arg.dimension() == 2);
+    CPPCOLORMAP_ASSERT(arg.shape(1) == 3);
+    CPPCOLORMAP_STATS_SCOPE(interp);
+    CPPCOLORMAP_STATS_COUNT(N, (arg.size() + N * 3) * sizeof(double), 1);
+
+    array_type::tensor<double, 2> c = convert(arg, colorspace::sRGB, space);
+    auto ret = detail::interp_func<array_type::tensor<double, 2>>(c, N);
+    detail::convert(ret.data(), ret.shape(0), space, colorspace::sRGB);
+
+    for (size_t i = 0; i < ret.size(); ++i) {
+        ret.flat(i) = std::min(std::max(ret.flat(i), 0.0), 1.0);
+    }
+
+    return ret;
+}
+
+namespace detail {
+
+/**
+ * Map data to the index of a colormap with `N` colours.
+ * Data outside `[vmin, vmax]` is clipped, NaN is mapped to the first colour.
+ */
+class quantiser {
+public:
+    quantiser(double vmin, double vmax, size_t N) : m_vmin(vmin), m_range(vmax - vmin), m_top(N - 1)
+    {
+    }
+
+    template <typename T>
+    size_t operator()(T value) const
+    {
+        double d = (static_cast<double>(value) - m_vmin) / m_range;
+
+        if (!(d > 0.0)) {
+            return 0;
+        }
+        if (d >= 1.0) {
+            return static_cast<size_t>(m_top);
+        }
+
+        return static_cast<size_t>(d * m_top);
+    }
+
+private:
+    double m_vmin;
+    double m_range;
+    double m_top;
+};
+
+/**
+ * Write the colormap index of `n` contiguous data-points.
+ */
+template <typename T, typename I>
+inline void as_indices_kernel(const T* data, size_t n, const quantiser& q, I* out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<I>(q(data[i]));
+    }
+}
+
+/**
+ * Write the colormap index of `n` data-points that are `step` items apart.
+ */
+template <typename T, typename I>
+inline void as_indices_kernel(const T* data, ptrdiff_t step, size_t n, const quantiser& q, I* out)
+{
+    if (step == 1) {
+        as_indices_kernel(data, n, q, out);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<I>(q(data[static_cast<ptrdiff_t>(i) * step]));
+    }
+}
+
+/**
+ * Write the colour of `n` contiguous data-points.
+ * Each colour has `stride` components (the number of columns of the colormap).
+ */
+template <typename T, typename C>
+inline void as_colors_kernel(
+    const T* data,
+    size_t n,
+    const quantiser& q,
+    const C* colors,
+    size_t stride,
+    C* out
+)
+{
+    if (stride == 3) {
+        for (size_t i = 0; i < n; ++i) {
+            const C* c = &colors[3 * q(data[i])];
+            out[3 * i] = c[0];
+            out[3 * i + 1] = c[1];
+            out[3 * i + 2] = c[2];
+        }
+        return;
+    }
+
+    if (stride == 4) {
+        for (size_t i = 0; i < n; ++i) {
+            const C* c = &colors[4 * q(data[i])];
+            out[4 * i] = c[0];
+            out[4 * i + 1] = c[1];
+            out[4 * i + 2] = c[2];
+            out[4 * i + 3] = c[3];
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const C* c = &colors[stride * q(data[i])];
+        std::copy(c, c + stride, &out[stride * i]);
+    }
+}
+
+/**
+ * Write the colour of `n` data-points that are `step` items apart.
+ */
+template <typename T, typename C>
+inline void as_colors_kernel(
+    const T* data,
+    ptrdiff_t step,
+    size_t n,
+    const quantiser& q,
+    const C* colors,
+    size_t stride,
+    C* out
+)
+{
+    if (step == 1) {
+        as_colors_kernel(data, n, q, colors, stride, out);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const C* c = &colors[stride * q(data[static_cast<ptrdiff_t>(i) * step])];
+        std::copy(c, c + stride, &out[stride * i]);
+    }
+}
+
+/**
+ * Visit the items `[begin, end)` (in row-major order) of a strided array,
+ * by calling `func(offset, step, n, i)` for each run of items along the last axis:
+ * `offset` is the position of the first item of the run, `step` the distance between items
+ * (both in units of items), `n` the number of items, and `i` the row-major index of the first item.
+ *
+ * @param shape Shape of the array.
+ * @param strides Strides of the array (in units of items).
+ * @param begin First item.
+ * @param end Last item (exclusive).
+ * @param func Function `void(ptrdiff_t offset, ptrdiff_t step, size_t n, size_t i)`.
+ */
+template <class F>
+inline void strided_runs(
+    const std::vector<size_t>& shape,
+    const std::vector<ptrdiff_t>& strides,
+    size_t begin,
+    size_t end,
+    const F& func
+)
+{
+    size_t ndim = shape.size();
+
+    if (ndim == 0) {
+        if (begin < end) {
+            func(ptrdiff_t(0), ptrdiff_t(1), size_t(1), size_t(0));
+        }
+        return;
+    }
+
+    size_t inner = shape[ndim - 1];
+    ptrdiff_t step = strides[ndim - 1];
+
+    for (size_t i = begin; i < end;) {
+        size_t row = i / inner;
+        size_t col = i % inner;
+        size_t n = std::min(inner - col, end - i);
+        ptrdiff_t offset = static_cast<ptrdiff_t>(col) * step;
+
+        for (size_t d = ndim - 1; d-- > 0;) {
+            offset += static_cast<ptrdiff_t>(row % shape[d]) * strides[d];
+            row /= shape[d];
+        }
+
+        func(offset, step, n, i);
+        i += n;
+    }
+}
+
+/**
+ * Map a strided array to colours, see cppcolormap::as_colors.
+ *
+ * @param data Pointer to the first item of the data.
+ * @param shape Shape of the data.
+ * @param strides Strides of the data (in units of items).
+ * @param q Mapping of data to colour index.
+ * @param colors Colormap (row-major).
+ * @param stride Number of columns of the colormap.
+ * @param out Output, row-major [shape..., stride].
+ */
+template <typename T, typename C>
+inline void as_colors_strided(
+    const T* data,
+    const std::vector<size_t>& shape,
+    const std::vector<ptrdiff_t>& strides,
+    const quantiser& q,
+    const C* colors,
+    size_t stride,
+    C* out
+)
+{
+    size_t size = std::accumulate(shape.cbegin(), shape.cend(), size_t(1), std::multiplies<>{});
+
+    parallel_for(size, get_parallel_grain(), [&](size_t begin, size_t end) {
+        strided_runs(shape, strides, begin, end, [&](ptrdiff_t o, ptrdiff_t s, size_t n, size_t i) {
+            as_colors_kernel(data + o, s, n, q, colors, stride, out + i * stride);
+        });
+    });
+}
+
+/**
+ * Map a strided array to colormap indices, see cppcolormap::as_indices.
+ *
+ * @param data Pointer to the first item of the data.
+ * @param shape Shape of the data.
+ * @param strides Strides of the data (in units of items).
+ * @param q Mapping of data to colour index.
+ * @param out Output, row-major [shape...].
+ */
+template <typename T, typename I>
+inline void as_indices_strided(
+    const T* data,
+    const std::vector<size_t>& shape,
+    const std::vector<ptrdiff_t>& strides,
+    const quantiser& q,
+    I* out
+)
+{
+    size_t size = std::accumulate(shape.cbegin(), shape.cend(), size_t(1), std::multiplies<>{});
+
+    parallel_for(size, get_parallel_grain(), [&](size_t begin, size_t end) {
+        strided_runs(shape, strides, begin, end, [&](ptrdiff_t o, ptrdiff_t s, size_t n, size_t i) {
+            as_indices_kernel(data + o, s, n, q, out + i);
+        });
+    });
+}
+
+/**
+ * Minimum and maximum of a strided array (NaN is ignored).
+ *
+ * @param data Pointer to the first item of the data.
+ * @param shape Shape of the data.
+ * @param strides Strides of the data (in units of items).
+ * @return `{min, max}`.
+ */
+template <typename T>
+inline std::array<double, 2> strided_minmax(
+    const T* data,
+    const std::vector<size_t>& shape,
+    const std::vector<ptrdiff_t>& strides
+)
+{
+    size_t size = std::accumulate(shape.cbegin(), shape.cend(), size_t(1), std::multiplies<>{});
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+
+    strided_runs(shape, strides, 0, size, [&](ptrdiff_t o, ptrdiff_t s, size_t n, size_t) {
+        for (size_t i = 0; i < n; ++i) {
+            double v = static_cast<double>(data[o + static_cast<ptrdiff_t>(i) * s]);
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+    });
+
+    return {lo, hi};
+}
+
+template <class D, class C, typename V, class R>
+inline void as_colors_func(const D& data, const C& colors, V vmin, V vmax, R& ret)
+{
+    CPPCOLORMAP_ASSERT(vmax > vmin);
+    CPPCOLORMAP_ASSERT(colors.shape(0) > 0);
+    CPPCOLORMAP_ASSERT(colors.dimension() == 2);
+    CPPCOLORMAP_STATS_SCOPE(as_colors);
+
+    quantiser q(static_cast<double>(vmin), static_cast<double>(vmax), colors.shape(0));
+    size_t stride = colors.shape(1);
+    size_t size = data.size();
+    auto* pr = ret.data();
+
+    CPPCOLORMAP_STATS_COUNT(
+        size,
+        ret.size() * sizeof(typename R::value_type),
+        parallel_blocks(size, get_parallel_grain())
+    );
+
+    with_row_major(data, [&](const auto* pd) {
+        with_row_major(colors, [&](const auto* pc) {
+            parallel_for(size, get_parallel_grain(), [&](size_t begin, size_t end) {
+                as_colors_kernel(pd + begin, end - begin, q, pc, stride, pr + begin * stride);
+            });
+        });
+    });
+}
+
+template <class D, typename V, class R>
+inline void as_indices_func(const D& data, size_t N, V vmin, V vmax, R& ret)
+{
+    CPPCOLORMAP_ASSERT(vmax > vmin);
+    CPPCOLORMAP_ASSERT(N > 0);
+    CPPCOLORMAP_ASSERT(
+        N - 1 <= static_cast<size_t>(std::numeric_limits<typename R::value_type>::max())
+    );
+
+    quantiser q(static_cast<double>(vmin), static_cast<double>(vmax), N);
+    size_t size = data.size();
+    auto* pr = ret.data();
+
+    with_row_major(data, [&](const auto* pd) {
+        parallel_for(size, get_parallel_grain(), [&](size_t begin, size_t end) {
+            as_indices_kernel(pd + begin, end - begin, q, pr + begin);
+        });
+    });
+}
+
+template <class E, typename = void>
+struct as_colors_impl {
+    template <class C, typename S>
+    static xt::xarray<typename C::value_type> run(const E& data, const C& colors, S vmin, S vmax)
+    {
+        size_t N = data.dimension();
+        std::vector<size_t> shape(N + 1);
+        std::copy(data.shape().cbegin(), data.shape().cend(), shape.begin());
+        shape[N] = colors.shape(1);
+        xt::xarray<typename C::value_type> ret(shape);
+        as_colors_func(data, colors, vmin, vmax, ret);
+        return ret;
+    }
+
+    template <typename I, typename S>
+    static xt::xarray<I> indices(const E& data, size_t N, S vmin, S vmax)
+    {
+        std::vector<size_t> shape(data.shape().cbegin(), data.shape().cend());
+        xt::xarray<I> ret(shape);
+        as_indices_func(data, N, vmin, vmax, ret);
+        return ret;
+    }
+};
+
+template <class E>
+struct as_colors_impl<E, typename xt::has_fixed_rank_t<E>> {
+    using value_type = typename E::value_type;
+    constexpr static size_t N = xt::get_rank<E>::value;
+
+    template <class C, typename S>
+    static array_type::tensor<typename C::value_type, N + 1>
+    run(const E& data, const C& colors, S vmin, S vmax)
+    {
+        std::array<size_t, N + 1> shape;
+        std::copy(data.shape().cbegin(), data.shape().cend(), shape.begin());
+        shape[N] = colors.shape(1);
+        array_type::tensor<typename C::value_type, N + 1> ret(shape);
+        as_colors_func(data, colors, vmin, vmax, ret);
+        return ret;
+    }
+
+    template <typename I, typename S>
+    static array_type::tensor<I, N> indices(const E& data, size_t ncolors, S vmin, S vmax)
+    {
+        std::array<size_t, N> shape;
+        std::copy(data.shape().cbegin(), data.shape().cend(), shape.begin());
+        array_type::tensor<I, N> ret(shape);
+        as_indices_func(data, ncolors, vmin, vmax, ret);
+        return ret;
+    }
+};
+} // namespace detail
+
+/**
+ * Convert data to colors using a colormap.
+ * Data outside `[vmin, vmax]` is clipped to the first or last colour.
+ * Large inputs are processed in parallel, see cppcolormap::set_num_threads.
+ *
+ * @param data The data.
+ * @param colors The colormap, e.g. ``cppcolormap::jet()``.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ */
+template <class E, class C, typename S>
+inline auto as_colors(const E& data, const C& colors, S vmin, S vmax)
+{
+    return detail::as_colors_impl<E>::run(data, colors, vmin, vmax);
+}
+
+/**
  * Convert data to colors using a colormap.
  *
  * @param data The data.
@@ -397,6 +2389,301 @@ inline auto as_colors(const E& data, const C& colors)
     return detail::as_colors_impl<E>::run(data, colors, xt::amin(data)(), xt::amax(data)());
 }
 
+/**
+ * Convert data to the index of the colour in a colormap with `N` colours,
+ * using the same mapping as cppcolormap::as_colors.
+ * This is useful for indexed image formats or to look-up colours elsewhere (e.g. on a GPU),
+ * as the output is much smaller than the colours.
+ * Large inputs are processed in parallel, see cppcolormap::set_num_threads.
+ *
+ * @tparam I Integer type of the output,
+ *     e.g. `uint8_t` for `N <= 256`, `uint16_t` for `N <= 65536`.
+ * @param data The data.
+ * @param N The number of colours in the colormap.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @return Indices, same shape as `data`.
+ */
+template <typename I, class E, typename S>
+inline auto as_indices(const E& data, size_t N, S vmin, S vmax)
+{
+    static_assert(std::is_integral<I>::value, "Index type must be integral");
+    return detail::as_colors_impl<E>::template indices<I>(data, N, vmin, vmax);
+}
+
+/**
+ * Convert data to the index of the colour in a colormap with `N` colours,
+ * using the limits of the data as colour-axis.
+ *
+ * @tparam I Integer type of the output,
+ *     e.g. `uint8_t` for `N <= 256`, `uint16_t` for `N <= 65536`.
+ * @param data The data.
+ * @param N The number of colours in the colormap.
+ * @return Indices, same shape as `data`.
+ */
+template <typename I, class E>
+inline auto as_indices(const E& data, size_t N)
+{
+    return as_indices<I>(data, N, xt::amin(data)(), xt::amax(data)());
+}
+
+/**
+ * Channel layout of the output of cppcolormap::CompiledColormap.
+ */
+enum pixel_format {
+    rgb, ///< Red, green, blue.
+    rgba, ///< Red, green, blue, alpha (opaque, unless the colormap has an alpha column).
+    bgr, ///< Blue, green, red.
+    bgra ///< Blue, green, red, alpha (opaque, unless the colormap has an alpha column).
+};
+
+/**
+ * Non-owning view of a colormap: `rows` colours of `cols` components (row-major, in [0, 1]).
+ */
+struct ColormapSpan {
+    const double* data = nullptr; ///< Pointer to the first component.
+    size_t rows = 0; ///< Number of colours.
+    size_t cols = 0; ///< Number of components per colour (3: RGB, 4: RGBA).
+
+    ColormapSpan() = default;
+
+    /**
+     * @param data Pointer to the first component.
+     * @param rows Number of colours.
+     * @param cols Number of components per colour (3: RGB, 4: RGBA).
+     */
+    ColormapSpan(const double* data, size_t rows, size_t cols) : data(data), rows(rows), cols(cols)
+    {
+    }
+
+    /**
+     * View of a row-major container, e.g. the output of cppcolormap::viridis.
+     * The container must outlive the view.
+     *
+     * @param colors Colormap [N, 3] or [N, 4].
+     * @throw std::invalid_argument if the container is not contiguous in row-major order
+     *     (e.g. a column-major array, or a strided NumPy view).
+     */
+    template <class C, typename = decltype(std::declval<const C&>().shape(0))>
+    ColormapSpan(const C& colors)
+    {
+        if (colors.dimension() != 2 || !detail::is_row_major(colors)) {
+            throw std::invalid_argument("ColormapSpan: expected a row-major array [N, 3|4]");
+        }
+
+        data = colors.data();
+        rows = colors.shape(0);
+        cols = colors.shape(1);
+    }
+};
+
+/**
+ * Colormap stored in the output type and channel layout of an image
+ * (e.g. `uint8_t` with cppcolormap::bgra, or `float` with cppcolormap::rgb),
+ * such that mapping data to colours (cppcolormap::as_colors on pointers) only copies pixels.
+ *
+ * @tparam O Output type: `uint8_t` (components in [0, 255], rounded as cppcolormap::pack_srgb8),
+ *     or a floating-point type (components in [0, 1]).
+ */
+template <typename O = uint8_t>
+class CompiledColormap {
+public:
+    CompiledColormap() = default;
+
+    /**
+     * @param colors Colormap [N, 3] or [N, 4], e.g. ``cppcolormap::viridis()``.
+     * @param format Channel layout of the output.
+     */
+    CompiledColormap(ColormapSpan colors, pixel_format format = rgb)
+        : m_size(colors.rows), m_format(format)
+    {
+        CPPCOLORMAP_ASSERT(colors.rows > 0);
+        CPPCOLORMAP_ASSERT(colors.cols == 3 || colors.cols == 4);
+
+        bool alpha = format == rgba || format == bgra;
+        bool swap = format == bgr || format == bgra;
+        m_channels = alpha ? 4 : 3;
+        m_table.resize(m_size * m_channels);
+
+        for (size_t i = 0; i < m_size; ++i) {
+            const double* c = colors.data + i * colors.cols;
+            O* t = &m_table[i * m_channels];
+            t[0] = convert(c[swap ? 2 : 0]);
+            t[1] = convert(c[1]);
+            t[2] = convert(c[swap ? 0 : 2]);
+            if (alpha) {
+                t[3] = convert(colors.cols == 4 ? c[3] : 1.0);
+            }
+        }
+    }
+
+    /**
+     * Number of colours.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Number of components per colour (3 or 4).
+     */
+    size_t channels() const
+    {
+        return m_channels;
+    }
+
+    /**
+     * Channel layout.
+     */
+    pixel_format format() const
+    {
+        return m_format;
+    }
+
+    /**
+     * Pointer to the colours (row-major [size(), channels()]).
+     */
+    const O* data() const
+    {
+        return m_table.data();
+    }
+
+private:
+    static O convert(double c)
+    {
+        static_assert(
+            std::is_same<O, uint8_t>::value || std::is_floating_point<O>::value,
+            "Output must be uint8_t or float"
+        );
+        return convert(c, std::is_same<O, uint8_t>{});
+    }
+
+    static O convert(double c, std::true_type)
+    {
+        return detail::srgb_to_srgb8(c);
+    }
+
+    static O convert(double c, std::false_type)
+    {
+        return static_cast<O>(c);
+    }
+
+    std::vector<O> m_table;
+    size_t m_size = 0;
+    size_t m_channels = 0;
+    pixel_format m_format = rgb;
+};
+
+/**
+ * Convert data to colors using a colormap, operating directly on (strided) memory.
+ * Data outside `[vmin, vmax]` is clipped to the first or last colour.
+ * Large inputs are processed in parallel, see cppcolormap::set_num_threads.
+ *
+ * @param data Pointer to the first data-point.
+ * @param n Number of data-points.
+ * @param stride Distance between data-points (in units of `T`, `1` for contiguous data).
+ * @param colors Colormap, e.g. ``cppcolormap::CompiledColormap<uint8_t>(cppcolormap::jet())``.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @param out Output, contiguous `[n, colors.channels()]`.
+ */
+template <typename T, typename O>
+inline void as_colors(
+    const T* data,
+    size_t n,
+    ptrdiff_t stride,
+    const CompiledColormap<O>& colors,
+    double vmin,
+    double vmax,
+    O* out
+)
+{
+    CPPCOLORMAP_ASSERT(vmax > vmin);
+    CPPCOLORMAP_STATS_SCOPE(as_colors);
+
+    detail::quantiser q(vmin, vmax, colors.size());
+    size_t nc = colors.channels();
+    const O* pc = colors.data();
+    size_t grain = get_parallel_grain();
+
+    CPPCOLORMAP_STATS_COUNT(n, 0, detail::parallel_blocks(n, grain));
+
+    detail::parallel_for(n, grain, [&](size_t begin, size_t end) {
+        const T* d = data + static_cast<ptrdiff_t>(begin) * stride;
+        detail::as_colors_kernel(d, stride, end - begin, q, pc, nc, out + begin * nc);
+    });
+}
+
+/**
+ * Convert data to colors using a colormap, operating directly on (strided) memory.
+ * To map repeatedly with the same colormap use cppcolormap::CompiledColormap.
+ *
+ * @param data Pointer to the first data-point.
+ * @param n Number of data-points.
+ * @param stride Distance between data-points (in units of `T`, `1` for contiguous data).
+ * @param colors Colormap, e.g. ``cppcolormap::jet()``.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @param out Output, contiguous `[n, 3]` or `[n, 4]` (depending on `format`).
+ * @param format Channel layout of the output.
+ */
+template <typename T, typename O>
+inline void as_colors(
+    const T* data,
+    size_t n,
+    ptrdiff_t stride,
+    ColormapSpan colors,
+    double vmin,
+    double vmax,
+    O* out,
+    pixel_format format = rgb
+)
+{
+    as_colors(data, n, stride, CompiledColormap<O>(colors, format), vmin, vmax, out);
+}
+
+/**
+ * Convert data to the index of the colour in a colormap with `N` colours,
+ * operating directly on (strided) memory. Same mapping as cppcolormap::as_indices.
+ *
+ * @param data Pointer to the first data-point.
+ * @param n Number of data-points.
+ * @param stride Distance between data-points (in units of `T`, `1` for contiguous data).
+ * @param N The number of colours in the colormap.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @param out Output, contiguous `[n]`.
+ */
+template <typename T, typename I>
+inline void as_indices(
+    const T* data,
+    size_t n,
+    ptrdiff_t stride,
+    size_t N,
+    double vmin,
+    double vmax,
+    I* out
+)
+{
+    static_assert(std::is_integral<I>::value, "Index type must be integral");
+    CPPCOLORMAP_ASSERT(vmax > vmin);
+    CPPCOLORMAP_ASSERT(N > 0);
+    CPPCOLORMAP_ASSERT(N - 1 <= static_cast<size_t>(std::numeric_limits<I>::max()));
+
+    detail::quantiser q(vmin, vmax, N);
+
+    detail::parallel_for(n, get_parallel_grain(), [&](size_t begin, size_t end) {
+        if (stride == 1) {
+            detail::as_indices_kernel(data + begin, end - begin, q, out + begin);
+            return;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = static_cast<I>(q(data[static_cast<ptrdiff_t>(i) * stride]));
+        }
+    });
+}
+
 /**
  * Qualitative colormap.
  *
@@ -4533,619 +6820,75 @@ inline array_type::tensor<double, 2> jet_r(size_t N = 256)
  * @param N Number of colors to output.
  * @returns RGB data.
  */
-inline array_type::tensor<double, 2> terrain_r(size_t N = 5)
+inline array_type::tensor<double, 2> terrain_r(size_t N = 6)
 {
     return xt::flip(terrain(N), 0);
 }
 
-/**
- * Inverse of cppcolormap::seismic.
- *
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> seismic_r(size_t N = 6)
-{
-    return xt::flip(seismic(N), 0);
-}
-
-/**
- * Inverse of cppcolormap::afmhot.
- *
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> afmhot_r(size_t N = 256)
-{
-    return xt::flip(afmhot(N), 0);
-}
-
-/**
- * Inverse of cppcolormap::magma.
- *
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> magma_r(size_t N = 256)
-{
-    return xt::flip(magma(N), 0);
-}
-
-/**
- * Inverse of cppcolormap::inferno.
- *
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> inferno_r(size_t N = 256)
-{
-    return xt::flip(inferno(N), 0);
-}
-
-/**
- * Inverse of cppcolormap::plasma.
- *
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> plasma_r(size_t N = 256)
-{
-    return xt::flip(plasma(N), 0);
-}
-
-/**
- * Inverse of cppcolormap::viridis.
- *
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> viridis_r(size_t N = 256)
-{
-    return xt::flip(viridis(N), 0);
-}
-
-/**
- * Get colormap specified as string.
- *
- * @param cmap Name of the colormap.
- * @param N Number of colors to output.
- * @returns RGB data.
- */
-inline array_type::tensor<double, 2> colormap(const std::string& cmap, size_t N = 256)
-{
-    if (cmap == "Accent") {
-        return Accent(N);
-    }
-    if (cmap == "Dark2") {
-        return Dark2(N);
-    }
-    if (cmap == "Paired") {
-        return Paired(N);
-    }
-    if (cmap == "Spectral") {
-        return Spectral(N);
-    }
-    if (cmap == "Pastel1") {
-        return Pastel1(N);
-    }
-    if (cmap == "Pastel2") {
-        return Pastel2(N);
-    }
-    if (cmap == "Set1") {
-        return Set1(N);
-    }
-    if (cmap == "Set2") {
-        return Set2(N);
-    }
-    if (cmap == "Set3") {
-        return Set3(N);
-    }
-    if (cmap == "Blues") {
-        return Blues(N);
-    }
-    if (cmap == "Greens") {
-        return Greens(N);
-    }
-    if (cmap == "Greys") {
-        return Greys(N);
-    }
-    if (cmap == "Oranges") {
-        return Oranges(N);
-    }
-    if (cmap == "Purples") {
-        return Purples(N);
-    }
-    if (cmap == "Reds") {
-        return Reds(N);
-    }
-    if (cmap == "BuPu") {
-        return BuPu(N);
-    }
-    if (cmap == "GnBu") {
-        return GnBu(N);
-    }
-    if (cmap == "PuBu") {
-        return PuBu(N);
-    }
-    if (cmap == "PuBuGn") {
-        return PuBuGn(N);
-    }
-    if (cmap == "PuRd") {
-        return PuRd(N);
-    }
-    if (cmap == "RdPu") {
-        return RdPu(N);
-    }
-    if (cmap == "OrRd") {
-        return OrRd(N);
-    }
-    if (cmap == "RdOrYl") {
-        return RdOrYl(N);
-    }
-    if (cmap == "YlGn") {
-        return YlGn(N);
-    }
-    if (cmap == "YlGnBu") {
-        return YlGnBu(N);
-    }
-    if (cmap == "YlOrRd") {
-        return YlOrRd(N);
-    }
-    if (cmap == "BrBG") {
-        return BrBG(N);
-    }
-    if (cmap == "PuOr") {
-        return PuOr(N);
-    }
-    if (cmap == "RdBu") {
-        return RdBu(N);
-    }
-    if (cmap == "RdGy") {
-        return RdGy(N);
-    }
-    if (cmap == "RdYlBu") {
-        return RdYlBu(N);
-    }
-    if (cmap == "RdYlGn") {
-        return RdYlGn(N);
-    }
-    if (cmap == "PiYG") {
-        return PiYG(N);
-    }
-    if (cmap == "PRGn") {
-        return PRGn(N);
-    }
-    if (cmap == "spring") {
-        return spring(N);
-    }
-    if (cmap == "summer") {
-        return summer(N);
-    }
-    if (cmap == "autumn") {
-        return autumn(N);
-    }
-    if (cmap == "winter") {
-        return winter(N);
-    }
-    if (cmap == "bone") {
-        return bone(N);
-    }
-    if (cmap == "cool") {
-        return cool(N);
-    }
-    if (cmap == "hot") {
-        return hot(N);
-    }
-    if (cmap == "copper") {
-        return copper(N);
-    }
-    if (cmap == "hsv") {
-        return hsv(N);
-    }
-    if (cmap == "nipy_spectral") {
-        return nipy_spectral(N);
-    }
-    if (cmap == "jet") {
-        return jet(N);
-    }
-    if (cmap == "terrain") {
-        return terrain(N);
-    }
-    if (cmap == "seismic") {
-        return seismic(N);
-    }
-    if (cmap == "afmhot") {
-        return afmhot(N);
-    }
-    if (cmap == "magma") {
-        return magma(N);
-    }
-    if (cmap == "inferno") {
-        return inferno(N);
-    }
-    if (cmap == "plasma") {
-        return plasma(N);
-    }
-    if (cmap == "viridis") {
-        return viridis(N);
-    }
-    if (cmap == "Accent_r") {
-        return Accent_r(N);
-    }
-    if (cmap == "Dark2_r") {
-        return Dark2_r(N);
-    }
-    if (cmap == "Paired_r") {
-        return Paired_r(N);
-    }
-    if (cmap == "Spectral_r") {
-        return Spectral_r(N);
-    }
-    if (cmap == "Pastel1_r") {
-        return Pastel1_r(N);
-    }
-    if (cmap == "Pastel2_r") {
-        return Pastel2_r(N);
-    }
-    if (cmap == "Set1_r") {
-        return Set1_r(N);
-    }
-    if (cmap == "Set2_r") {
-        return Set2_r(N);
-    }
-    if (cmap == "Set3_r") {
-        return Set3_r(N);
-    }
-    if (cmap == "Blues_r") {
-        return Blues_r(N);
-    }
-    if (cmap == "Greens_r") {
-        return Greens_r(N);
-    }
-    if (cmap == "Greys_r") {
-        return Greys_r(N);
-    }
-    if (cmap == "Oranges_r") {
-        return Oranges_r(N);
-    }
-    if (cmap == "Purples_r") {
-        return Purples_r(N);
-    }
-    if (cmap == "Reds_r") {
-        return Reds_r(N);
-    }
-    if (cmap == "BuPu_r") {
-        return BuPu_r(N);
-    }
-    if (cmap == "GnBu_r") {
-        return GnBu_r(N);
-    }
-    if (cmap == "PuBu_r") {
-        return PuBu_r(N);
-    }
-    if (cmap == "PuBuGn_r") {
-        return PuBuGn_r(N);
-    }
-    if (cmap == "PuRd_r") {
-        return PuRd_r(N);
-    }
-    if (cmap == "RdPu_r") {
-        return RdPu_r(N);
-    }
-    if (cmap == "OrRd_r") {
-        return OrRd_r(N);
-    }
-    if (cmap == "RdOrYl_r") {
-        return RdOrYl_r(N);
-    }
-    if (cmap == "YlGn_r") {
-        return YlGn_r(N);
-    }
-    if (cmap == "YlGnBu_r") {
-        return YlGnBu_r(N);
-    }
-    if (cmap == "YlOrRd_r") {
-        return YlOrRd_r(N);
-    }
-    if (cmap == "BrBG_r") {
-        return BrBG_r(N);
-    }
-    if (cmap == "PuOr_r") {
-        return PuOr_r(N);
-    }
-    if (cmap == "RdBu_r") {
-        return RdBu_r(N);
-    }
-    if (cmap == "RdGy_r") {
-        return RdGy_r(N);
-    }
-    if (cmap == "RdYlBu_r") {
-        return RdYlBu_r(N);
-    }
-    if (cmap == "RdYlGn_r") {
-        return RdYlGn_r(N);
-    }
-    if (cmap == "PiYG_r") {
-        return PiYG_r(N);
-    }
-    if (cmap == "PRGn_r") {
-        return PRGn_r(N);
-    }
-    if (cmap == "spring_r") {
-        return spring_r(N);
-    }
-    if (cmap == "summer_r") {
-        return summer_r(N);
-    }
-    if (cmap == "autumn_r") {
-        return autumn_r(N);
-    }
-    if (cmap == "winter_r") {
-        return winter_r(N);
-    }
-    if (cmap == "bone_r") {
-        return bone_r(N);
-    }
-    if (cmap == "cool_r") {
-        return cool_r(N);
-    }
-    if (cmap == "hot_r") {
-        return hot_r(N);
-    }
-    if (cmap == "copper_r") {
-        return copper_r(N);
-    }
-    if (cmap == "hsv_r") {
-        return hsv_r(N);
-    }
-    if (cmap == "nipy_spectral_r") {
-        return nipy_spectral_r(N);
-    }
-    if (cmap == "jet_r") {
-        return jet_r(N);
-    }
-    if (cmap == "terrain_r") {
-        return terrain_r(N);
-    }
-    if (cmap == "seismic_r") {
-        return seismic_r(N);
-    }
-    if (cmap == "afmhot_r") {
-        return afmhot_r(N);
-    }
-    if (cmap == "magma_r") {
-        return magma_r(N);
-    }
-    if (cmap == "inferno_r") {
-        return inferno_r(N);
-    }
-    if (cmap == "plasma_r") {
-        return plasma_r(N);
-    }
-    if (cmap == "viridis_r") {
-        return viridis_r(N);
-    }
-    if (cmap == "White") {
-        return White(N);
-    }
-    if (cmap == "Grey") {
-        return Grey(N);
-    }
-    if (cmap == "Black") {
-        return Black(N);
-    }
-    if (cmap == "Red") {
-        return Red(N);
-    }
-    if (cmap == "Blue") {
-        return Blue(N);
-    }
-    if (cmap == "tuewarmred") {
-        return tuewarmred(N);
-    }
-    if (cmap == "tuedarkblue") {
-        return tuedarkblue(N);
-    }
-    if (cmap == "tueblue") {
-        return tueblue(N);
-    }
-    if (cmap == "tuelightblue") {
-        return tuelightblue(N);
-    }
-    if (cmap == "Apricot") {
-        return Apricot(N);
-    }
-    if (cmap == "Aquamarine") {
-        return Aquamarine(N);
-    }
-    if (cmap == "Bittersweet") {
-        return Bittersweet(N);
-    }
-    if (cmap == "BlueGreen") {
-        return BlueGreen(N);
-    }
-    if (cmap == "BlueViolet") {
-        return BlueViolet(N);
-    }
-    if (cmap == "BrickRed") {
-        return BrickRed(N);
-    }
-    if (cmap == "Brown") {
-        return Brown(N);
-    }
-    if (cmap == "BurntOrange") {
-        return BurntOrange(N);
-    }
-    if (cmap == "CadetBlue") {
-        return CadetBlue(N);
-    }
-    if (cmap == "CarnationPink") {
-        return CarnationPink(N);
-    }
-    if (cmap == "Cerulean") {
-        return Cerulean(N);
-    }
-    if (cmap == "CornflowerBlue") {
-        return CornflowerBlue(N);
-    }
-    if (cmap == "Cyan") {
-        return Cyan(N);
-    }
-    if (cmap == "Dandelion") {
-        return Dandelion(N);
-    }
-    if (cmap == "DarkOrchid") {
-        return DarkOrchid(N);
-    }
-    if (cmap == "Emerald") {
-        return Emerald(N);
-    }
-    if (cmap == "ForestGreen") {
-        return ForestGreen(N);
-    }
-    if (cmap == "Fuchsia") {
-        return Fuchsia(N);
-    }
-    if (cmap == "Goldenrod") {
-        return Goldenrod(N);
-    }
-    if (cmap == "Gray") {
-        return Gray(N);
-    }
-    if (cmap == "Green") {
-        return Green(N);
-    }
-    if (cmap == "GreenYellow") {
-        return GreenYellow(N);
-    }
-    if (cmap == "JungleGreen") {
-        return JungleGreen(N);
-    }
-    if (cmap == "Lavender") {
-        return Lavender(N);
-    }
-    if (cmap == "LimeGreen") {
-        return LimeGreen(N);
-    }
-    if (cmap == "Magenta") {
-        return Magenta(N);
-    }
-    if (cmap == "Mahogany") {
-        return Mahogany(N);
-    }
-    if (cmap == "Maroon") {
-        return Maroon(N);
-    }
-    if (cmap == "Melon") {
-        return Melon(N);
-    }
-    if (cmap == "MidnightBlue") {
-        return MidnightBlue(N);
-    }
-    if (cmap == "Mulberry") {
-        return Mulberry(N);
-    }
-    if (cmap == "NavyBlue") {
-        return NavyBlue(N);
-    }
-    if (cmap == "OliveGreen") {
-        return OliveGreen(N);
-    }
-    if (cmap == "Orange") {
-        return Orange(N);
-    }
-    if (cmap == "OrangeRed") {
-        return OrangeRed(N);
-    }
-    if (cmap == "Orchid") {
-        return Orchid(N);
-    }
-    if (cmap == "Peach") {
-        return Peach(N);
-    }
-    if (cmap == "Periwinkle") {
-        return Periwinkle(N);
-    }
-    if (cmap == "PineGreen") {
-        return PineGreen(N);
-    }
-    if (cmap == "Plum") {
-        return Plum(N);
-    }
-    if (cmap == "ProcessBlue") {
-        return ProcessBlue(N);
-    }
-    if (cmap == "Purple") {
-        return Purple(N);
-    }
-    if (cmap == "RawSienna") {
-        return RawSienna(N);
-    }
-    if (cmap == "RedOrange") {
-        return RedOrange(N);
-    }
-    if (cmap == "RedViolet") {
-        return RedViolet(N);
-    }
-    if (cmap == "Rhodamine") {
-        return Rhodamine(N);
-    }
-    if (cmap == "RoyalBlue") {
-        return RoyalBlue(N);
-    }
-    if (cmap == "RoyalPurple") {
-        return RoyalPurple(N);
-    }
-    if (cmap == "RubineRed") {
-        return RubineRed(N);
-    }
-    if (cmap == "Salmon") {
-        return Salmon(N);
-    }
-    if (cmap == "SeaGreen") {
-        return SeaGreen(N);
-    }
-    if (cmap == "Sepia") {
-        return Sepia(N);
-    }
-    if (cmap == "SkyBlue") {
-        return SkyBlue(N);
-    }
-    if (cmap == "SpringGreen") {
-        return SpringGreen(N);
-    }
-    if (cmap == "Tan") {
-        return Tan(N);
-    }
-    if (cmap == "TealBlue") {
-        return TealBlue(N);
-    }
-    if (cmap == "Thistle") {
-        return Thistle(N);
-    }
-    if (cmap == "Turquoise") {
-        return Turquoise(N);
-    }
-    if (cmap == "Violet") {
-        return Violet(N);
-    }
-    if (cmap == "VioletRed") {
-        return VioletRed(N);
-    }
-    if (cmap == "WildStrawberry") {
-        return WildStrawberry(N);
-    }
-    if (cmap == "Yellow") {
-        return Yellow(N);
-    }
-    if (cmap == "YellowGreen") {
-        return YellowGreen(N);
-    }
-    if (cmap == "YellowOrange") {
-        return YellowOrange(N);
-    }
+/**
+ * Inverse of cppcolormap::seismic.
+ *
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> seismic_r(size_t N = 5)
+{
+    return xt::flip(seismic(N), 0);
+}
+
+/**
+ * Inverse of cppcolormap::afmhot.
+ *
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> afmhot_r(size_t N = 256)
+{
+    return xt::flip(afmhot(N), 0);
+}
+
+/**
+ * Inverse of cppcolormap::magma.
+ *
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> magma_r(size_t N = 256)
+{
+    return xt::flip(magma(N), 0);
+}
+
+/**
+ * Inverse of cppcolormap::inferno.
+ *
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> inferno_r(size_t N = 256)
+{
+    return xt::flip(inferno(N), 0);
+}
+
+/**
+ * Inverse of cppcolormap::plasma.
+ *
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> plasma_r(size_t N = 256)
+{
+    return xt::flip(plasma(N), 0);
+}
 
-    throw std::runtime_error("Colormap not recognized");
+/**
+ * Inverse of cppcolormap::viridis.
+ *
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> viridis_r(size_t N = 256)
+{
+    return xt::flip(viridis(N), 0);
 }
 
 /**
@@ -5491,42 +7234,548 @@ inline array_type::tensor<double, 2> colorcycle(const std::string& cmap)
 }
 
 /**
- * Algorithm to use for color matching.
+ * Entry of the registry of colormaps, see cppcolormap::register_colormap.
  */
-enum metric {
-    euclidean, ///< Euclidean norm
-    fast_perceptual, ///< Fast best perception algorithm. See:
-                     ///< https://stackoverflow.com/a/1847112/2646505
-    perceptual ///< Best perception algorithm. See: https://en.wikipedia.org/wiki/Color_difference
+struct ColormapEntry {
+    /**
+     * Function returning the colormap with a given number of colours
+     * (color-cycles ignore the number of colours).
+     */
+    std::function<array_type::tensor<double, 2>(size_t)> func;
+
+    /**
+     * Default number of colours.
+     */
+    size_t N;
 };
 
 namespace detail {
 
-double euclidean_metric(double R1, double G1, double B1, double R2, double G2, double B2)
+/**
+ * Registry of colormaps, initialised with all colormaps and color-cycles of this library
+ * on first use.
+ */
+inline std::unordered_map<std::string, ColormapEntry>& registry()
+{
+    static std::unordered_map<std::string, ColormapEntry> ret = {
+        {"Accent", {Accent, 8}},
+        {"Dark2", {Dark2, 8}},
+        {"Paired", {Paired, 12}},
+        {"Spectral", {Spectral, 11}},
+        {"Pastel1", {Pastel1, 9}},
+        {"Pastel2", {Pastel2, 8}},
+        {"Set1", {Set1, 9}},
+        {"Set2", {Set2, 8}},
+        {"Set3", {Set3, 12}},
+        {"Blues", {Blues, 9}},
+        {"Greens", {Greens, 9}},
+        {"Greys", {Greys, 2}},
+        {"Oranges", {Oranges, 9}},
+        {"Purples", {Purples, 9}},
+        {"Reds", {Reds, 9}},
+        {"BuPu", {BuPu, 9}},
+        {"GnBu", {GnBu, 9}},
+        {"PuBu", {PuBu, 9}},
+        {"PuBuGn", {PuBuGn, 9}},
+        {"PuRd", {PuRd, 9}},
+        {"RdPu", {RdPu, 9}},
+        {"OrRd", {OrRd, 9}},
+        {"RdOrYl", {RdOrYl, 9}},
+        {"YlGn", {YlGn, 9}},
+        {"YlGnBu", {YlGnBu, 9}},
+        {"YlOrRd", {YlOrRd, 9}},
+        {"BrBG", {BrBG, 11}},
+        {"PuOr", {PuOr, 11}},
+        {"RdBu", {RdBu, 11}},
+        {"RdGy", {RdGy, 11}},
+        {"RdYlBu", {RdYlBu, 11}},
+        {"RdYlGn", {RdYlGn, 11}},
+        {"PiYG", {PiYG, 11}},
+        {"PRGn", {PRGn, 11}},
+        {"Accent_r", {Accent_r, 8}},
+        {"Dark2_r", {Dark2_r, 8}},
+        {"Paired_r", {Paired_r, 12}},
+        {"Spectral_r", {Spectral_r, 11}},
+        {"Pastel1_r", {Pastel1_r, 9}},
+        {"Pastel2_r", {Pastel2_r, 8}},
+        {"Set1_r", {Set1_r, 9}},
+        {"Set2_r", {Set2_r, 8}},
+        {"Set3_r", {Set3_r, 12}},
+        {"Blues_r", {Blues_r, 9}},
+        {"Greens_r", {Greens_r, 9}},
+        {"Greys_r", {Greys_r, 2}},
+        {"Oranges_r", {Oranges_r, 9}},
+        {"Purples_r", {Purples_r, 9}},
+        {"Reds_r", {Reds_r, 9}},
+        {"BuPu_r", {BuPu_r, 9}},
+        {"GnBu_r", {GnBu_r, 9}},
+        {"PuBu_r", {PuBu_r, 9}},
+        {"PuBuGn_r", {PuBuGn_r, 9}},
+        {"PuRd_r", {PuRd_r, 9}},
+        {"RdPu_r", {RdPu_r, 9}},
+        {"OrRd_r", {OrRd_r, 9}},
+        {"RdOrYl_r", {RdOrYl_r, 9}},
+        {"YlGn_r", {YlGn_r, 9}},
+        {"YlGnBu_r", {YlGnBu_r, 9}},
+        {"YlOrRd_r", {YlOrRd_r, 9}},
+        {"BrBG_r", {BrBG_r, 11}},
+        {"PuOr_r", {PuOr_r, 11}},
+        {"RdBu_r", {RdBu_r, 11}},
+        {"RdGy_r", {RdGy_r, 11}},
+        {"RdYlBu_r", {RdYlBu_r, 11}},
+        {"RdYlGn_r", {RdYlGn_r, 11}},
+        {"PiYG_r", {PiYG_r, 11}},
+        {"PRGn_r", {PRGn_r, 11}},
+        {"spring", {spring, 256}},
+        {"summer", {summer, 256}},
+        {"autumn", {autumn, 256}},
+        {"winter", {winter, 256}},
+        {"bone", {bone, 256}},
+        {"cool", {cool, 256}},
+        {"hot", {hot, 256}},
+        {"copper", {copper, 256}},
+        {"hsv", {hsv, 256}},
+        {"nipy_spectral", {nipy_spectral, 256}},
+        {"terrain", {terrain, 6}},
+        {"seismic", {seismic, 5}},
+        {"afmhot", {afmhot, 256}},
+        {"magma", {magma, 256}},
+        {"inferno", {inferno, 256}},
+        {"plasma", {plasma, 256}},
+        {"viridis", {viridis, 256}},
+        {"jet", {jet, 256}},
+        {"spring_r", {spring_r, 256}},
+        {"summer_r", {summer_r, 256}},
+        {"autumn_r", {autumn_r, 256}},
+        {"winter_r", {winter_r, 256}},
+        {"bone_r", {bone_r, 256}},
+        {"cool_r", {cool_r, 256}},
+        {"hot_r", {hot_r, 256}},
+        {"copper_r", {copper_r, 256}},
+        {"hsv_r", {hsv_r, 256}},
+        {"nipy_spectral_r", {nipy_spectral_r, 256}},
+        {"terrain_r", {terrain_r, 6}},
+        {"seismic_r", {seismic_r, 5}},
+        {"afmhot_r", {afmhot_r, 256}},
+        {"magma_r", {magma_r, 256}},
+        {"inferno_r", {inferno_r, 256}},
+        {"plasma_r", {plasma_r, 256}},
+        {"viridis_r", {viridis_r, 256}},
+        {"jet_r", {jet_r, 256}},
+        {"Apricot", {Apricot, 1}},
+        {"Aquamarine", {Aquamarine, 1}},
+        {"Bittersweet", {Bittersweet, 1}},
+        {"Black", {Black, 1}},
+        {"Blue", {Blue, 1}},
+        {"BlueGreen", {BlueGreen, 1}},
+        {"BlueViolet", {BlueViolet, 1}},
+        {"BrickRed", {BrickRed, 1}},
+        {"Brown", {Brown, 1}},
+        {"BurntOrange", {BurntOrange, 1}},
+        {"CadetBlue", {CadetBlue, 1}},
+        {"CarnationPink", {CarnationPink, 1}},
+        {"Cerulean", {Cerulean, 1}},
+        {"CornflowerBlue", {CornflowerBlue, 1}},
+        {"Cyan", {Cyan, 1}},
+        {"Dandelion", {Dandelion, 1}},
+        {"DarkOrchid", {DarkOrchid, 1}},
+        {"Emerald", {Emerald, 1}},
+        {"ForestGreen", {ForestGreen, 1}},
+        {"Fuchsia", {Fuchsia, 1}},
+        {"Goldenrod", {Goldenrod, 1}},
+        {"Gray", {Gray, 1}},
+        {"Green", {Green, 1}},
+        {"GreenYellow", {GreenYellow, 1}},
+        {"Grey", {Grey, 1}},
+        {"JungleGreen", {JungleGreen, 1}},
+        {"Lavender", {Lavender, 1}},
+        {"LimeGreen", {LimeGreen, 1}},
+        {"Magenta", {Magenta, 1}},
+        {"Mahogany", {Mahogany, 1}},
+        {"Maroon", {Maroon, 1}},
+        {"Melon", {Melon, 1}},
+        {"MidnightBlue", {MidnightBlue, 1}},
+        {"Mulberry", {Mulberry, 1}},
+        {"NavyBlue", {NavyBlue, 1}},
+        {"OliveGreen", {OliveGreen, 1}},
+        {"Orange", {Orange, 1}},
+        {"OrangeRed", {OrangeRed, 1}},
+        {"Orchid", {Orchid, 1}},
+        {"Peach", {Peach, 1}},
+        {"Periwinkle", {Periwinkle, 1}},
+        {"PineGreen", {PineGreen, 1}},
+        {"Plum", {Plum, 1}},
+        {"ProcessBlue", {ProcessBlue, 1}},
+        {"Purple", {Purple, 1}},
+        {"RawSienna", {RawSienna, 1}},
+        {"Red", {Red, 1}},
+        {"RedOrange", {RedOrange, 1}},
+        {"RedViolet", {RedViolet, 1}},
+        {"Rhodamine", {Rhodamine, 1}},
+        {"RoyalBlue", {RoyalBlue, 1}},
+        {"RoyalPurple", {RoyalPurple, 1}},
+        {"RubineRed", {RubineRed, 1}},
+        {"Salmon", {Salmon, 1}},
+        {"SeaGreen", {SeaGreen, 1}},
+        {"Sepia", {Sepia, 1}},
+        {"SkyBlue", {SkyBlue, 1}},
+        {"SpringGreen", {SpringGreen, 1}},
+        {"Tan", {Tan, 1}},
+        {"TealBlue", {TealBlue, 1}},
+        {"Thistle", {Thistle, 1}},
+        {"tueblue", {tueblue, 1}},
+        {"tuedarkblue", {tuedarkblue, 1}},
+        {"tuelightblue", {tuelightblue, 1}},
+        {"tuewarmred", {tuewarmred, 1}},
+        {"Turquoise", {Turquoise, 1}},
+        {"Violet", {Violet, 1}},
+        {"VioletRed", {VioletRed, 1}},
+        {"White", {White, 1}},
+        {"WildStrawberry", {WildStrawberry, 1}},
+        {"Yellow", {Yellow, 1}},
+        {"YellowGreen", {YellowGreen, 1}},
+        {"YellowOrange", {YellowOrange, 1}},
+        {"xterm", {[](size_t) { return xterm(); }, xterm().shape(0)}},
+        {"tue", {[](size_t) { return tue(); }, tue().shape(0)}},
+        {"xterm_r", {[](size_t) { return xterm_r(); }, xterm_r().shape(0)}},
+        {"tue_r", {[](size_t) { return tue_r(); }, tue_r().shape(0)}},
+    };
+    return ret;
+}
+
+inline std::mutex& registry_mutex()
+{
+    static std::mutex ret;
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * Add a colormap to the registry, such that it is available by name from
+ * cppcolormap::colormap (and as `cppcolormap.name` in Python).
+ * An existing colormap with the same name is replaced.
+ *
+ * @param name Name of the colormap.
+ * @param func Function returning the colormap with a given number of colours.
+ * @param N Default number of colours.
+ */
+inline void register_colormap(
+    const std::string& name,
+    std::function<array_type::tensor<double, 2>(size_t)> func,
+    size_t N = 256
+)
+{
+    std::lock_guard<std::mutex> lock(detail::registry_mutex());
+    detail::registry()[name] = ColormapEntry{std::move(func), N};
+}
+
+/**
+ * Check if a colormap is in the registry.
+ *
+ * @param name Name of the colormap.
+ * @return `true` if the colormap is registered.
+ */
+inline bool is_registered(const std::string& name)
 {
-    return std::pow(R1 - R2, 2.0) + std::pow(G1 - G2, 2.0) + std::pow(B1 - B2, 2.0);
+    std::lock_guard<std::mutex> lock(detail::registry_mutex());
+    return detail::registry().count(name) > 0;
 }
 
-// https://stackoverflow.com/a/1847112/2646505
-double fast_perceptual_metric(double R1, double G1, double B1, double R2, double G2, double B2)
+/**
+ * Get a colormap from the registry.
+ *
+ * @param name Name of the colormap.
+ * @return Entry (copy).
+ * @throw std::runtime_error if the colormap is not registered.
+ */
+inline ColormapEntry registry_entry(const std::string& name)
 {
-    return 0.3 * std::pow(R1 - R2, 2.0) + 0.59 * std::pow(G1 - G2, 2.0) +
-           0.11 * std::pow(B1 - B2, 2.0);
+    std::lock_guard<std::mutex> lock(detail::registry_mutex());
+    auto it = detail::registry().find(name);
+
+    if (it == detail::registry().end()) {
+        throw std::runtime_error("Colormap not recognized");
+    }
+
+    return it->second;
 }
 
-// https://en.wikipedia.org/wiki/Color_difference
-double perceptual_metric(double R1, double G1, double B1, double R2, double G2, double B2)
+/**
+ * Names of all colormaps in the registry.
+ *
+ * @return Names (sorted).
+ */
+inline std::vector<std::string> registered_colormaps()
 {
-    double r_ = (R1 + R2) / 2.0;
-    double DR = (R1 - R2);
-    double DG = (G1 - G2);
-    double DB = (B1 - B2);
+    std::lock_guard<std::mutex> lock(detail::registry_mutex());
+    std::vector<std::string> ret;
+    ret.reserve(detail::registry().size());
+
+    for (auto& item : detail::registry()) {
+        ret.push_back(item.first);
+    }
+
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
 
-    return 2 * DR * DR + 4 * DG * DG + 3 * DB * DB + ((r_ * (DR * DR - DB * DB)));
+/**
+ * Get colormap specified as string.
+ * Any colormap in the registry can be used, see cppcolormap::register_colormap.
+ *
+ * @param cmap Name of the colormap.
+ * @param N Number of colors to output.
+ * @returns RGB data.
+ */
+inline array_type::tensor<double, 2> colormap(const std::string& cmap, size_t N = 256)
+{
+    CPPCOLORMAP_STATS_SCOPE(colormap);
+    array_type::tensor<double, 2> ret = registry_entry(cmap).func(N);
+    CPPCOLORMAP_STATS_COUNT(ret.shape(0), ret.size() * sizeof(double), 1);
+    return ret;
 }
 
+/**
+ * Algorithm to use for color matching.
+ */
+enum metric {
+    euclidean, ///< Euclidean norm
+    fast_perceptual, ///< Fast best perception algorithm. See:
+                     ///< https://stackoverflow.com/a/1847112/2646505
+    perceptual, ///< Best perception algorithm. See: https://en.wikipedia.org/wiki/Color_difference
+    delta_e_cie76, ///< Euclidean norm in cppcolormap::CIELAB (CIE76 colour difference)
+    delta_e_oklab ///< Euclidean norm in cppcolormap::Oklab
+};
+
+namespace detail {
+
+/**
+ * Nearest colour in a palette.
+ * The palette is stored per component (structure-of-arrays), sorted by the first component.
+ * The search starts at the query's first component and proceeds outwards, until the distance
+ * in the first component alone exceeds the best match found.
+ * The result is identical to a brute-force search (with ties resolved to the lowest index).
+ */
+class palette_matcher {
+public:
+    palette_matcher() = default;
+
+    /**
+     * @param palette Colours [N, 3].
+     * @param distance_metric Metric to use.
+     *     For cppcolormap::delta_e_cie76 and cppcolormap::delta_e_oklab both the palette and
+     *     each query are converted to the corresponding colour space.
+     */
+    template <class T>
+    palette_matcher(const T& palette, metric distance_metric)
+    {
+        CPPCOLORMAP_ASSERT(palette.dimension() == 2);
+        CPPCOLORMAP_ASSERT(palette.shape(1) == 3);
+        CPPCOLORMAP_ASSERT(palette.shape(0) > 0);
+
+        xt::xtensor<double, 2> p = palette; // row-major copy, independent of the input's layout
+        m_metric = distance_metric;
+
+        if (distance_metric == metric::delta_e_cie76) {
+            m_space = colorspace::CIELAB;
+            m_metric = metric::euclidean;
+        }
+        else if (distance_metric == metric::delta_e_oklab) {
+            m_space = colorspace::Oklab;
+            m_metric = metric::euclidean;
+        }
+
+        // lower bound of the distance in terms of the first component (0: no pruning)
+        if (m_metric == metric::euclidean) {
+            m_weight = 1.0;
+        }
+        else if (m_metric == metric::fast_perceptual) {
+            m_weight = 0.3;
+        }
+
+        convert(p.data(), p.shape(0), colorspace::sRGB, m_space);
+
+        size_t n = p.shape(0);
+        m_index.resize(n);
+        std::iota(m_index.begin(), m_index.end(), size_t(0));
+        std::stable_sort(m_index.begin(), m_index.end(), [&](size_t i, size_t j) {
+            return p(i, 0) < p(j, 0);
+        });
+
+        m_r.resize(n);
+        m_g.resize(n);
+        m_b.resize(n);
+
+        for (size_t j = 0; j < n; ++j) {
+            m_r[j] = p(m_index[j], 0);
+            m_g[j] = p(m_index[j], 1);
+            m_b[j] = p(m_index[j], 2);
+        }
+    }
+
+    /**
+     * Number of colours in the palette.
+     */
+    size_t size() const
+    {
+        return m_r.size();
+    }
+
+    /**
+     * Colour space in which the palette is stored, and in which queries are compared.
+     */
+    colorspace space() const
+    {
+        return m_space;
+    }
+
+    /**
+     * Index of the closest colour, for a colour that is already in the colour space space().
+     *
+     * @param c Colour (pointer to three components).
+     * @return Index in the palette.
+     */
+    size_t find(const double* c) const
+    {
+        double r = c[0];
+        double g = c[1];
+        double b = c[2];
+
+        switch (m_metric) {
+        case metric::fast_perceptual:
+            // https://stackoverflow.com/a/1847112/2646505
+            return search(r, [&](size_t j) {
+                double dr = r - m_r[j];
+                double dg = g - m_g[j];
+                double db = b - m_b[j];
+                return 0.3 * dr * dr + 0.59 * dg * dg + 0.11 * db * db;
+            });
+        case metric::perceptual:
+            // https://en.wikipedia.org/wiki/Color_difference
+            return search(r, [&](size_t j) {
+                double rm = 0.5 * (r + m_r[j]);
+                double dr = r - m_r[j];
+                double dg = g - m_g[j];
+                double db = b - m_b[j];
+                return 2.0 * dr * dr + 4.0 * dg * dg + 3.0 * db * db + rm * (dr * dr - db * db);
+            });
+        default:
+            return search(r, [&](size_t j) {
+                double dr = r - m_r[j];
+                double dg = g - m_g[j];
+                double db = b - m_b[j];
+                return dr * dr + dg * dg + db * db;
+            });
+        }
+    }
+
+    /**
+     * Index of the closest colour.
+     *
+     * @param c sRGB colour (pointer to three components).
+     * @return Index in the palette.
+     */
+    size_t operator()(const double* c) const
+    {
+        if (m_space == colorspace::sRGB) {
+            return find(c);
+        }
+
+        double x[3] = {c[0], c[1], c[2]};
+        convert(x, 1, colorspace::sRGB, m_space);
+        return find(x);
+    }
+
+private:
+    template <class F>
+    size_t search(double r, const F& distance) const
+    {
+        size_t n = m_r.size();
+        auto it = std::lower_bound(m_r.cbegin(), m_r.cend(), r);
+        size_t start = static_cast<size_t>(it - m_r.cbegin());
+        size_t ret = 0;
+        double dmin = std::numeric_limits<double>::infinity();
+
+        auto consider = [&](size_t j) {
+            double dr = r - m_r[j];
+            if (m_weight * dr * dr > dmin) {
+                return false;
+            }
+            double d = distance(j);
+            if (d < dmin || (d == dmin && m_index[j] < ret)) {
+                dmin = d;
+                ret = m_index[j];
+            }
+            return true;
+        };
+
+        for (size_t j = start; j < n; ++j) {
+            if (!consider(j)) {
+                break;
+            }
+        }
+
+        for (size_t j = start; j-- > 0;) {
+            if (!consider(j)) {
+                break;
+            }
+        }
+
+        return ret;
+    }
+
+    std::vector<double> m_r;
+    std::vector<double> m_g;
+    std::vector<double> m_b;
+    std::vector<size_t> m_index;
+    double m_weight = 0.0;
+    metric m_metric = metric::euclidean;
+    colorspace m_space = colorspace::sRGB;
+};
+
 } // namespace detail
 
+/**
+ * Match colors, operating directly on memory.
+ *
+ * @param A List of colors, row-major [n, 3].
+ * @param n Number of colors in ``A``.
+ * @param B List of colors, e.g. ``cppcolormap::ColormapSpan(ptr, rows, 3)``.
+ * @param distance_metric Metric to use in color matching.
+ * @param out Output [n]: for each item in ``A``, the index of the closest color in ``B``.
+ */
+template <typename I>
+inline void match(const double* A, size_t n, ColormapSpan B, metric distance_metric, I* out)
+{
+    CPPCOLORMAP_ASSERT(B.cols == 3);
+    CPPCOLORMAP_STATS_SCOPE(match);
+
+    array_type::tensor<double, 2> b = xt::empty<double>({B.rows, B.cols});
+    std::copy(B.data, B.data + B.rows * B.cols, b.data());
+    detail::palette_matcher matcher(b, distance_metric);
+    colorspace space = matcher.space();
+    size_t grain = std::max(get_parallel_grain() / matcher.size(), size_t(1));
+
+    CPPCOLORMAP_STATS_COUNT(n, b.size() * sizeof(double), detail::parallel_blocks(n, grain));
+
+    detail::parallel_for(n, grain, [&](size_t begin, size_t end) {
+        if (space == colorspace::sRGB) {
+            for (size_t i = begin; i < end; ++i) {
+                out[i] = static_cast<I>(matcher.find(&A[3 * i]));
+            }
+            return;
+        }
+
+        std::vector<double> a(A + 3 * begin, A + 3 * end);
+        detail::convert(a.data(), end - begin, colorspace::sRGB, space);
+
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = static_cast<I>(matcher.find(&a[3 * (i - begin)]));
+        }
+    });
+}
+
 /**
  * Match colors.
  *
@@ -5541,27 +7790,418 @@ inline array_type::tensor<size_t, 1> match(
     metric distance_metric = euclidean
 )
 {
+    CPPCOLORMAP_ASSERT(A.dimension() == 2);
+    CPPCOLORMAP_ASSERT(A.shape(1) == 3);
+    CPPCOLORMAP_ASSERT(B.dimension() == 2);
+
     array_type::tensor<size_t, 1> idx = xt::empty<size_t>({A.shape(0)});
-    array_type::tensor<double, 1> d = xt::empty<double>({B.shape(0)});
 
-    auto fmetric = detail::euclidean_metric;
+    detail::with_row_major(A, [&](const double* a) {
+        detail::with_row_major(B, [&](const double* b) {
+            ColormapSpan span(b, B.shape(0), B.shape(1));
+            match(a, A.shape(0), span, distance_metric, idx.data());
+        });
+    });
+
+    return idx;
+}
+
+namespace detail {
+
+// row-major copy of the image, independent of the input's layout (it is modified in place)
+template <class T>
+inline xt::xtensor<double, 3> dither_image(const T& image)
+{
+    CPPCOLORMAP_ASSERT(image.dimension() == 3);
+    CPPCOLORMAP_ASSERT(image.shape(2) == 3);
+    return image;
+}
+
+template <typename I>
+inline array_type::tensor<I, 2> dither_output(const xt::xtensor<double, 3>& image)
+{
+    std::array<size_t, 2> shape = {image.shape(0), image.shape(1)};
+    return array_type::tensor<I, 2>(shape);
+}
+
+// Bayer (ordered dither) index matrix
+constexpr std::array<std::array<unsigned char, 8>, 8> bayer8 = {{
+    {0, 32, 8, 40, 2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44, 4, 36, 14, 46, 6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    {3, 35, 11, 43, 1, 33, 9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47, 7, 39, 13, 45, 5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+}};
+
+} // namespace detail
+
+/**
+ * Quantise an image to a palette using ordered (Bayer 8x8) dithering.
+ * A position dependent offset is added to each pixel before finding the closest colour.
+ * Pixels are independent, such that the image is processed in parallel by blocks of rows
+ * (see cppcolormap::set_num_threads).
+ *
+ * @tparam I Integer type of the output, e.g. `uint8_t` for palettes with up to 256 colours.
+ * @param image sRGB image [H, W, 3], e.g. ``cppcolormap::as_colors(data, cmap)``.
+ * @param palette Colors [N, 3], e.g. ``cppcolormap::xterm()``.
+ * @param spread Amplitude of the offset (in units of the colour components).
+ * @param distance_metric Metric to use in color matching.
+ * @return Index in the palette of each pixel [H, W].
+ */
+template <typename I = size_t, class T>
+inline array_type::tensor<I, 2> dither_ordered(
+    const T& image,
+    const array_type::tensor<double, 2>& palette,
+    double spread,
+    metric distance_metric = euclidean
+)
+{
+    CPPCOLORMAP_ASSERT(palette.shape(0) - 1 <= static_cast<size_t>(std::numeric_limits<I>::max()));
+
+    xt::xtensor<double, 3> img = detail::dither_image(image);
+    array_type::tensor<I, 2> ret = detail::dither_output<I>(img);
+    detail::palette_matcher matcher(palette, distance_metric);
+    size_t h = img.shape(0);
+    size_t w = img.shape(1);
+    const double* pimg = img.data();
+    I* pret = ret.data();
+    size_t grain = std::max(get_parallel_grain() / (w * matcher.size() + 1), size_t(1));
+
+    detail::parallel_for(h, grain, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            for (size_t x = 0; x < w; ++x) {
+                size_t i = y * w + x;
+                double t = (static_cast<double>(detail::bayer8[y % 8][x % 8]) + 0.5) / 64.0 - 0.5;
+                double d = spread * t;
+                double c[3] = {pimg[3 * i] + d, pimg[3 * i + 1] + d, pimg[3 * i + 2] + d};
+                pret[i] = static_cast<I>(matcher(c));
+            }
+        }
+    });
+
+    return ret;
+}
+
+/**
+ * Quantise an image to a palette using ordered (Bayer 8x8) dithering.
+ * The amplitude of the offset is estimated from the size of the palette as `1 / cbrt(N)`.
+ *
+ * @tparam I Integer type of the output, e.g. `uint8_t` for palettes with up to 256 colours.
+ * @param image sRGB image [H, W, 3], e.g. ``cppcolormap::as_colors(data, cmap)``.
+ * @param palette Colors [N, 3], e.g. ``cppcolormap::xterm()``.
+ * @param distance_metric Metric to use in color matching.
+ * @return Index in the palette of each pixel [H, W].
+ */
+template <typename I = size_t, class T>
+inline array_type::tensor<I, 2> dither_ordered(
+    const T& image,
+    const array_type::tensor<double, 2>& palette,
+    metric distance_metric = euclidean
+)
+{
+    double spread = 1.0 / std::cbrt(static_cast<double>(palette.shape(0)));
+    return dither_ordered<I>(image, palette, spread, distance_metric);
+}
+
+/**
+ * Quantise an image to a palette using Floyd-Steinberg error diffusion.
+ *
+ * The quantisation error of each pixel is diffused to its unprocessed neighbours.
+ * With serpentine scanning the scan direction alternates per row, which avoids directional
+ * artefacts but requires each row to be finished before the next can start.
+ * Without serpentine scanning all rows are scanned left-to-right and are processed in a pipeline:
+ * a row can proceed as long as it stays three pixels behind the row above.
+ * Rows are then processed in parallel (see cppcolormap::set_num_threads).
+ *
+ * @tparam I Integer type of the output, e.g. `uint8_t` for palettes with up to 256 colours.
+ * @param image sRGB image [H, W, 3], e.g. ``cppcolormap::as_colors(data, cmap)``.
+ * @param palette Colors [N, 3], e.g. ``cppcolormap::xterm()``.
+ * @param distance_metric Metric to use in color matching.
+ * @param serpentine Alternate the scan direction per row.
+ * @return Index in the palette of each pixel [H, W].
+ */
+template <typename I = size_t, class T>
+inline array_type::tensor<I, 2> dither_floyd_steinberg(
+    const T& image,
+    const array_type::tensor<double, 2>& palette,
+    metric distance_metric = euclidean,
+    bool serpentine = true
+)
+{
+    CPPCOLORMAP_ASSERT(palette.shape(0) - 1 <= static_cast<size_t>(std::numeric_limits<I>::max()));
+
+    xt::xtensor<double, 3> img = detail::dither_image(image);
+    array_type::tensor<I, 2> ret = detail::dither_output<I>(img);
+    detail::palette_matcher matcher(palette, distance_metric);
+    size_t h = img.shape(0);
+    size_t w = img.shape(1);
+    double* pimg = img.data();
+    I* pret = ret.data();
+
+    // process pixel (x, y) (in-place), diffuse the error in scan direction (forward or backward)
+    auto process = [&](size_t y, size_t x, bool forward) {
+        size_t i = y * w + x;
+        double* c = &pimg[3 * i];
+        size_t j = matcher(c);
+        pret[i] = static_cast<I>(j);
+
+        double e[3] = {c[0] - palette(j, 0), c[1] - palette(j, 1), c[2] - palette(j, 2)};
+        bool has_next = forward ? x + 1 < w : x > 0;
+        bool has_prev = forward ? x > 0 : x + 1 < w;
+        size_t next = forward ? i + 1 : i - 1;
+        size_t prev = forward ? i - 1 : i + 1;
+
+        for (size_t k = 0; k < 3; ++k) {
+            if (has_next) {
+                pimg[3 * next + k] += e[k] * (7.0 / 16.0);
+            }
+            if (y + 1 < h) {
+                if (has_prev) {
+                    pimg[3 * (prev + w) + k] += e[k] * (3.0 / 16.0);
+                }
+                pimg[3 * (i + w) + k] += e[k] * (5.0 / 16.0);
+                if (has_next) {
+                    pimg[3 * (next + w) + k] += e[k] * (1.0 / 16.0);
+                }
+            }
+        }
+    };
 
-    if (distance_metric == metric::fast_perceptual) {
-        fmetric = detail::fast_perceptual_metric;
+    if (serpentine || h < 2 || !detail::parallel_ordered() ||
+        detail::parallel_blocks(h * w, get_parallel_grain()) <= 1) {
+        for (size_t y = 0; y < h; ++y) {
+            if (serpentine && y % 2 == 1) {
+                for (size_t x = w; x-- > 0;) {
+                    process(y, x, false);
+                }
+            }
+            else {
+                for (size_t x = 0; x < w; ++x) {
+                    process(y, x, true);
+                }
+            }
+        }
+        return ret;
     }
 
-    if (distance_metric == metric::perceptual) {
-        fmetric = detail::perceptual_metric;
+    // pipeline: rows are started in increasing order (see detail::parallel_ordered),
+    // row "y" may process pixel "x" once row "y - 1" has finished pixel "x + 2"
+    // (the last pixel of the row above that writes to "x + 1" on this row)
+    std::vector<std::atomic<size_t>> progress(h);
+
+    for (auto& p : progress) {
+        p.store(0, std::memory_order_relaxed);
     }
 
-    for (size_t i = 0; i < A.shape(0); ++i) {
-        for (size_t j = 0; j < B.shape(0); ++j) {
-            d(j) = fmetric(A(i, 0), A(i, 1), A(i, 2), B(j, 0), B(j, 1), B(j, 2));
+    detail::parallel_for(h, 1, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            for (size_t x = 0; x < w; ++x) {
+                if (y > 0) {
+                    size_t need = std::min(x + 3, w);
+                    while (progress[y - 1].load(std::memory_order_acquire) < need) {
+                        std::this_thread::yield();
+                    }
+                }
+                process(y, x, true);
+                progress[y].store(x + 1, std::memory_order_release);
+            }
+        }
+    });
+
+    return ret;
+}
+
+/**
+ * Colour format of ANSI terminal output.
+ */
+enum ansi {
+    truecolor, ///< 24-bit colour (`ESC[38;2;r;g;bm`), supported by most modern terminals
+    xterm256 ///< 256-colour palette (`ESC[38;5;nm`), using the closest cppcolormap::xterm colour
+};
+
+/**
+ * Render a 2-d array as colours in a terminal, using ANSI escape codes.
+ * Each character cell shows two data-points using the upper half-block character
+ * (foreground: upper data-point, background: lower data-point).
+ *
+ * The escape codes of all colours are computed on construction.
+ * An escape code is only written if the colour differs from that of the previous cell,
+ * and the output is written to a buffer that is reused between calls,
+ * such that repeatedly rendering frames (e.g. to monitor a running simulation) is cheap.
+ * To redraw in place prefix the output with the cursor-home code `"\x1b[H"`.
+ */
+class AnsiRenderer {
+public:
+    AnsiRenderer() = default;
+
+    /**
+     * @param colors The colormap, e.g. ``cppcolormap::viridis()``.
+     * @param mode Colour format of the output.
+     *     For cppcolormap::xterm256 the colours are matched to the 240 colours of
+     *     cppcolormap::xterm that are not redefined by terminal themes (index >= 16).
+     */
+    template <class C>
+    AnsiRenderer(const C& colors, ansi mode = truecolor)
+    {
+        xt::xtensor<double, 2> c = colors;
+        CPPCOLORMAP_ASSERT(c.shape(1) == 3);
+        CPPCOLORMAP_ASSERT(c.shape(0) > 0);
+
+        size_t n = c.shape(0);
+        m_key.resize(n);
+        m_fg.resize(n);
+        m_bg.resize(n);
+
+        if (mode == xterm256) {
+            array_type::tensor<double, 2> x = xterm();
+            array_type::tensor<double, 2> palette = xt::view(x, xt::range(16, 256), xt::all());
+            detail::palette_matcher matcher(palette, metric::euclidean);
+            for (size_t i = 0; i < n; ++i) {
+                size_t j = matcher(&c(i, 0)) + 16;
+                m_key[i] = j;
+                m_fg[i] = "\x1b[38;5;" + std::to_string(j) + "m";
+                m_bg[i] = "\x1b[48;5;" + std::to_string(j) + "m";
+            }
+        }
+        else {
+            array_type::tensor<uint8_t, 2> rgb = pack_srgb8(c);
+            for (size_t i = 0; i < n; ++i) {
+                std::string code = std::to_string(rgb(i, 0)) + ";" + std::to_string(rgb(i, 1)) +
+                                   ";" + std::to_string(rgb(i, 2)) + "m";
+                m_key[i] = (size_t(rgb(i, 0)) << 16) | (size_t(rgb(i, 1)) << 8) | rgb(i, 2);
+                m_fg[i] = "\x1b[38;2;" + code;
+                m_bg[i] = "\x1b[48;2;" + code;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            m_max = std::max(m_max, m_fg[i].size());
         }
-        idx(i) = xt::argmin(d)(0);
     }
 
-    return idx;
+    /**
+     * Render data.
+     * The data are sampled (nearest neighbour) to `cols` columns and `2 * rows` rows.
+     *
+     * @param data The data [rows, columns].
+     * @param cols Number of character columns of the output.
+     * @param rows Number of character rows (lines) of the output.
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @return Reference to the output, valid until the next call.
+     */
+    template <class T>
+    const std::string& render(const T& data, size_t cols, size_t rows, double vmin, double vmax)
+    {
+        CPPCOLORMAP_ASSERT(data.dimension() == 2);
+        CPPCOLORMAP_ASSERT(vmax > vmin);
+        CPPCOLORMAP_ASSERT(m_key.size() > 0);
+
+        size_t h = data.shape(0);
+        size_t w = data.shape(1);
+        detail::quantiser q(vmin, vmax, m_key.size());
+
+        static constexpr char half[] = "\xe2\x96\x80";
+        static constexpr char reset[] = "\x1b[0m\n";
+        constexpr size_t nhalf = sizeof(half) - 1;
+        constexpr size_t nreset = sizeof(reset) - 1;
+
+        m_buffer.resize(rows * (cols * (2 * m_max + nhalf) + nreset));
+        char* p = &m_buffer[0];
+
+        auto write = [&p](const char* str, size_t n) {
+            std::memcpy(p, str, n);
+            p += n;
+        };
+
+        detail::with_row_major(data, [&](const auto* pd) {
+            for (size_t r = 0; r < rows; ++r) {
+                const auto* top = pd + ((2 * r) * h / (2 * rows)) * w;
+                const auto* bottom = pd + ((2 * r + 1) * h / (2 * rows)) * w;
+                size_t fg = std::numeric_limits<size_t>::max();
+                size_t bg = std::numeric_limits<size_t>::max();
+
+                for (size_t c = 0; c < cols; ++c) {
+                    size_t x = c * w / cols;
+                    size_t t = q(top[x]);
+                    size_t b = q(bottom[x]);
+
+                    if (m_key[b] != bg) {
+                        bg = m_key[b];
+                        write(m_bg[b].data(), m_bg[b].size());
+                    }
+
+                    if (m_key[t] == bg) {
+                        *p++ = ' ';
+                        continue;
+                    }
+
+                    if (m_key[t] != fg) {
+                        fg = m_key[t];
+                        write(m_fg[t].data(), m_fg[t].size());
+                    }
+
+                    write(half, nhalf);
+                }
+
+                write(reset, nreset);
+            }
+        });
+
+        m_buffer.resize(static_cast<size_t>(p - m_buffer.data()));
+        return m_buffer;
+    }
+
+    /**
+     * Render data, using the limits of the data as colour-axis.
+     *
+     * @param data The data [rows, columns].
+     * @param cols Number of character columns of the output.
+     * @param rows Number of character rows (lines) of the output.
+     * @return Reference to the output, valid until the next call.
+     */
+    template <class T>
+    const std::string& render(const T& data, size_t cols, size_t rows)
+    {
+        return render(data, cols, rows, xt::amin(data)(), xt::amax(data)());
+    }
+
+    /**
+     * Output of the last call to render().
+     */
+    const std::string& str() const
+    {
+        return m_buffer;
+    }
+
+private:
+    std::vector<size_t> m_key; // identical keys <-> identical escape codes
+    std::vector<std::string> m_fg;
+    std::vector<std::string> m_bg;
+    size_t m_max = 0;
+    std::string m_buffer;
+};
+
+/**
+ * Render a 2-d array as colours in a terminal, using ANSI escape codes.
+ * See cppcolormap::AnsiRenderer (which can be reused for a sequence of frames).
+ *
+ * @param data The data [rows, columns].
+ * @param colors The colormap, e.g. ``cppcolormap::viridis()``.
+ * @param cols Number of character columns of the output.
+ * @param rows Number of character rows (lines) of the output.
+ * @param mode Colour format of the output.
+ * @return The output.
+ */
+template <class T, class C>
+inline std::string
+as_ansi(const T& data, const C& colors, size_t cols, size_t rows, ansi mode = truecolor)
+{
+    AnsiRenderer renderer(colors, mode);
+    return renderer.render(data, cols, rows);
 }
 
 } // namespace cppcolormap
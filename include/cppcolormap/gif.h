@@ -0,0 +1,477 @@
+/**
+ * Animated GIF output of colormapped frames, using the colormap as global palette.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_GIF_H
+#define CPPCOLORMAP_GIF_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../cppcolormap.h"
+#include "image.h"
+
+namespace cppcolormap {
+
+namespace detail {
+
+/**
+ * GIF flavoured LZW encoder (variable code width, at most 12 bits).
+ * The dictionary is a dense table `[4096, 2^min_code_size]` of child codes, such that each
+ * pixel costs one lookup. On reset only the entries that were added are cleared.
+ */
+class gif_lzw {
+public:
+    gif_lzw() = default;
+
+    explicit gif_lzw(size_t min_code_size)
+        : m_min(min_code_size),
+          m_symbols(size_t(1) << min_code_size),
+          m_child(4096 * m_symbols, 0)
+    {
+        m_used.reserve(4096);
+    }
+
+    /**
+     * Encode indices (each `< 2^min_code_size`), appending the packed codes to `out`
+     * (without sub-block framing).
+     */
+    void encode(const uint8_t* data, size_t n, std::vector<uint8_t>& out)
+    {
+        uint32_t clear = static_cast<uint32_t>(m_symbols);
+        m_acc = 0;
+        m_bits = 0;
+        reset();
+        emit(clear, out);
+
+        if (n == 0) {
+            emit(clear + 1, out);
+            flush(out);
+            return;
+        }
+
+        uint32_t prefix = data[0];
+
+        for (size_t i = 1; i < n; ++i) {
+            uint32_t symbol = data[i];
+            size_t slot = prefix * m_symbols + symbol;
+            uint16_t child = m_child[slot];
+
+            if (child != 0) {
+                prefix = child;
+                continue;
+            }
+
+            emit(prefix, out);
+            m_child[slot] = static_cast<uint16_t>(m_next);
+            m_used.push_back(slot);
+            grow();
+
+            if (m_next == 4096) {
+                emit(clear, out);
+                reset();
+            }
+
+            prefix = symbol;
+        }
+
+        emit(prefix, out);
+        grow();
+
+        emit(clear + 1, out);
+        flush(out);
+    }
+
+private:
+    void reset()
+    {
+        for (size_t slot : m_used) {
+            m_child[slot] = 0;
+        }
+
+        m_used.clear();
+        m_width = m_min + 1;
+        m_next = static_cast<uint32_t>(m_symbols) + 2;
+    }
+
+    // a decoder lags one entry behind: it widens codes once the next entry needs the extra bit
+    void grow()
+    {
+        m_next++;
+
+        if (m_next > (uint32_t(1) << m_width) && m_width < 12) {
+            m_width++;
+        }
+    }
+
+    void emit(uint32_t code, std::vector<uint8_t>& out)
+    {
+        m_acc |= uint64_t(code) << m_bits;
+        m_bits += m_width;
+
+        while (m_bits >= 8) {
+            out.push_back(static_cast<uint8_t>(m_acc));
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+
+    void flush(std::vector<uint8_t>& out)
+    {
+        if (m_bits > 0) {
+            out.push_back(static_cast<uint8_t>(m_acc));
+        }
+
+        m_acc = 0;
+        m_bits = 0;
+    }
+
+    size_t m_min = 2;
+    size_t m_symbols = 4;
+    std::vector<uint16_t> m_child;
+    std::vector<size_t> m_used;
+    size_t m_width = 3;
+    uint32_t m_next = 6;
+    uint64_t m_acc = 0;
+    size_t m_bits = 0;
+};
+
+} // namespace detail
+
+/**
+ * Write an animated GIF, frame by frame, with the colormap as (global) palette.
+ * Frames are given as palette indices (see cppcolormap::as_indices), or as data that is
+ * quantised directly to indices, such that no RGB image is formed.
+ * Only one frame is buffered.
+ *
+ * Usage:
+ *
+ *      cppcolormap::GifWriter gif("movie.gif", width, height, cppcolormap::viridis());
+ *
+ *      for (size_t i = 0; i < nframes; ++i) {
+ *          gif.write_frame(frame(i).data(), vmin, vmax);
+ *      }
+ *
+ *      gif.close();
+ *
+ * The animation is also finalised on destruction, but then errors are not reported.
+ */
+class GifWriter {
+public:
+    /**
+     * Open an animation.
+     *
+     * @param path Path of the animation (overwritten if it exists).
+     * @param width Number of pixels per row.
+     * @param height Number of rows.
+     * @param palette Colormap [N, 3] or [N, 4] (alpha is ignored), in [0, 1], with `N <= 256`.
+     * @param delay Time between frames, in hundredths of a second.
+     * @param loop Number of times the animation is repeated (`0`: forever).
+     * @throw std::invalid_argument if the palette does not have 1 to 256 rows.
+     * @throw std::runtime_error if the file cannot be opened.
+     */
+    GifWriter(
+        const std::string& path,
+        size_t width,
+        size_t height,
+        ColormapSpan palette,
+        size_t delay = 10,
+        size_t loop = 0
+    )
+        : m_width(width), m_height(height), m_delay(delay)
+    {
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+
+        if (!m_file) {
+            throw std::runtime_error("Cannot open \"" + path + "\" for writing");
+        }
+
+        m_out = &m_file;
+        write_header(palette, loop);
+    }
+
+    /**
+     * Write an animation to a stream. The stream must outlive the writer, and is not closed.
+     *
+     * @param out Output stream (opened in binary mode).
+     * @param width Number of pixels per row.
+     * @param height Number of rows.
+     * @param palette Colormap [N, 3] or [N, 4] (alpha is ignored), in [0, 1], with `N <= 256`.
+     * @param delay Time between frames, in hundredths of a second.
+     * @param loop Number of times the animation is repeated (`0`: forever).
+     * @throw std::invalid_argument if the palette does not have 1 to 256 rows.
+     */
+    GifWriter(
+        std::ostream& out,
+        size_t width,
+        size_t height,
+        ColormapSpan palette,
+        size_t delay = 10,
+        size_t loop = 0
+    )
+        : m_width(width), m_height(height), m_delay(delay)
+    {
+        m_out = &out;
+        write_header(palette, loop);
+    }
+
+    GifWriter(const GifWriter&) = delete;
+    GifWriter& operator=(const GifWriter&) = delete;
+
+    ~GifWriter()
+    {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    /**
+     * Number of pixels per row.
+     */
+    size_t width() const
+    {
+        return m_width;
+    }
+
+    /**
+     * Number of rows.
+     */
+    size_t height() const
+    {
+        return m_height;
+    }
+
+    /**
+     * Number of frames written.
+     */
+    size_t frames() const
+    {
+        return m_frames;
+    }
+
+    /**
+     * Write the next frame.
+     *
+     * @param indices Palette indices [height, width] (row-major), each `< N`.
+     * @throw std::invalid_argument if an index is out of range.
+     * @throw std::runtime_error if writing fails.
+     */
+    void write_frame(const uint8_t* indices)
+    {
+        size_t n = m_width * m_height;
+
+        if (std::any_of(indices, indices + n, [&](uint8_t i) { return i >= m_colors; })) {
+            throw std::invalid_argument("GifWriter: palette index out of range");
+        }
+
+        encode_frame(indices);
+    }
+
+    /**
+     * Quantise data to palette indices and write it as the next frame.
+     * Large frames are quantised in parallel, see cppcolormap::set_num_threads.
+     *
+     * @param data Pointer to data [height, width] (row-major).
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @throw std::runtime_error if writing fails.
+     */
+    template <typename T>
+    void write_frame(const T* data, double vmin, double vmax)
+    {
+        m_indices.resize(m_width * m_height);
+        as_indices(data, m_indices.size(), 1, m_colors, vmin, vmax, m_indices.data());
+        encode_frame(m_indices.data());
+    }
+
+    /**
+     * Write the trailer and flush (and close the file if it was opened by this writer).
+     *
+     * @throw std::runtime_error if writing fails.
+     */
+    void close()
+    {
+        if (!m_out) {
+            return;
+        }
+
+        m_out->put(0x3B);
+        bool ok = m_out->good();
+
+        if (m_file.is_open()) {
+            m_file.close();
+        }
+        else {
+            m_out->flush();
+        }
+
+        m_out = nullptr;
+
+        if (!ok) {
+            throw std::runtime_error("Writing GIF failed");
+        }
+    }
+
+private:
+    /**
+     * Encode and write a frame of indices, each `< m_colors`.
+     */
+    void encode_frame(const uint8_t* indices)
+    {
+        if (!m_out) {
+            throw std::logic_error("GifWriter already closed");
+        }
+
+        std::vector<uint8_t>& b = m_buffer;
+        b.clear();
+
+        // graphic control extension: no transparency, delay
+        b.insert(b.end(), {0x21, 0xF9, 0x04, 0x00});
+        detail::put_le16(b, static_cast<uint32_t>(m_delay));
+        b.insert(b.end(), {0x00, 0x00});
+
+        // image descriptor: full canvas, global palette, not interlaced
+        b.push_back(0x2C);
+        detail::put_le16(b, 0);
+        detail::put_le16(b, 0);
+        detail::put_le16(b, static_cast<uint32_t>(m_width));
+        detail::put_le16(b, static_cast<uint32_t>(m_height));
+        b.push_back(0x00);
+        b.push_back(static_cast<uint8_t>(m_min_code_size));
+
+        m_codes.clear();
+        m_lzw.encode(indices, m_width * m_height, m_codes);
+
+        for (size_t i = 0; i < m_codes.size(); i += 255) {
+            size_t n = std::min(size_t(255), m_codes.size() - i);
+            b.push_back(static_cast<uint8_t>(n));
+            b.insert(b.end(), m_codes.begin() + i, m_codes.begin() + i + n);
+        }
+
+        b.push_back(0x00);
+        write(b);
+        m_frames++;
+    }
+
+    void write(const std::vector<uint8_t>& data)
+    {
+        m_out->write(reinterpret_cast<const char*>(data.data()), data.size());
+
+        if (!m_out->good()) {
+            throw std::runtime_error("Writing GIF failed");
+        }
+    }
+
+    void write_header(ColormapSpan palette, size_t loop)
+    {
+        CPPCOLORMAP_ASSERT(m_width > 0 && m_width <= 0xFFFF);
+        CPPCOLORMAP_ASSERT(m_height > 0 && m_height <= 0xFFFF);
+        CPPCOLORMAP_ASSERT(m_delay <= 0xFFFF && loop <= 0xFFFF);
+
+        if (palette.rows == 0 || palette.rows > 256 || (palette.cols != 3 && palette.cols != 4)) {
+            throw std::invalid_argument("GifWriter: expected a palette [N, 3|4] with N <= 256");
+        }
+
+        // the palette is padded to a power of two, the minimal code size is at least 2
+        size_t bits = 1;
+
+        while ((size_t(1) << bits) < palette.rows) {
+            bits++;
+        }
+
+        m_colors = palette.rows;
+        m_min_code_size = std::max(size_t(2), bits);
+        m_lzw = detail::gif_lzw(m_min_code_size);
+
+        std::vector<uint8_t>& b = m_buffer;
+        static const char* signature = "GIF89a";
+        b.assign(signature, signature + 6);
+        detail::put_le16(b, static_cast<uint32_t>(m_width));
+        detail::put_le16(b, static_cast<uint32_t>(m_height));
+        b.push_back(static_cast<uint8_t>(0xF0 | (bits - 1)));
+        b.push_back(0x00);
+        b.push_back(0x00);
+
+        for (size_t i = 0; i < (size_t(1) << bits); ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                double c = i < palette.rows ? palette.data[i * palette.cols + j] : 0.0;
+                b.push_back(detail::srgb_to_srgb8(c));
+            }
+        }
+
+        // application extension: number of loops
+        b.insert(b.end(), {0x21, 0xFF, 0x0B});
+        static const char* netscape = "NETSCAPE2.0";
+        b.insert(b.end(), netscape, netscape + 11);
+        b.insert(b.end(), {0x03, 0x01});
+        detail::put_le16(b, static_cast<uint32_t>(loop));
+        b.push_back(0x00);
+
+        write(b);
+    }
+
+    std::ofstream m_file;
+    std::ostream* m_out = nullptr;
+    size_t m_width;
+    size_t m_height;
+    size_t m_delay;
+    size_t m_colors = 0;
+    size_t m_min_code_size = 2;
+    size_t m_frames = 0;
+    detail::gif_lzw m_lzw;
+    std::vector<uint8_t> m_buffer;
+    std::vector<uint8_t> m_codes;
+    std::vector<uint8_t> m_indices;
+};
+
+/**
+ * Write data as animated GIF, with the colormap as palette.
+ *
+ * @param path Path of the animation.
+ * @param data Data [nframes, height, width] (row-major).
+ * @param colors Colormap [N, 3] or [N, 4], with `N <= 256`, e.g. ``cppcolormap::viridis()``.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @param delay Time between frames, in hundredths of a second.
+ */
+template <class E>
+inline void write_gif(
+    const std::string& path,
+    const E& data,
+    ColormapSpan colors,
+    double vmin,
+    double vmax,
+    size_t delay = 10
+)
+{
+    CPPCOLORMAP_ASSERT(data.dimension() == 3);
+    CPPCOLORMAP_ASSERT(vmax > vmin);
+
+    size_t n = data.shape(0);
+    size_t h = data.shape(1);
+    size_t w = data.shape(2);
+    GifWriter gif(path, w, h, colors, delay);
+
+    detail::with_row_major(data, [&](const auto* pd) {
+        for (size_t i = 0; i < n; ++i) {
+            gif.write_frame(pd + i * h * w, vmin, vmax);
+        }
+    });
+
+    gif.close();
+}
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,746 @@
+/**
+ * Dependency-free image writers (PPM, BMP, QOI, PNG) that write an image row by row.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_IMAGE_H
+#define CPPCOLORMAP_IMAGE_H
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../cppcolormap.h"
+
+namespace cppcolormap {
+
+/**
+ * Image file format, see cppcolormap::ImageWriter.
+ */
+enum image_format {
+    ppm, ///< Binary Portable PixMap (P6), RGB only (alpha is dropped).
+    bmp, ///< Windows bitmap, 24-bit (RGB) or 32-bit (RGBA, alpha is ignored by some readers).
+    qoi, ///< Quite OK Image format (lossless, fast compression).
+    png ///< PNG, uncompressed (deflate "stored" blocks), RGB, RGBA, or indexed.
+};
+
+namespace detail {
+
+inline uint32_t crc32(uint32_t crc, const uint8_t* data, size_t n)
+{
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> ret;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (size_t k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            ret[i] = c;
+        }
+        return ret;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline uint32_t adler32(uint32_t adler, const uint8_t* data, size_t n)
+{
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (n > 0) {
+        size_t m = std::min(n, size_t(5552));
+        for (size_t i = 0; i < m; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += m;
+        n -= m;
+    }
+
+    return (b << 16) | a;
+}
+
+inline void put_be32(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline void put_le16(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+inline void put_le32(std::vector<uint8_t>& out, uint32_t value)
+{
+    put_le16(out, value & 0xFFFF);
+    put_le16(out, value >> 16);
+}
+
+} // namespace detail
+
+/**
+ * Image format corresponding to the extension of a path
+ * (`.ppm`, `.bmp`, `.qoi`, `.png`; case insensitive).
+ *
+ * @param path Path of the image.
+ * @return Image format.
+ * @throw std::invalid_argument if the extension is not recognised.
+ */
+inline image_format image_format_from_path(const std::string& path)
+{
+    size_t i = path.rfind('.');
+    std::string ext = i == std::string::npos ? "" : path.substr(i + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+
+    if (ext == "ppm") {
+        return ppm;
+    }
+    if (ext == "bmp") {
+        return bmp;
+    }
+    if (ext == "qoi") {
+        return qoi;
+    }
+    if (ext == "png") {
+        return png;
+    }
+
+    throw std::invalid_argument("Unknown image format of \"" + path + "\"");
+}
+
+/**
+ * Write an image to file (or stream) row by row (top to bottom), such that only one row
+ * (and for PNG one deflate block of at most 64 kB) is buffered.
+ *
+ * Usage:
+ *
+ *      cppcolormap::ImageWriter image("image.png", width, height);
+ *
+ *      for (size_t i = 0; i < height; ++i) {
+ *          image.write_row(pixels); // [width, 3], 8-bit RGB
+ *      }
+ *
+ *      image.close();
+ *
+ * The image is also finalised on destruction, but then errors are not reported.
+ * For indexed images (PNG only) the rows hold palette indices, see
+ * cppcolormap::as_indices.
+ */
+class ImageWriter {
+public:
+    /**
+     * Open an RGB(A) image.
+     *
+     * @param path Path of the image (overwritten if it exists).
+     * @param width Number of pixels per row.
+     * @param height Number of rows.
+     * @param channels Number of bytes per pixel: 3 (RGB) or 4 (RGBA).
+     * @param format Image format.
+     * @throw std::runtime_error if the file cannot be opened.
+     */
+    ImageWriter(
+        const std::string& path,
+        size_t width,
+        size_t height,
+        size_t channels,
+        image_format format
+    )
+        : m_width(width), m_height(height), m_channels(channels), m_format(format)
+    {
+        CPPCOLORMAP_ASSERT(channels == 3 || channels == 4);
+        open(path);
+        write_header();
+    }
+
+    /**
+     * Open an RGB(A) image, with the format following from the extension of `path`.
+     *
+     * @param path Path of the image (overwritten if it exists).
+     * @param width Number of pixels per row.
+     * @param height Number of rows.
+     * @param channels Number of bytes per pixel: 3 (RGB) or 4 (RGBA).
+     */
+    ImageWriter(const std::string& path, size_t width, size_t height, size_t channels = 3)
+        : ImageWriter(path, width, height, channels, image_format_from_path(path))
+    {
+    }
+
+    /**
+     * Open an indexed (8-bit palette) PNG image.
+     *
+     * @param path Path of the image (overwritten if it exists).
+     * @param width Number of pixels per row.
+     * @param height Number of rows.
+     * @param palette Palette [N, 3] or [N, 4] (with alpha), in [0, 1], with `N <= 256`.
+     * @throw std::invalid_argument if `path` does not have the extension `.png`,
+     *     or if the palette does not have 1 to 256 rows and 3 or 4 columns.
+     * @throw std::runtime_error if the file cannot be opened.
+     */
+    ImageWriter(const std::string& path, size_t width, size_t height, ColormapSpan palette)
+        : m_width(width), m_height(height), m_channels(1), m_format(image_format_from_path(path))
+    {
+        if (palette.rows == 0 || palette.rows > 256 || (palette.cols != 3 && palette.cols != 4)) {
+            throw std::invalid_argument("ImageWriter: expected a palette [N, 3|4] with N <= 256");
+        }
+
+        for (size_t i = 0; i < palette.rows * palette.cols; ++i) {
+            m_palette.push_back(detail::srgb_to_srgb8(palette.data[i]));
+        }
+
+        m_palette_cols = palette.cols;
+        open(path);
+        write_header();
+    }
+
+    /**
+     * Write an RGB(A) image to a stream (e.g. a ``std::ostringstream`` to encode in memory).
+     * The stream must outlive the writer, and is not closed.
+     *
+     * @param out Output stream (opened in binary mode).
+     * @param width Number of pixels per row.
+     * @param height Number of rows.
+     * @param channels Number of bytes per pixel: 3 (RGB) or 4 (RGBA).
+     * @param format Image format.
+     */
+    ImageWriter(
+        std::ostream& out,
+        size_t width,
+        size_t height,
+        size_t channels,
+        image_format format
+    )
+        : m_width(width), m_height(height), m_channels(channels), m_format(format)
+    {
+        CPPCOLORMAP_ASSERT(channels == 3 || channels == 4);
+        CPPCOLORMAP_ASSERT(width > 0 && height > 0);
+        m_out = &out;
+        write_header();
+    }
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    ~ImageWriter()
+    {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    /**
+     * Number of pixels per row.
+     */
+    size_t width() const
+    {
+        return m_width;
+    }
+
+    /**
+     * Number of rows.
+     */
+    size_t height() const
+    {
+        return m_height;
+    }
+
+    /**
+     * Number of bytes per pixel (1 for indexed images).
+     */
+    size_t channels() const
+    {
+        return m_channels;
+    }
+
+    /**
+     * Number of rows written so far.
+     */
+    size_t rows() const
+    {
+        return m_row;
+    }
+
+    /**
+     * Write the next row.
+     *
+     * @param pixels `[width(), channels()]`: RGB(A) or palette indices.
+     * @throw std::out_of_range if all rows were already written.
+     */
+    void write_row(const uint8_t* pixels)
+    {
+        if (m_row >= m_height) {
+            throw std::out_of_range("All rows of the image were already written");
+        }
+
+        switch (m_format) {
+        case ppm:
+            write_row_ppm(pixels);
+            break;
+        case bmp:
+            write_row_bmp(pixels);
+            break;
+        case qoi:
+            write_row_qoi(pixels);
+            break;
+        case png:
+            write_row_png(pixels);
+            break;
+        }
+
+        m_row++;
+    }
+
+    /**
+     * Write the next rows.
+     *
+     * @param pixels `[n, width(), channels()]`.
+     * @param n Number of rows.
+     */
+    void write_rows(const uint8_t* pixels, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            write_row(pixels + i * m_width * m_channels);
+        }
+    }
+
+    /**
+     * Finalise the image and close the file (or flush the stream).
+     *
+     * @throw std::runtime_error if not all rows were written, or if writing failed.
+     */
+    void close()
+    {
+        if (!m_out) {
+            return;
+        }
+
+        if (m_row == m_height) {
+            if (m_format == qoi) {
+                flush_qoi_run();
+                static const uint8_t end[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+                m_buffer.insert(m_buffer.end(), end, end + 8);
+                flush();
+            }
+            else if (m_format == png) {
+                write_idat(true);
+                write_chunk("IEND");
+            }
+        }
+
+        bool ok = m_out->good();
+
+        if (m_file.is_open()) {
+            m_file.close();
+        }
+        else {
+            m_out->flush();
+        }
+
+        m_out = nullptr;
+
+        if (m_row != m_height) {
+            throw std::runtime_error(
+                "Image incomplete: " + std::to_string(m_row) + " of " + std::to_string(m_height) +
+                " rows written"
+            );
+        }
+
+        if (!ok) {
+            throw std::runtime_error("Writing image failed");
+        }
+    }
+
+private:
+    void open(const std::string& path)
+    {
+        CPPCOLORMAP_ASSERT(m_width > 0 && m_height > 0);
+
+        if (m_channels == 1 && m_format != png) {
+            throw std::invalid_argument("Indexed images are only supported as PNG");
+        }
+
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+
+        if (!m_file) {
+            throw std::runtime_error("Cannot open \"" + path + "\" for writing");
+        }
+
+        m_out = &m_file;
+    }
+
+    void flush()
+    {
+        m_out->write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        m_buffer.clear();
+    }
+
+    void write_header()
+    {
+        switch (m_format) {
+        case ppm: {
+            std::string h = "P6\n" + std::to_string(m_width) + " " + std::to_string(m_height) +
+                            "\n255\n";
+            m_out->write(h.data(), h.size());
+            break;
+        }
+        case bmp: {
+            size_t bpp = m_channels * 8;
+            size_t stride = (m_width * m_channels + 3) / 4 * 4;
+            size_t size = 54 + stride * m_height;
+            if (size > 0xFFFFFFFFu) {
+                throw std::invalid_argument("Image too large for BMP");
+            }
+            m_buffer = {'B', 'M'};
+            detail::put_le32(m_buffer, static_cast<uint32_t>(size));
+            detail::put_le32(m_buffer, 0);
+            detail::put_le32(m_buffer, 54);
+            detail::put_le32(m_buffer, 40);
+            detail::put_le32(m_buffer, static_cast<uint32_t>(m_width));
+            detail::put_le32(m_buffer, static_cast<uint32_t>(-static_cast<int32_t>(m_height)));
+            detail::put_le16(m_buffer, 1);
+            detail::put_le16(m_buffer, static_cast<uint32_t>(bpp));
+            detail::put_le32(m_buffer, 0);
+            detail::put_le32(m_buffer, static_cast<uint32_t>(stride * m_height));
+            detail::put_le32(m_buffer, 2835);
+            detail::put_le32(m_buffer, 2835);
+            detail::put_le32(m_buffer, 0);
+            detail::put_le32(m_buffer, 0);
+            flush();
+            break;
+        }
+        case qoi: {
+            m_buffer = {'q', 'o', 'i', 'f'};
+            detail::put_be32(m_buffer, static_cast<uint32_t>(m_width));
+            detail::put_be32(m_buffer, static_cast<uint32_t>(m_height));
+            m_buffer.push_back(static_cast<uint8_t>(m_channels));
+            m_buffer.push_back(0);
+            flush();
+            break;
+        }
+        case png: {
+            static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+            m_out->write(reinterpret_cast<const char*>(signature), 8);
+            detail::put_be32(m_buffer, static_cast<uint32_t>(m_width));
+            detail::put_be32(m_buffer, static_cast<uint32_t>(m_height));
+            m_buffer.push_back(8);
+            m_buffer.push_back(m_channels == 1 ? 3 : (m_channels == 3 ? 2 : 6));
+            m_buffer.push_back(0);
+            m_buffer.push_back(0);
+            m_buffer.push_back(0);
+            write_chunk("IHDR");
+            if (m_channels == 1) {
+                size_t n = m_palette.size() / m_palette_cols;
+                for (size_t i = 0; i < n; ++i) {
+                    for (size_t j = 0; j < 3; ++j) {
+                        m_buffer.push_back(m_palette[i * m_palette_cols + j]);
+                    }
+                }
+                write_chunk("PLTE");
+                if (m_palette_cols == 4) {
+                    for (size_t i = 0; i < n; ++i) {
+                        m_buffer.push_back(m_palette[i * 4 + 3]);
+                    }
+                    write_chunk("tRNS");
+                }
+            }
+            m_adler = 1;
+            break;
+        }
+        }
+    }
+
+    void write_row_ppm(const uint8_t* pixels)
+    {
+        if (m_channels == 3) {
+            m_out->write(reinterpret_cast<const char*>(pixels), m_width * 3);
+            return;
+        }
+
+        m_buffer.resize(m_width * 3);
+        for (size_t i = 0; i < m_width; ++i) {
+            std::copy(pixels + i * 4, pixels + i * 4 + 3, &m_buffer[i * 3]);
+        }
+        flush();
+    }
+
+    void write_row_bmp(const uint8_t* pixels)
+    {
+        size_t nc = m_channels;
+        m_buffer.assign((m_width * nc + 3) / 4 * 4, 0);
+
+        for (size_t i = 0; i < m_width; ++i) {
+            m_buffer[i * nc] = pixels[i * nc + 2];
+            m_buffer[i * nc + 1] = pixels[i * nc + 1];
+            m_buffer[i * nc + 2] = pixels[i * nc];
+            if (nc == 4) {
+                m_buffer[i * nc + 3] = pixels[i * nc + 3];
+            }
+        }
+
+        flush();
+    }
+
+    void flush_qoi_run()
+    {
+        if (m_qoi_run > 0) {
+            m_buffer.push_back(static_cast<uint8_t>(0xC0 | (m_qoi_run - 1)));
+            m_qoi_run = 0;
+        }
+    }
+
+    void write_row_qoi(const uint8_t* pixels)
+    {
+        size_t nc = m_channels;
+        std::array<uint8_t, 4>& prev = m_qoi_prev;
+
+        for (size_t i = 0; i < m_width; ++i) {
+            const uint8_t* p = pixels + i * nc;
+            std::array<uint8_t, 4> px = {p[0], p[1], p[2], nc == 4 ? p[3] : uint8_t(255)};
+
+            if (px == prev) {
+                if (++m_qoi_run == 62) {
+                    flush_qoi_run();
+                }
+                continue;
+            }
+
+            flush_qoi_run();
+            size_t h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+
+            if (m_qoi_index[h] == px) {
+                m_buffer.push_back(static_cast<uint8_t>(h));
+            }
+            else {
+                m_qoi_index[h] = px;
+
+                if (px[3] == prev[3]) {
+                    int vr = static_cast<int8_t>(px[0] - prev[0]);
+                    int vg = static_cast<int8_t>(px[1] - prev[1]);
+                    int vb = static_cast<int8_t>(px[2] - prev[2]);
+                    int vg_r = vr - vg;
+                    int vg_b = vb - vg;
+
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        m_buffer.push_back(
+                            static_cast<uint8_t>(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2))
+                        );
+                    }
+                    else if (vg > -33 && vg < 32 && vg_r > -9 && vg_r < 8 && vg_b > -9 &&
+                             vg_b < 8) {
+                        m_buffer.push_back(static_cast<uint8_t>(0x80 | (vg + 32)));
+                        m_buffer.push_back(static_cast<uint8_t>((vg_r + 8) << 4 | (vg_b + 8)));
+                    }
+                    else {
+                        m_buffer.insert(m_buffer.end(), {0xFE, px[0], px[1], px[2]});
+                    }
+                }
+                else {
+                    m_buffer.insert(m_buffer.end(), {0xFF, px[0], px[1], px[2], px[3]});
+                }
+            }
+
+            prev = px;
+        }
+
+        flush();
+    }
+
+    void write_row_png(const uint8_t* pixels)
+    {
+        size_t n = m_width * m_channels;
+        uint8_t filter = 0;
+        append_png(&filter, 1);
+        append_png(pixels, n);
+    }
+
+    /**
+     * Append data to the zlib stream, emitting a stored deflate block when it is full.
+     */
+    void append_png(const uint8_t* data, size_t n)
+    {
+        m_adler = detail::adler32(m_adler, data, n);
+
+        while (n > 0) {
+            size_t m = std::min(n, size_t(65535) - m_block.size());
+            m_block.insert(m_block.end(), data, data + m);
+            data += m;
+            n -= m;
+            if (m_block.size() == 65535) {
+                write_idat(false);
+            }
+        }
+    }
+
+    void write_idat(bool last)
+    {
+        if (!m_zlib_header) {
+            m_buffer.push_back(0x78);
+            m_buffer.push_back(0x01);
+            m_zlib_header = true;
+        }
+
+        uint32_t len = static_cast<uint32_t>(m_block.size());
+        m_buffer.push_back(last ? 1 : 0);
+        detail::put_le16(m_buffer, len);
+        detail::put_le16(m_buffer, ~len & 0xFFFF);
+        m_buffer.insert(m_buffer.end(), m_block.begin(), m_block.end());
+        m_block.clear();
+
+        if (last) {
+            detail::put_be32(m_buffer, m_adler);
+        }
+
+        write_chunk("IDAT");
+    }
+
+    /**
+     * Write `m_buffer` as a PNG chunk.
+     */
+    void write_chunk(const char* type)
+    {
+        std::vector<uint8_t> head;
+        detail::put_be32(head, static_cast<uint32_t>(m_buffer.size()));
+        head.insert(head.end(), type, type + 4);
+        uint32_t crc = detail::crc32(0, &head[4], 4);
+        crc = detail::crc32(crc, m_buffer.data(), m_buffer.size());
+        detail::put_be32(m_buffer, crc);
+        m_out->write(reinterpret_cast<const char*>(head.data()), head.size());
+        flush();
+    }
+
+    std::ofstream m_file;
+    std::ostream* m_out = nullptr;
+    size_t m_width;
+    size_t m_height;
+    size_t m_channels;
+    image_format m_format;
+    size_t m_row = 0;
+    std::vector<uint8_t> m_buffer;
+
+    // PNG
+    std::vector<uint8_t> m_palette;
+    size_t m_palette_cols = 0;
+    std::vector<uint8_t> m_block;
+    uint32_t m_adler = 1;
+    bool m_zlib_header = false;
+
+    // QOI
+    std::array<std::array<uint8_t, 4>, 64> m_qoi_index = {};
+    std::array<uint8_t, 4> m_qoi_prev = {0, 0, 0, 255};
+    size_t m_qoi_run = 0;
+};
+
+/**
+ * Convert data to colours and write them as image, a block of rows at a time
+ * (such that the colours of the full image are never held in memory).
+ *
+ * @param path Path of the image, its extension sets the format, see cppcolormap::image_format.
+ * @param data Data [height, width] (any layout; copied to row-major only if needed).
+ * @param colors Colormap, ``cppcolormap::CompiledColormap<uint8_t>`` with format `rgb` or `rgba`.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @throw std::invalid_argument if `vmax <= vmin`.
+ */
+template <class E>
+inline void write_image(
+    const std::string& path,
+    const E& data,
+    const CompiledColormap<uint8_t>& colors,
+    double vmin,
+    double vmax
+)
+{
+    CPPCOLORMAP_ASSERT(data.dimension() == 2);
+    CPPCOLORMAP_ASSERT(colors.format() == rgb || colors.format() == rgba);
+
+    if (!(vmax > vmin)) {
+        throw std::invalid_argument("write_image: expected vmax > vmin");
+    }
+
+    size_t h = data.shape(0);
+    size_t w = data.shape(1);
+    size_t nc = colors.channels();
+    size_t block = std::max(size_t(1), std::min(h, get_parallel_grain() / std::max(w, size_t(1))));
+    std::vector<uint8_t> pixels(block * w * nc);
+    ImageWriter image(path, w, h, nc);
+
+    detail::with_row_major(data, [&](const auto* d) {
+        for (size_t i = 0; i < h; i += block) {
+            size_t n = std::min(block, h - i);
+            as_colors(d + i * w, n * w, 1, colors, vmin, vmax, pixels.data());
+            image.write_rows(pixels.data(), n);
+        }
+    });
+
+    image.close();
+}
+
+/**
+ * Convert data to palette indices and write them as indexed PNG, a block of rows at a time.
+ * This gives the same colours as cppcolormap::write_image, at a third of the size.
+ *
+ * @param path Path of the image.
+ * @param data Data [height, width] (any layout; copied to row-major only if needed).
+ * @param colors Colormap [N, 3] or [N, 4], with `N <= 256`, e.g. ``cppcolormap::viridis()``.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @throw std::invalid_argument if `vmax <= vmin`.
+ */
+template <class E>
+inline void write_indexed_image(
+    const std::string& path,
+    const E& data,
+    ColormapSpan colors,
+    double vmin,
+    double vmax
+)
+{
+    CPPCOLORMAP_ASSERT(data.dimension() == 2);
+
+    if (!(vmax > vmin)) {
+        throw std::invalid_argument("write_indexed_image: expected vmax > vmin");
+    }
+
+    size_t h = data.shape(0);
+    size_t w = data.shape(1);
+    size_t block = std::max(size_t(1), std::min(h, get_parallel_grain() / std::max(w, size_t(1))));
+    std::vector<uint8_t> pixels(block * w);
+    ImageWriter image(path, w, h, colors);
+
+    detail::with_row_major(data, [&](const auto* d) {
+        for (size_t i = 0; i < h; i += block) {
+            size_t n = std::min(block, h - i);
+            as_indices(d + i * w, n * w, 1, colors.rows, vmin, vmax, pixels.data());
+            image.write_rows(pixels.data(), n);
+        }
+    });
+
+    image.close();
+}
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,864 @@
+/**
+ * Loaders of colormaps from common file formats (CSV/TSV tables, GMT ``.cpt``,
+ * ParaView XML and JSON, and matplotlib style JSON) into the registry.
+ * Requires C++17 (in contrast to the rest of the library).
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_LOADERS_H
+#define CPPCOLORMAP_LOADERS_H
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../cppcolormap.h"
+#include "mmap.h"
+
+#ifndef CPPCOLORMAP_HAS_STRING_VIEW
+#error "cppcolormap/loaders.h requires C++17"
+#endif
+
+namespace cppcolormap {
+
+/**
+ * Format of a colormap file, see cppcolormap::parse_colormaps.
+ */
+enum class colormap_file_format {
+    csv_table, ///< Rows of RGB(A) or hex colours, separated by comma, semicolon, tab, or space.
+    gmt_cpt, ///< GMT colour palette table (``.cpt``), RGB only.
+    paraview_xml, ///< ParaView XML (``<ColorMap name=".."><Point x r g b/>..``).
+    json ///< ParaView JSON (``RGBPoints``, ``IndexedColors``) or lists of colours.
+};
+
+/**
+ * Colormap read from file: colours at increasing positions in [0, 1].
+ */
+struct ParsedColormap {
+    std::string name; ///< Name.
+    std::vector<double> x; ///< Position of each colour (empty if uniformly spaced).
+    array_type::tensor<double, 2> colors; ///< Colours [n, 3] or [n, 4] in [0, 1].
+
+    /**
+     * Default number of colours: the number of rows for a table,
+     * 256 for a colormap defined by control points.
+     */
+    size_t size() const
+    {
+        return x.empty() ? colors.shape(0) : 256;
+    }
+
+    /**
+     * Colormap with `N` colours. Tables are interpolated as for the colormaps of this library,
+     * control points are interpolated (linearly, in RGB) at uniformly spaced positions.
+     *
+     * @param N Number of colours.
+     * @return Colours [N, 3] or [N, 4].
+     */
+    array_type::tensor<double, 2> operator()(size_t N) const
+    {
+        if (x.empty()) {
+            return interp(colors, N);
+        }
+
+        size_t n = x.size();
+        size_t m = colors.shape(1);
+        array_type::tensor<double, 2> ret = xt::empty<double>({N, m});
+
+        for (size_t i = 0, k = 0; i < N; ++i) {
+            double t = N > 1 ? static_cast<double>(i) / static_cast<double>(N - 1) : 0.0;
+
+            while (k + 2 < n && x[k + 1] <= t) {
+                k++;
+            }
+
+            double w = 1.0;
+
+            if (n > 1 && x[k + 1] > x[k]) {
+                w = std::min(std::max((t - x[k]) / (x[k + 1] - x[k]), 0.0), 1.0);
+            }
+
+            size_t l = std::min(k + 1, n - 1);
+
+            for (size_t j = 0; j < m; ++j) {
+                ret(i, j) = (1.0 - w) * colors(k, j) + w * colors(l, j);
+            }
+        }
+
+        return ret;
+    }
+};
+
+namespace detail {
+
+inline bool loader_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * Parse a number at `p` (advanced past it), without allocating.
+ */
+inline bool parse_double(const char*& p, const char* end, double& out)
+{
+    if (p < end && *p == '+') {
+        ++p;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto res = std::from_chars(p, end, out);
+
+    if (res.ec != std::errc()) {
+        return false;
+    }
+
+    p = res.ptr;
+    return true;
+#else
+    char buf[64];
+    size_t n = 0;
+
+    while (p + n < end && n + 1 < sizeof(buf) &&
+           (std::isdigit(static_cast<unsigned char>(p[n])) || p[n] == '.' || p[n] == '-' ||
+            p[n] == '+' || p[n] == 'e' || p[n] == 'E')) {
+        buf[n] = p[n];
+        ++n;
+    }
+
+    buf[n] = '\0';
+    char* stop = nullptr;
+    out = std::strtod(buf, &stop);
+
+    if (stop == buf) {
+        return false;
+    }
+
+    p += stop - buf;
+    return true;
+#endif
+}
+
+/**
+ * Parse a token that is exactly one number.
+ */
+inline bool parse_double(std::string_view token, double& out)
+{
+    const char* p = token.data();
+    const char* end = p + token.size();
+    return parse_double(p, end, out) && p == end;
+}
+
+inline std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && loader_space(text.front())) {
+        text.remove_prefix(1);
+    }
+
+    while (!text.empty() && loader_space(text.back())) {
+        text.remove_suffix(1);
+    }
+
+    return text;
+}
+
+/**
+ * Next whitespace-separated token of `line` (removed from `line`).
+ */
+inline std::string_view next_token(std::string_view& line)
+{
+    line = trim(line);
+    size_t i = 0;
+
+    while (i < line.size() && !loader_space(line[i])) {
+        ++i;
+    }
+
+    std::string_view ret = line.substr(0, i);
+    line.remove_prefix(i);
+    return ret;
+}
+
+template <class F>
+inline void for_each_line(std::string_view text, F&& func)
+{
+    size_t line = 0;
+
+    while (!text.empty()) {
+        size_t i = std::min(text.find('\n'), text.size());
+        func(trim(text.substr(0, i)), ++line);
+        text.remove_prefix(std::min(i + 1, text.size()));
+    }
+}
+
+/**
+ * Colormap from flat colours `[n, cols]` and (optional) positions, which are normalised to [0, 1].
+ */
+inline ParsedColormap make_colormap(
+    const std::string& name,
+    std::vector<double>&& x,
+    const std::vector<double>& values,
+    size_t cols,
+    const char* format
+)
+{
+    if (cols != 3 && cols != 4) {
+        throw std::runtime_error(std::string(format) + ": colours must have 3 or 4 components");
+    }
+
+    size_t n = values.size() / cols;
+
+    if (n == 0 || values.size() % cols != 0 || (!x.empty() && x.size() != n)) {
+        throw std::runtime_error(std::string(format) + ": invalid colormap \"" + name + "\"");
+    }
+
+    if (!x.empty()) {
+        double lo = x.front();
+        double range = x.back() - lo;
+
+        if (!std::is_sorted(x.begin(), x.end()) || (n > 1 && !(range > 0))) {
+            throw std::runtime_error(std::string(format) + ": positions must increase");
+        }
+
+        for (auto& xi : x) {
+            xi = n > 1 ? (xi - lo) / range : 0.0;
+        }
+    }
+
+    ParsedColormap ret;
+    ret.name = name;
+    ret.x = std::move(x);
+    ret.colors = xt::empty<double>({n, cols});
+    std::copy(values.begin(), values.end(), ret.colors.data());
+    return ret;
+}
+
+/**
+ * Value of attribute `key` of an XML tag (empty if not present).
+ */
+inline std::string_view xml_attribute(std::string_view tag, std::string_view key)
+{
+    for (size_t i = tag.find(key); i != std::string_view::npos; i = tag.find(key, i + 1)) {
+        size_t j = i + key.size();
+
+        if (i == 0 || !loader_space(tag[i - 1])) {
+            continue;
+        }
+
+        while (j < tag.size() && loader_space(tag[j])) {
+            ++j;
+        }
+
+        if (j >= tag.size() || tag[j] != '=') {
+            continue;
+        }
+
+        ++j;
+
+        while (j < tag.size() && loader_space(tag[j])) {
+            ++j;
+        }
+
+        if (j >= tag.size() || (tag[j] != '"' && tag[j] != '\'')) {
+            continue;
+        }
+
+        size_t end = tag.find(tag[j], j + 1);
+
+        if (end == std::string_view::npos) {
+            break;
+        }
+
+        return tag.substr(j + 1, end - j - 1);
+    }
+
+    return std::string_view();
+}
+
+/**
+ * Minimal JSON reader, that extracts colormaps and skips everything else.
+ */
+class json_reader {
+public:
+    explicit json_reader(std::string_view text) : m_p(text.data()), m_end(text.data() + text.size())
+    {
+    }
+
+    /**
+     * Read all colormaps: a list of objects, or one object.
+     * An object is a colormap if it has ``RGBPoints``, ``IndexedColors``, or ``colors``
+     * (with an optional ``Name`` or ``name``). Otherwise each of its members that is a list of
+     * colours is read as colormap, with the key as name.
+     */
+    void read(std::vector<ParsedColormap>& ret)
+    {
+        ws();
+
+        if (peek('[')) {
+            ++m_p;
+            while (!consume(']')) {
+                if (peek('{')) {
+                    object(ret, false);
+                }
+                else {
+                    skip();
+                }
+                consume(',');
+            }
+        }
+        else if (peek('{')) {
+            object(ret, true);
+        }
+        else {
+            fail("expected list or object");
+        }
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what)
+    {
+        throw std::runtime_error("json: " + what);
+    }
+
+    void ws()
+    {
+        while (m_p < m_end && loader_space(*m_p)) {
+            ++m_p;
+        }
+    }
+
+    bool peek(char c)
+    {
+        ws();
+        return m_p < m_end && *m_p == c;
+    }
+
+    bool consume(char c)
+    {
+        if (!peek(c)) {
+            return false;
+        }
+        ++m_p;
+        return true;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c)) {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    std::string string()
+    {
+        expect('"');
+        std::string ret;
+
+        while (m_p < m_end && *m_p != '"') {
+            char c = *m_p++;
+            if (c == '\\' && m_p < m_end) {
+                c = *m_p++;
+                if (c == 'n') {
+                    c = '\n';
+                }
+                else if (c == 't') {
+                    c = '\t';
+                }
+                else if (c == 'u') {
+                    m_p = std::min(m_p + 4, m_end);
+                    c = '?';
+                }
+            }
+            ret.push_back(c);
+        }
+
+        expect('"');
+        return ret;
+    }
+
+    double number()
+    {
+        ws();
+        double ret;
+
+        if (!parse_double(m_p, m_end, ret)) {
+            fail("expected number");
+        }
+
+        return ret;
+    }
+
+    void skip()
+    {
+        ws();
+
+        if (m_p >= m_end) {
+            fail("unexpected end");
+        }
+
+        if (*m_p == '"') {
+            string();
+        }
+        else if (*m_p == '[' || *m_p == '{') {
+            char close = *m_p == '[' ? ']' : '}';
+            ++m_p;
+            while (!consume(close)) {
+                if (close == '}') {
+                    string();
+                    expect(':');
+                }
+                skip();
+                consume(',');
+            }
+        }
+        else if (*m_p == 't' || *m_p == 'f' || *m_p == 'n') {
+            while (m_p < m_end && std::isalpha(static_cast<unsigned char>(*m_p))) {
+                ++m_p;
+            }
+        }
+        else {
+            number();
+        }
+    }
+
+    void numbers(std::vector<double>& out)
+    {
+        expect('[');
+        while (!consume(']')) {
+            out.push_back(number());
+            consume(',');
+        }
+    }
+
+    /**
+     * List of colours: lists of numbers (RGB or RGBA), or hex strings.
+     * Returns `false` (and restores the position) if the value is something else.
+     */
+    bool colors(std::vector<double>& out, size_t& cols)
+    {
+        const char* start = m_p;
+        size_t size = out.size();
+        expect('[');
+
+        while (!consume(']')) {
+            size_t row = out.size();
+            ws();
+            if (peek('[')) {
+                ++m_p;
+                while (!consume(']')) {
+                    ws();
+                    double value;
+                    if (!parse_double(m_p, m_end, value)) {
+                        m_p = start;
+                        out.resize(size);
+                        return false;
+                    }
+                    out.push_back(value);
+                    consume(',');
+                }
+            }
+            else if (peek('"')) {
+                std::string hex = string();
+                double rgba[4];
+                size_t n = cols == 4 || (cols == 0 && hex.size() == 9) ? 4 : 3;
+                if (!parse_hex(hex, rgba, n)) {
+                    m_p = start;
+                    out.resize(size);
+                    return false;
+                }
+                out.insert(out.end(), rgba, rgba + n);
+            }
+            else {
+                m_p = start;
+                out.resize(size);
+                return false;
+            }
+            if (cols == 0) {
+                cols = out.size() - row;
+            }
+            if (out.size() - row != cols) {
+                fail("colours of different size");
+            }
+            consume(',');
+        }
+
+        return out.size() > size;
+    }
+
+    void object(std::vector<ParsedColormap>& ret, bool top)
+    {
+        expect('{');
+        std::string name;
+        std::vector<double> points;
+        std::vector<double> values;
+        size_t cols = 0;
+        std::vector<ParsedColormap> members;
+
+        while (!consume('}')) {
+            std::string key = string();
+            expect(':');
+
+            if ((key == "Name" || key == "name") && peek('"')) {
+                name = string();
+            }
+            else if (key == "RGBPoints") {
+                numbers(points);
+            }
+            else if (key == "IndexedColors") {
+                numbers(values);
+                cols = 3;
+            }
+            else if (key == "colors" || key == "Colors") {
+                if (!peek('[') || !colors(values, cols)) {
+                    fail("invalid colours of \"" + name + "\"");
+                }
+            }
+            else if (top && peek('[')) {
+                std::vector<double> v;
+                size_t c = 0;
+                if (colors(v, c)) {
+                    members.push_back(make_colormap(key, {}, v, c, "json"));
+                }
+                else {
+                    skip();
+                }
+            }
+            else {
+                skip();
+            }
+
+            consume(',');
+        }
+
+        if (!points.empty()) {
+            if (points.size() % 4 != 0) {
+                fail("RGBPoints must be [x, r, g, b, ...]");
+            }
+            std::vector<double> x(points.size() / 4);
+            values.resize(3 * x.size());
+            for (size_t i = 0; i < x.size(); ++i) {
+                x[i] = points[4 * i];
+                std::copy(&points[4 * i + 1], &points[4 * i + 4], &values[3 * i]);
+            }
+            ret.push_back(make_colormap(name, std::move(x), values, 3, "json"));
+        }
+        else if (!values.empty()) {
+            ret.push_back(make_colormap(name, {}, values, cols, "json"));
+        }
+        else {
+            for (auto& member : members) {
+                ret.push_back(std::move(member));
+            }
+        }
+    }
+
+    const char* m_p;
+    const char* m_end;
+};
+
+inline ParsedColormap parse_csv(std::string_view text, const std::string& name)
+{
+    std::vector<double> values;
+    size_t lines = static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1;
+    values.reserve(4 * lines);
+    size_t cols = 0;
+    double vmax = 0.0;
+
+    for_each_line(text, [&](std::string_view line, size_t i) {
+        size_t row = values.size();
+
+        if (line.empty()) {
+            return;
+        }
+
+        if (line[0] == '#') {
+            size_t n = 0;
+            while (n + 1 < line.size() && std::isxdigit(static_cast<unsigned char>(line[n + 1]))) {
+                ++n;
+            }
+            double rgba[4];
+            size_t m = n == 8 ? 4 : 3;
+            if (!parse_hex(line.substr(0, n + 1), rgba, m)) {
+                return; // comment
+            }
+            values.insert(values.end(), rgba, rgba + m);
+        }
+        else {
+            const char* p = line.data();
+            const char* end = p + line.size();
+
+            while (p < end && *p != '#') {
+                double value;
+                if (!parse_double(p, end, value)) {
+                    if (values.empty()) {
+                        return; // header
+                    }
+                    throw std::runtime_error("csv: invalid number on line " + std::to_string(i));
+                }
+                values.push_back(value);
+                vmax = std::max(vmax, value);
+                while (p < end && (loader_space(*p) || *p == ',' || *p == ';')) {
+                    ++p;
+                }
+            }
+        }
+
+        if (cols == 0) {
+            cols = values.size() - row;
+        }
+
+        if (values.size() - row != cols) {
+            throw std::runtime_error(
+                "csv: inconsistent number of columns on line " + std::to_string(i)
+            );
+        }
+    });
+
+    // 8-bit tables
+    if (vmax > 1.0) {
+        for (auto& value : values) {
+            value /= 255.0;
+        }
+    }
+
+    return make_colormap(name, {}, values, cols, "csv");
+}
+
+inline ParsedColormap parse_cpt(std::string_view text, const std::string& name)
+{
+    std::vector<double> x;
+    std::vector<double> values;
+
+    auto color = [&](std::string_view& line, size_t i) {
+        std::string_view token = next_token(line);
+        double rgb[3];
+
+        if (!token.empty() && token[0] == '#') {
+            if (!parse_hex(token, rgb, 3)) {
+                throw std::runtime_error("cpt: invalid colour on line " + std::to_string(i));
+            }
+            values.insert(values.end(), rgb, rgb + 3);
+            return;
+        }
+
+        size_t slash = token.find('/');
+
+        for (size_t k = 0; k < 3; ++k) {
+            std::string_view value = token;
+            if (slash != std::string_view::npos) {
+                size_t end = std::min(token.find('/'), token.size());
+                value = token.substr(0, end);
+                token.remove_prefix(std::min(end + 1, token.size()));
+            }
+            else if (k > 0) {
+                value = next_token(line);
+            }
+            if (!parse_double(value, rgb[k])) {
+                throw std::runtime_error("cpt: invalid colour on line " + std::to_string(i));
+            }
+            values.push_back(rgb[k] / 255.0);
+        }
+    };
+
+    for_each_line(text, [&](std::string_view line, size_t i) {
+        if (line.empty() || line[0] == 'B' || line[0] == 'F' || line[0] == 'N') {
+            return;
+        }
+
+        if (line[0] == '#') {
+            if (line.find("COLOR_MODEL") != std::string_view::npos &&
+                line.find("RGB") == std::string_view::npos &&
+                line.find("rgb") == std::string_view::npos) {
+                throw std::runtime_error("cpt: only the RGB colour model is supported");
+            }
+            return;
+        }
+
+        for (size_t k = 0; k < 2; ++k) {
+            double z;
+            if (!parse_double(next_token(line), z)) {
+                throw std::runtime_error("cpt: invalid z-value on line " + std::to_string(i));
+            }
+            x.push_back(z);
+            color(line, i);
+        }
+    });
+
+    return make_colormap(name, std::move(x), values, 3, "cpt");
+}
+
+inline std::vector<ParsedColormap> parse_paraview_xml(std::string_view text)
+{
+    std::vector<ParsedColormap> ret;
+    size_t pos = 0;
+
+    while ((pos = text.find("<ColorMap", pos)) != std::string_view::npos) {
+        size_t open = text.find('>', pos);
+
+        if (open == std::string_view::npos) {
+            throw std::runtime_error("xml: unterminated tag");
+        }
+
+        std::string_view tag = text.substr(pos, open - pos);
+        pos = open;
+
+        if (tag.size() > 9 && !loader_space(tag[9])) {
+            continue; // e.g. <ColorMaps>
+        }
+
+        size_t close = std::min(text.find("</ColorMap>", open), text.size());
+        std::string_view body = text.substr(open, close - open);
+        std::vector<double> x;
+        std::vector<double> values;
+
+        for (size_t p = body.find("<Point"); p != std::string_view::npos;
+             p = body.find("<Point", p + 1)) {
+            std::string_view point = body.substr(p, body.find('>', p) - p);
+            double v[4];
+            const char* keys[] = {"x", "r", "g", "b"};
+            for (size_t k = 0; k < 4; ++k) {
+                if (!parse_double(xml_attribute(point, keys[k]), v[k])) {
+                    throw std::runtime_error("xml: invalid Point");
+                }
+            }
+            x.push_back(v[0]);
+            values.insert(values.end(), v + 1, v + 4);
+        }
+
+        ret.push_back(
+            make_colormap(std::string(xml_attribute(tag, "name")), std::move(x), values, 3, "xml")
+        );
+    }
+
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * Format of a colormap file from its extension:
+ * ``.csv``, ``.tsv``, ``.txt`` (colormap_file_format::csv_table), ``.cpt``, ``.xml``, ``.json``.
+ *
+ * @param path Path of the file.
+ * @return Format.
+ * @throw std::invalid_argument if the extension is not recognised.
+ */
+inline colormap_file_format colormap_file_format_from_path(const std::string& path)
+{
+    size_t i = path.rfind('.');
+    std::string ext = i == std::string::npos ? "" : path.substr(i + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+
+    if (ext == "csv" || ext == "tsv" || ext == "txt") {
+        return colormap_file_format::csv_table;
+    }
+    if (ext == "cpt") {
+        return colormap_file_format::gmt_cpt;
+    }
+    if (ext == "xml") {
+        return colormap_file_format::paraview_xml;
+    }
+    if (ext == "json") {
+        return colormap_file_format::json;
+    }
+
+    throw std::invalid_argument("Unknown colormap format of \"" + path + "\"");
+}
+
+/**
+ * Parse colormaps from text.
+ * Tables of 8-bit values (any value > 1) are scaled to [0, 1].
+ * Colormaps without a name get `name` (suffixed by their position if there are several).
+ *
+ * @param text File content.
+ * @param format File format.
+ * @param name Name of colormaps that are not named in the file.
+ * @return Colormaps.
+ * @throw std::runtime_error if the text cannot be parsed.
+ */
+inline std::vector<ParsedColormap>
+parse_colormaps(std::string_view text, colormap_file_format format, const std::string& name)
+{
+    std::vector<ParsedColormap> ret;
+
+    switch (format) {
+    case colormap_file_format::csv_table:
+        ret.push_back(detail::parse_csv(text, name));
+        break;
+    case colormap_file_format::gmt_cpt:
+        ret.push_back(detail::parse_cpt(text, name));
+        break;
+    case colormap_file_format::paraview_xml:
+        ret = detail::parse_paraview_xml(text);
+        break;
+    case colormap_file_format::json:
+        detail::json_reader(text).read(ret);
+        break;
+    }
+
+    if (ret.empty()) {
+        throw std::runtime_error("No colormaps found in \"" + name + "\"");
+    }
+
+    for (size_t i = 0; i < ret.size(); ++i) {
+        if (ret[i].name.empty()) {
+            ret[i].name = ret.size() > 1 ? name + "_" + std::to_string(i) : name;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Read colormaps from a (memory-mapped) file, see cppcolormap::parse_colormaps.
+ * Colormaps that are not named in the file are named after the file (without extension).
+ *
+ * @param path Path of the file, its extension sets the format,
+ *      see cppcolormap::colormap_file_format_from_path.
+ * @return Colormaps.
+ * @throw std::runtime_error if the file cannot be read or parsed.
+ */
+inline std::vector<ParsedColormap> read_colormaps(const std::string& path)
+{
+    colormap_file_format format = colormap_file_format_from_path(path);
+    size_t begin = path.find_last_of("/\\");
+    begin = begin == std::string::npos ? 0 : begin + 1;
+    std::string stem = path.substr(begin, path.rfind('.') - begin);
+    auto map = MemoryMap::open_file(path);
+    return parse_colormaps(std::string_view(map.data(), map.size()), format, stem);
+}
+
+/**
+ * Read colormaps from file and add them to the registry, such that they are available by name
+ * from cppcolormap::colormap (existing colormaps with the same name are replaced).
+ *
+ * @param path Path of the file, see cppcolormap::read_colormaps.
+ * @return Names of the registered colormaps.
+ * @throw std::runtime_error if the file cannot be read or parsed.
+ */
+inline std::vector<std::string> load_colormaps(const std::string& path)
+{
+    std::vector<std::string> ret;
+
+    for (auto& cmap : read_colormaps(path)) {
+        ret.push_back(cmap.name);
+        size_t N = cmap.size();
+        register_colormap(ret.back(), [cmap = std::move(cmap)](size_t n) { return cmap(n); }, N);
+    }
+
+    return ret;
+}
+
+} // namespace cppcolormap
+
+#endif
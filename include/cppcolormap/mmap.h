@@ -0,0 +1,458 @@
+/**
+ * Memory mapping of files and of named shared-memory objects.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_MMAP_H
+#define CPPCOLORMAP_MMAP_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cppcolormap {
+
+/**
+ * Memory mapping of a file, or of a named shared-memory object
+ * (POSIX `shm_open`, or a named file mapping on Windows).
+ * The mapping is released on destruction.
+ *
+ * Note that on Windows a named shared-memory object only exists as long as it is mapped
+ * by at least one process.
+ */
+class MemoryMap {
+public:
+    MemoryMap() = default;
+
+    MemoryMap(const MemoryMap&) = delete;
+    MemoryMap& operator=(const MemoryMap&) = delete;
+
+    MemoryMap(MemoryMap&& other) noexcept
+    {
+        swap(other);
+    }
+
+    MemoryMap& operator=(MemoryMap&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~MemoryMap()
+    {
+        release();
+    }
+
+    /**
+     * Map an existing file read-only.
+     *
+     * @param path Path of the file.
+     * @return Mapping.
+     * @throw std::runtime_error if the file cannot be opened or mapped.
+     */
+    static MemoryMap open_file(const std::string& path)
+    {
+        MemoryMap ret;
+        ret.map_file(path, 0, false);
+        return ret;
+    }
+
+    /**
+     * Create (or truncate) a file of a given size and map it read-write.
+     *
+     * @param path Path of the file.
+     * @param size Size in bytes.
+     * @return Mapping.
+     * @throw std::runtime_error if the file cannot be created or mapped.
+     */
+    static MemoryMap create_file(const std::string& path, size_t size)
+    {
+        MemoryMap ret;
+        ret.map_file(path, size, true);
+        return ret;
+    }
+
+    /**
+     * Map an existing named shared-memory object read-only.
+     *
+     * @param name Name of the object (a leading `/` is added on POSIX systems if needed).
+     * @return Mapping.
+     * @throw std::runtime_error if the object does not exist or cannot be mapped.
+     */
+    static MemoryMap open_shared(const std::string& name)
+    {
+        MemoryMap ret;
+        ret.map_shared(name, 0, false);
+        return ret;
+    }
+
+    /**
+     * Create a named shared-memory object of a given size and map it read-write.
+     *
+     * @param name Name of the object (a leading `/` is added on POSIX systems if needed).
+     * @param size Size in bytes.
+     * @return Mapping.
+     * @throw std::runtime_error if the object already exists or cannot be created.
+     */
+    static MemoryMap create_shared(const std::string& name, size_t size)
+    {
+        MemoryMap ret;
+        ret.map_shared(name, size, true);
+        return ret;
+    }
+
+    /**
+     * Remove a named shared-memory object.
+     * Existing mappings stay valid. No-op on Windows (where the object is removed
+     * when it is no longer mapped).
+     *
+     * @param name Name of the object.
+     * @return `true` if the object was removed.
+     */
+    static bool remove_shared(const std::string& name)
+    {
+#ifdef _WIN32
+        (void)name;
+        return false;
+#else
+        return ::shm_unlink(shared_name(name).c_str()) == 0;
+#endif
+    }
+
+    /**
+     * Check if two paths refer to the same existing file (e.g. via a different path or a link).
+     *
+     * @param a Path of a file.
+     * @param b Path of a file.
+     * @return `true` if both files exist and are the same file.
+     */
+    static bool same_file(const std::string& a, const std::string& b)
+    {
+#ifdef _WIN32
+        auto info = [](const std::string& path, BY_HANDLE_FILE_INFORMATION& ret) {
+            HANDLE file = ::CreateFileA(
+                path.c_str(),
+                0,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS,
+                nullptr
+            );
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            bool ok = ::GetFileInformationByHandle(file, &ret) != 0;
+            ::CloseHandle(file);
+            return ok;
+        };
+        BY_HANDLE_FILE_INFORMATION x;
+        BY_HANDLE_FILE_INFORMATION y;
+        return info(a, x) && info(b, y) && x.dwVolumeSerialNumber == y.dwVolumeSerialNumber &&
+               x.nFileIndexHigh == y.nFileIndexHigh && x.nFileIndexLow == y.nFileIndexLow;
+#else
+        struct stat x;
+        struct stat y;
+        return ::stat(a.c_str(), &x) == 0 && ::stat(b.c_str(), &y) == 0 && x.st_dev == y.st_dev &&
+               x.st_ino == y.st_ino;
+#endif
+    }
+
+    /**
+     * Pointer to the mapped memory.
+     */
+    const char* data() const
+    {
+        return static_cast<const char*>(m_data);
+    }
+
+    /**
+     * Pointer to the mapped memory (only writable for mappings that are created).
+     */
+    char* data()
+    {
+        return static_cast<char*>(m_data);
+    }
+
+    /**
+     * Size of the mapped memory in bytes.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * `true` if the mapping is writable.
+     */
+    bool writable() const
+    {
+        return m_writable;
+    }
+
+private:
+    void swap(MemoryMap& other) noexcept
+    {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_writable, other.m_writable);
+#ifdef _WIN32
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+#endif
+    }
+
+#ifdef _WIN32
+
+    [[noreturn]] static void fail(const std::string& what, const std::string& name)
+    {
+        DWORD err = ::GetLastError();
+        throw std::runtime_error(
+            what + " \"" + name + "\" failed (error " + std::to_string(err) + ")"
+        );
+    }
+
+    void map_view(const std::string& name)
+    {
+        DWORD access = m_writable ? FILE_MAP_WRITE : FILE_MAP_READ;
+        m_data = ::MapViewOfFile(m_mapping, access, 0, 0, m_size);
+
+        if (!m_data) {
+            fail("MapViewOfFile", name);
+        }
+
+        if (m_size == 0) {
+            MEMORY_BASIC_INFORMATION info;
+            ::VirtualQuery(m_data, &info, sizeof(info));
+            m_size = static_cast<size_t>(info.RegionSize);
+        }
+    }
+
+    void map_file(const std::string& path, size_t size, bool create)
+    {
+        m_writable = create;
+        DWORD access = create ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+        DWORD disposition = create ? CREATE_ALWAYS : OPEN_EXISTING;
+        m_file = ::CreateFileA(
+            path.c_str(),
+            access,
+            FILE_SHARE_READ,
+            nullptr,
+            disposition,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+
+        if (m_file == INVALID_HANDLE_VALUE) {
+            fail("CreateFile", path);
+        }
+
+        if (!create) {
+            LARGE_INTEGER s;
+            ::GetFileSizeEx(m_file, &s);
+            size = static_cast<size_t>(s.QuadPart);
+        }
+
+        m_size = size;
+
+        if (size == 0) {
+            return;
+        }
+
+        DWORD protect = create ? PAGE_READWRITE : PAGE_READONLY;
+        m_mapping = ::CreateFileMappingA(
+            m_file,
+            nullptr,
+            protect,
+            static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32),
+            static_cast<DWORD>(size & 0xFFFFFFFF),
+            nullptr
+        );
+
+        if (!m_mapping) {
+            fail("CreateFileMapping", path);
+        }
+
+        map_view(path);
+    }
+
+    void map_shared(const std::string& name, size_t size, bool create)
+    {
+        m_writable = create;
+
+        if (create) {
+            m_mapping = ::CreateFileMappingA(
+                INVALID_HANDLE_VALUE,
+                nullptr,
+                PAGE_READWRITE,
+                static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32),
+                static_cast<DWORD>(size & 0xFFFFFFFF),
+                name.c_str()
+            );
+            if (m_mapping && ::GetLastError() == ERROR_ALREADY_EXISTS) {
+                ::CloseHandle(m_mapping);
+                m_mapping = nullptr;
+                throw std::runtime_error("Shared memory \"" + name + "\" already exists");
+            }
+        }
+        else {
+            m_mapping = ::OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+        }
+
+        if (!m_mapping) {
+            fail("Shared memory", name);
+        }
+
+        m_size = size;
+        map_view(name);
+    }
+
+    void release()
+    {
+        if (m_data) {
+            ::UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            ::CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            ::CloseHandle(m_file);
+        }
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+        m_size = 0;
+    }
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+
+#else
+
+    [[noreturn]] static void fail(const std::string& what, const std::string& name, int err)
+    {
+        throw std::runtime_error(what + " \"" + name + "\" failed: " + std::strerror(err));
+    }
+
+    static std::string shared_name(const std::string& name)
+    {
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+
+    void map_fd(int fd, size_t size, bool create, const std::string& name)
+    {
+        if (create) {
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                int err = errno;
+                ::close(fd);
+                fail("Resizing", name, err);
+            }
+        }
+        else {
+            struct stat s;
+            if (::fstat(fd, &s) != 0) {
+                int err = errno;
+                ::close(fd);
+                fail("Reading size of", name, err);
+            }
+            size = static_cast<size_t>(s.st_size);
+        }
+
+        m_size = size;
+        m_writable = create;
+
+        if (size == 0) {
+            ::close(fd);
+            return;
+        }
+
+        int prot = create ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* data = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+
+        if (data == MAP_FAILED) {
+            m_size = 0;
+            fail("Mapping", name, err);
+        }
+
+        m_data = data;
+    }
+
+    void map_file(const std::string& path, size_t size, bool create)
+    {
+        int flags = create ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY;
+        int fd = ::open(path.c_str(), flags, 0644);
+
+        if (fd < 0) {
+            fail("Opening", path, errno);
+        }
+
+        map_fd(fd, size, create, path);
+    }
+
+    void map_shared(const std::string& name, size_t size, bool create)
+    {
+        std::string n = shared_name(name);
+        int flags = create ? O_RDWR | O_CREAT | O_EXCL : O_RDONLY;
+        int fd = ::shm_open(n.c_str(), flags, 0644);
+
+        if (fd < 0) {
+            fail("Opening shared memory", n, errno);
+        }
+
+        if (!create) {
+            map_fd(fd, size, create, n);
+            return;
+        }
+
+        // do not leave behind a (partially) created object that blocks a next attempt
+        try {
+            map_fd(fd, size, create, n);
+        }
+        catch (...) {
+            ::shm_unlink(n.c_str());
+            throw;
+        }
+    }
+
+    void release()
+    {
+        if (m_data) {
+            ::munmap(m_data, m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+#endif
+
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_writable = false;
+};
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,571 @@
+/**
+ * Conversion of (memory-mapped) NumPy ``.npy`` files to colours, without loading them in memory.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_NPY_H
+#define CPPCOLORMAP_NPY_H
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../cppcolormap.h"
+#include "mmap.h"
+
+namespace cppcolormap {
+
+namespace detail {
+
+/**
+ * Parse the decimal number at `str[i]`, advancing `i` past it.
+ *
+ * @throw std::runtime_error if the number does not fit in `size_t`.
+ */
+inline size_t npy_parse_size(const std::string& str, size_t& i)
+{
+    size_t ret = 0;
+
+    for (; i < str.size() && std::isdigit(static_cast<unsigned char>(str[i])); ++i) {
+        size_t digit = static_cast<size_t>(str[i] - '0');
+        if (ret > (std::numeric_limits<size_t>::max() - digit) / 10) {
+            throw std::runtime_error("npy: number too large in header");
+        }
+        ret = 10 * ret + digit;
+    }
+
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * Header of a ``.npy`` file.
+ */
+struct NpyHeader {
+    std::string descr; ///< Type of the data, e.g. `"<f8"`.
+    bool fortran_order = false; ///< `true` if the data is stored column-major.
+    std::vector<size_t> shape; ///< Shape of the data.
+    size_t offset = 0; ///< Offset of the data in bytes (from the start of the file).
+
+    /**
+     * Number of items.
+     */
+    size_t size() const
+    {
+        size_t ret = 1;
+        for (auto& i : shape) {
+            ret *= i;
+        }
+        return ret;
+    }
+
+    /**
+     * Size of one item in bytes.
+     *
+     * @throw std::runtime_error if the type has no fixed size (e.g. `"|O"`).
+     */
+    size_t itemsize() const
+    {
+        size_t i = 2;
+        size_t ret = descr.size() > 2 ? detail::npy_parse_size(descr, i) : 0;
+
+        if (ret == 0 || i != descr.size()) {
+            throw std::runtime_error("npy: unsupported descr " + descr);
+        }
+
+        return ret;
+    }
+};
+
+namespace detail {
+
+constexpr char npy_magic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+
+template <typename T>
+struct npy_descr;
+
+template <>
+struct npy_descr<float> {
+    static constexpr const char* value = "<f4";
+};
+
+template <>
+struct npy_descr<double> {
+    static constexpr const char* value = "<f8";
+};
+
+template <>
+struct npy_descr<int8_t> {
+    static constexpr const char* value = "|i1";
+};
+
+template <>
+struct npy_descr<uint8_t> {
+    static constexpr const char* value = "|u1";
+};
+
+template <>
+struct npy_descr<int16_t> {
+    static constexpr const char* value = "<i2";
+};
+
+template <>
+struct npy_descr<uint16_t> {
+    static constexpr const char* value = "<u2";
+};
+
+template <>
+struct npy_descr<int32_t> {
+    static constexpr const char* value = "<i4";
+};
+
+template <>
+struct npy_descr<uint32_t> {
+    static constexpr const char* value = "<u4";
+};
+
+template <>
+struct npy_descr<int64_t> {
+    static constexpr const char* value = "<i8";
+};
+
+template <>
+struct npy_descr<uint64_t> {
+    static constexpr const char* value = "<u8";
+};
+
+/**
+ * Value of `key` in the header dictionary (up to the next `,` or `}` outside brackets).
+ */
+inline std::string npy_value(const std::string& dict, const std::string& key)
+{
+    size_t i = dict.find("'" + key + "'");
+
+    if (i == std::string::npos) {
+        throw std::runtime_error("npy: '" + key + "' missing from header");
+    }
+
+    i = dict.find(':', i);
+
+    if (i == std::string::npos) {
+        throw std::runtime_error("npy: invalid header");
+    }
+
+    size_t depth = 0;
+    size_t j = i + 1;
+
+    for (; j < dict.size(); ++j) {
+        if (dict[j] == '(') {
+            depth++;
+        }
+        else if (dict[j] == ')') {
+            depth--;
+        }
+        else if (depth == 0 && (dict[j] == ',' || dict[j] == '}')) {
+            break;
+        }
+    }
+
+    std::string ret = dict.substr(i + 1, j - i - 1);
+    size_t b = ret.find_first_not_of(" ");
+    size_t e = ret.find_last_not_of(" ");
+    return b == std::string::npos ? "" : ret.substr(b, e - b + 1);
+}
+
+/**
+ * Call `func(T())` with `T` the type corresponding to a `.npy` descr.
+ */
+template <class F>
+inline void npy_dispatch(const std::string& descr, F&& func)
+{
+    if (descr == "<f4") {
+        func(float());
+    }
+    else if (descr == "<f8") {
+        func(double());
+    }
+    else if (descr == "|i1") {
+        func(int8_t());
+    }
+    else if (descr == "|u1") {
+        func(uint8_t());
+    }
+    else if (descr == "<i2") {
+        func(int16_t());
+    }
+    else if (descr == "<u2") {
+        func(uint16_t());
+    }
+    else if (descr == "<i4") {
+        func(int32_t());
+    }
+    else if (descr == "<u4") {
+        func(uint32_t());
+    }
+    else if (descr == "<i8") {
+        func(int64_t());
+    }
+    else if (descr == "<u8") {
+        func(uint64_t());
+    }
+    else {
+        throw std::runtime_error("npy: unsupported dtype '" + descr + "'");
+    }
+}
+
+} // namespace detail
+
+/**
+ * Read the header of a ``.npy`` file (format version 1, 2, or 3).
+ *
+ * @param data Start of the file.
+ * @param size Size of the file in bytes.
+ * @return Header.
+ * @throw std::runtime_error if the file is not a valid ``.npy`` file.
+ */
+inline NpyHeader read_npy_header(const char* data, size_t size)
+{
+    if (size < 10 || std::memcmp(data, detail::npy_magic, sizeof(detail::npy_magic)) != 0) {
+        throw std::runtime_error("npy: not a .npy file");
+    }
+
+    const auto* u = reinterpret_cast<const unsigned char*>(data);
+    size_t major = u[6];
+    size_t len;
+    size_t start;
+
+    if (major == 1) {
+        len = static_cast<size_t>(u[8]) | (static_cast<size_t>(u[9]) << 8);
+        start = 10;
+    }
+    else if (major == 2 || major == 3) {
+        if (size < 12) {
+            throw std::runtime_error("npy: truncated header");
+        }
+        len = static_cast<size_t>(u[8]) | (static_cast<size_t>(u[9]) << 8) |
+              (static_cast<size_t>(u[10]) << 16) | (static_cast<size_t>(u[11]) << 24);
+        start = 12;
+    }
+    else {
+        throw std::runtime_error("npy: unsupported version " + std::to_string(major));
+    }
+
+    if (start + len > size) {
+        throw std::runtime_error("npy: truncated header");
+    }
+
+    std::string dict(data + start, len);
+    NpyHeader ret;
+    ret.offset = start + len;
+
+    std::string descr = detail::npy_value(dict, "descr");
+
+    if (descr.size() < 3 || (descr.front() != '\'' && descr.front() != '"')) {
+        throw std::runtime_error("npy: unsupported descr " + descr);
+    }
+
+    ret.descr = descr.substr(1, descr.size() - 2);
+
+    if (!ret.descr.empty() && ret.descr[0] == '=') {
+        ret.descr[0] = ret.itemsize() == 1 ? '|' : '<';
+    }
+
+    ret.fortran_order = detail::npy_value(dict, "fortran_order") == "True";
+
+    std::string shape = detail::npy_value(dict, "shape");
+    size_t i = 0;
+
+    while (i < shape.size()) {
+        if (std::isdigit(static_cast<unsigned char>(shape[i]))) {
+            ret.shape.push_back(detail::npy_parse_size(shape, i));
+        }
+        else {
+            ++i;
+        }
+    }
+
+    // "offset + size() * itemsize() <= size", without overflow
+    size_t bytes = ret.itemsize();
+    size_t available = size - ret.offset;
+
+    if (std::find(ret.shape.begin(), ret.shape.end(), size_t(0)) != ret.shape.end()) {
+        bytes = 0;
+    }
+
+    for (size_t n : ret.shape) {
+        if (n > 0 && bytes > available / n) {
+            throw std::runtime_error("npy: data truncated");
+        }
+        bytes *= n;
+    }
+
+    if (bytes > available) {
+        throw std::runtime_error("npy: data truncated");
+    }
+
+    return ret;
+}
+
+/**
+ * Header of a ``.npy`` file (format version 1.0), padded such that the data is 64-byte aligned.
+ *
+ * @param descr Type of the data, e.g. `"|u1"`.
+ * @param shape Shape of the data.
+ * @return Header (including magic).
+ */
+inline std::string npy_header(const std::string& descr, const std::vector<size_t>& shape)
+{
+    std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (";
+
+    for (size_t i = 0; i < shape.size(); ++i) {
+        dict += std::to_string(shape[i]) + (shape.size() == 1 || i + 1 < shape.size() ? "," : "");
+        if (i + 1 < shape.size()) {
+            dict += " ";
+        }
+    }
+
+    dict += "), }";
+    size_t len = 10 + dict.size() + 1;
+    dict += std::string((64 - len % 64) % 64, ' ') + "\n";
+
+    std::string ret(detail::npy_magic, sizeof(detail::npy_magic));
+    ret += '\x01';
+    ret += '\x00';
+    ret += static_cast<char>(dict.size() & 0xFF);
+    ret += static_cast<char>((dict.size() >> 8) & 0xFF);
+    return ret + dict;
+}
+
+/**
+ * Memory-mapped ``.npy`` file.
+ */
+class NpyFile {
+public:
+    NpyFile() = default;
+
+    /**
+     * Map an existing file read-only.
+     *
+     * @param path Path of the file.
+     * @return Mapping.
+     * @throw std::runtime_error if the file cannot be mapped or is not a valid ``.npy`` file.
+     */
+    static NpyFile open(const std::string& path)
+    {
+        NpyFile ret;
+        ret.m_map = MemoryMap::open_file(path);
+        ret.m_header = read_npy_header(ret.m_map.data(), ret.m_map.size());
+        return ret;
+    }
+
+    /**
+     * Create (or overwrite) a file and map it read-write.
+     *
+     * @param path Path of the file.
+     * @param shape Shape of the data.
+     * @return Mapping.
+     * @throw std::runtime_error if the file cannot be created.
+     */
+    template <typename T>
+    static NpyFile create(const std::string& path, const std::vector<size_t>& shape)
+    {
+        NpyFile ret;
+        std::string header = npy_header(detail::npy_descr<T>::value, shape);
+        ret.m_header.descr = detail::npy_descr<T>::value;
+        ret.m_header.shape = shape;
+        ret.m_header.offset = header.size();
+        size_t size = header.size() + ret.m_header.size() * sizeof(T);
+        ret.m_map = MemoryMap::create_file(path, size);
+        std::memcpy(ret.m_map.data(), header.data(), header.size());
+        return ret;
+    }
+
+    /**
+     * Header.
+     */
+    const NpyHeader& header() const
+    {
+        return m_header;
+    }
+
+    /**
+     * Pointer to the data.
+     *
+     * @throw std::runtime_error if `T` does not correspond to the type of the data.
+     */
+    template <typename T>
+    const T* data() const
+    {
+        check<T>();
+        return reinterpret_cast<const T*>(m_map.data() + m_header.offset);
+    }
+
+    /**
+     * Pointer to the data (only for files that are created).
+     *
+     * @throw std::runtime_error if `T` does not correspond to the type of the data.
+     */
+    template <typename T>
+    T* data()
+    {
+        check<T>();
+        return reinterpret_cast<T*>(m_map.data() + m_header.offset);
+    }
+
+private:
+    template <typename T>
+    void check() const
+    {
+        if (m_header.descr != detail::npy_descr<T>::value) {
+            throw std::runtime_error("npy: data is of type '" + m_header.descr + "'");
+        }
+    }
+
+    MemoryMap m_map;
+    NpyHeader m_header;
+};
+
+/**
+ * Lower and upper limit of data, ignoring non-finite values (parallel).
+ *
+ * @param data Pointer to the data.
+ * @param n Number of data-points.
+ * @return (min, max); `(0, 1)` if there are no finite values.
+ */
+template <typename T>
+inline std::pair<double, double> limits(const T* data, size_t n)
+{
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+    std::mutex mutex;
+
+    detail::parallel_for(n, get_parallel_grain(), [&](size_t begin, size_t end) {
+        double l = std::numeric_limits<double>::infinity();
+        double h = -std::numeric_limits<double>::infinity();
+        for (size_t i = begin; i < end; ++i) {
+            double v = static_cast<double>(data[i]);
+            if (std::isfinite(v)) {
+                l = v < l ? v : l;
+                h = v > h ? v : h;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        lo = l < lo ? l : lo;
+        hi = h > hi ? h : hi;
+    });
+
+    if (lo > hi) {
+        return {0.0, 1.0};
+    }
+
+    return {lo, hi};
+}
+
+/**
+ * Lower and upper limit of the data in a ``.npy`` file, ignoring non-finite values.
+ *
+ * @param file Input.
+ * @return (min, max); `(0, 1)` if there are no finite values.
+ */
+inline std::pair<double, double> limits(const NpyFile& file)
+{
+    std::pair<double, double> ret;
+
+    detail::npy_dispatch(file.header().descr, [&](auto tag) {
+        using T = decltype(tag);
+        ret = limits(file.data<T>(), file.header().size());
+    });
+
+    return ret;
+}
+
+/**
+ * Convert the data in a ``.npy`` file to colours, written to a ``.npy`` file of shape
+ * `[..., colors.channels()]`. Both files are memory-mapped: the mapping runs directly over the
+ * mapped pages, such that no copy of either is made in memory.
+ * Only C-ordered little-endian integer and floating-point data is supported.
+ *
+ * @param input Path of the input file.
+ * @param output Path of the output file (overwritten if it exists).
+ * @param colors Colormap, e.g. ``cppcolormap::CompiledColormap<uint8_t>(cppcolormap::jet())``.
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis.
+ * @throw std::runtime_error if the input cannot be read, or the output cannot be written.
+ * @throw std::invalid_argument if `vmax <= vmin`, or if `input` and `output` are the same file.
+ */
+template <typename O>
+inline void npy_as_colors(
+    const std::string& input,
+    const std::string& output,
+    const CompiledColormap<O>& colors,
+    double vmin,
+    double vmax
+)
+{
+    if (!(vmax > vmin)) {
+        throw std::invalid_argument("npy: expected vmax > vmin");
+    }
+
+    // creating the output would truncate the (mapped) input
+    if (MemoryMap::same_file(input, output)) {
+        throw std::invalid_argument("npy: input and output are the same file");
+    }
+
+    NpyFile in = NpyFile::open(input);
+
+    if (in.header().fortran_order && in.header().shape.size() > 1) {
+        throw std::runtime_error("npy: Fortran-ordered data is not supported");
+    }
+
+    std::vector<size_t> shape = in.header().shape;
+    shape.push_back(colors.channels());
+    NpyFile out = NpyFile::create<O>(output, shape);
+    size_t n = in.header().size();
+
+    detail::npy_dispatch(in.header().descr, [&](auto tag) {
+        using T = decltype(tag);
+        as_colors(in.data<T>(), n, 1, colors, vmin, vmax, out.data<O>());
+    });
+}
+
+/**
+ * Convert the data in a ``.npy`` file to colours, using the limits of the data as colour-axis
+ * (see cppcolormap::limits).
+ *
+ * @param input Path of the input file.
+ * @param output Path of the output file (overwritten if it exists).
+ * @param colors Colormap, e.g. ``cppcolormap::CompiledColormap<uint8_t>(cppcolormap::jet())``.
+ * @return The limits (vmin, vmax) that were used.
+ */
+template <typename O>
+inline std::pair<double, double> npy_as_colors(
+    const std::string& input,
+    const std::string& output,
+    const CompiledColormap<O>& colors
+)
+{
+    std::pair<double, double> ret = limits(NpyFile::open(input));
+
+    if (!(ret.second > ret.first)) {
+        ret.second = ret.first + 1.0;
+    }
+
+    npy_as_colors(input, output, colors, ret.first, ret.second);
+    return ret;
+}
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,384 @@
+/**
+ * Binary colormap packs: many colormaps in one file that is memory-mapped and registered
+ * without parsing, see cppcolormap::ColormapPack.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_PACK_H
+#define CPPCOLORMAP_PACK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../cppcolormap.h"
+#include "mmap.h"
+
+namespace cppcolormap {
+
+namespace detail {
+
+constexpr char pack_magic[8] = {'C', 'M', 'A', 'P', 'P', 'A', 'C', 'K'};
+constexpr uint32_t pack_version = 1;
+constexpr size_t pack_header_size = 64;
+constexpr size_t pack_entry_size = 32;
+constexpr size_t pack_align = 64;
+
+template <typename T>
+inline T pack_read(const char* p)
+{
+    T ret;
+    std::memcpy(&ret, p, sizeof(T));
+    return ret;
+}
+
+template <typename T>
+inline void pack_write(std::vector<char>& out, size_t offset, T value)
+{
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+inline size_t pack_round(size_t offset)
+{
+    return (offset + pack_align - 1) / pack_align * pack_align;
+}
+
+} // namespace detail
+
+/**
+ * Colormap stored in a cppcolormap::ColormapPack (pointing into the mapped file).
+ */
+struct ColormapPackEntry {
+    const char* name; ///< Name (not null-terminated).
+    size_t name_size; ///< Number of characters of the name.
+    size_t rows; ///< Number of colours (the default number of colours when registered).
+    size_t cols; ///< Number of channels: 3 (RGB) or 4 (RGBA).
+    bool fixed; ///< `true` for color-cycles: the number of colours cannot be changed.
+    const float* colors; ///< Colours `[rows, cols]` in [0, 1], 64-byte aligned.
+    const uint8_t* colors8; ///< Colours `[rows, cols]` as 8-bit sRGB, 64-byte aligned.
+
+    /**
+     * Colours as array, with (`fixed == false`) a different number of colours
+     * interpolated as for the colormaps of this library.
+     *
+     * @param N Number of colours (ignored for color-cycles).
+     * @return Colours `[N, cols]`.
+     */
+    array_type::tensor<double, 2> colormap(size_t N) const
+    {
+        array_type::tensor<double, 2> ret = xt::empty<double>({rows, cols});
+        std::copy(colors, colors + rows * cols, ret.data());
+
+        if (fixed || N == rows) {
+            return ret;
+        }
+
+        return interp(ret, N);
+    }
+};
+
+/**
+ * Read-only, memory-mapped, pack of colormaps.
+ *
+ * The file (little-endian, version 1) consists of:
+ *
+ *  -   A header of 64 bytes: the magic ``CMAPPACK``, `uint32` version, `uint32` number of
+ *      colormaps, `uint64` offset of the index, `uint64` offset of the names,
+ *      `uint64` size of the file, (zero) padding.
+ *
+ *  -   An index, sorted by name, of 32 bytes per colormap: `uint32` offset and `uint32` size
+ *      of the name (relative to the names), `uint32` number of rows,
+ *      `uint16` number of columns, `uint16` flags (bit 0: color-cycle),
+ *      `uint64` offset of the `float32` table, `uint64` offset of the `uint8` table.
+ *
+ *  -   The names (concatenated).
+ *
+ *  -   The tables, each starting at a multiple of 64 bytes.
+ *
+ * Opening a pack only validates the index, the colours are never copied or parsed.
+ * Write a pack using cppcolormap::write_colormap_pack, or the ``cppcolormap-pack`` tool.
+ */
+class ColormapPack {
+public:
+    ColormapPack() = default;
+
+    /**
+     * Map a pack read-only.
+     *
+     * @param path Path of the file.
+     * @return Mapping.
+     * @throw std::runtime_error if the file cannot be mapped or is not a valid pack.
+     */
+    static ColormapPack open(const std::string& path)
+    {
+        ColormapPack ret;
+        ret.m_map = MemoryMap::open_file(path);
+        ret.read_index();
+        return ret;
+    }
+
+    /**
+     * Number of colormaps.
+     */
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * Colormap by position (sorted by name).
+     *
+     * @param i Position.
+     */
+    const ColormapPackEntry& operator[](size_t i) const
+    {
+        return m_entries[i];
+    }
+
+    /**
+     * Position of a colormap (binary search).
+     *
+     * @param name Name of the colormap.
+     * @return Position, or `size()` if the pack does not contain the colormap.
+     */
+    size_t find(const std::string& name) const
+    {
+        auto it = std::lower_bound(
+            m_entries.begin(), m_entries.end(), name, [](const auto& entry, const auto& key) {
+                return key.compare(0, key.size(), entry.name, entry.name_size) > 0;
+            }
+        );
+
+        if (it == m_entries.end() || key_of(*it) != name) {
+            return m_entries.size();
+        }
+
+        return static_cast<size_t>(it - m_entries.begin());
+    }
+
+    /**
+     * Colormap by name.
+     *
+     * @param name Name of the colormap.
+     * @throw std::runtime_error if the pack does not contain the colormap.
+     */
+    const ColormapPackEntry& at(const std::string& name) const
+    {
+        size_t i = find(name);
+
+        if (i == m_entries.size()) {
+            throw std::runtime_error("Colormap not in pack");
+        }
+
+        return m_entries[i];
+    }
+
+    /**
+     * Names of all colormaps (sorted).
+     */
+    std::vector<std::string> names() const
+    {
+        std::vector<std::string> ret;
+        ret.reserve(m_entries.size());
+
+        for (auto& entry : m_entries) {
+            ret.push_back(key_of(entry));
+        }
+
+        return ret;
+    }
+
+private:
+    static std::string key_of(const ColormapPackEntry& entry)
+    {
+        return std::string(entry.name, entry.name_size);
+    }
+
+    [[noreturn]] static void fail(const std::string& what)
+    {
+        throw std::runtime_error("Colormap pack: " + what);
+    }
+
+    void read_index()
+    {
+        const char* p = m_map.data();
+        size_t size = m_map.size();
+
+        if (size < detail::pack_header_size ||
+            std::memcmp(p, detail::pack_magic, sizeof(detail::pack_magic)) != 0) {
+            fail("not a colormap pack");
+        }
+
+        uint32_t version = detail::pack_read<uint32_t>(p + 8);
+
+        if (version != detail::pack_version) {
+            fail("unsupported version " + std::to_string(version));
+        }
+
+        size_t n = detail::pack_read<uint32_t>(p + 12);
+        size_t index = detail::pack_read<uint64_t>(p + 16);
+        size_t names = detail::pack_read<uint64_t>(p + 24);
+
+        if (detail::pack_read<uint64_t>(p + 32) != size || index > size ||
+            n > (size - index) / detail::pack_entry_size || names > size) {
+            fail("truncated");
+        }
+
+        m_entries.resize(n);
+
+        for (size_t i = 0; i < n; ++i) {
+            const char* e = p + index + i * detail::pack_entry_size;
+            ColormapPackEntry& entry = m_entries[i];
+            size_t name = detail::pack_read<uint32_t>(e);
+            entry.name_size = detail::pack_read<uint32_t>(e + 4);
+            entry.rows = detail::pack_read<uint32_t>(e + 8);
+            entry.cols = detail::pack_read<uint16_t>(e + 12);
+            entry.fixed = detail::pack_read<uint16_t>(e + 14) & 1;
+            size_t colors = detail::pack_read<uint64_t>(e + 16);
+            size_t colors8 = detail::pack_read<uint64_t>(e + 24);
+            size_t m = static_cast<size_t>(entry.rows) * entry.cols;
+
+            // written such that no sum or product can wrap: `names <= size` is checked above
+            if (name > size - names || entry.name_size > size - names - name || colors > size ||
+                m > (size - colors) / sizeof(float) || colors8 > size || m > size - colors8) {
+                fail("truncated");
+            }
+
+            if (entry.rows == 0 || (entry.cols != 3 && entry.cols != 4) ||
+                colors % detail::pack_align != 0 || colors8 % detail::pack_align != 0) {
+                fail("invalid index");
+            }
+
+            entry.name = p + names + name;
+            entry.colors = reinterpret_cast<const float*>(p + colors);
+            entry.colors8 = reinterpret_cast<const uint8_t*>(p + colors8);
+
+            if (i > 0 && key_of(m_entries[i - 1]) >= key_of(entry)) {
+                fail("index not sorted");
+            }
+        }
+    }
+
+    MemoryMap m_map;
+    std::vector<ColormapPackEntry> m_entries;
+};
+
+/**
+ * Write colormaps from the registry to a pack, see cppcolormap::ColormapPack.
+ * Each colormap is stored with its default number of colours,
+ * see cppcolormap::registry_entry.
+ *
+ * @param path Path of the pack (overwritten if it exists).
+ * @param names Names of the colormaps (default: all registered colormaps).
+ * @throw std::runtime_error if a colormap is not registered or the file cannot be written.
+ */
+inline void write_colormap_pack(
+    const std::string& path,
+    std::vector<std::string> names = registered_colormaps()
+)
+{
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    size_t n = names.size();
+    size_t index = detail::pack_header_size;
+    size_t offset = index + n * detail::pack_entry_size;
+    size_t text = offset;
+
+    std::vector<array_type::tensor<double, 2>> colors(n);
+    std::vector<bool> fixed(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        ColormapEntry entry = registry_entry(names[i]);
+        size_t N = std::max(entry.N, size_t(1));
+        colors[i] = entry.func(N);
+        fixed[i] = entry.func(N + 1).shape(0) != N + 1;
+        CPPCOLORMAP_ASSERT(colors[i].dimension() == 2);
+        CPPCOLORMAP_ASSERT(colors[i].shape(1) == 3 || colors[i].shape(1) == 4);
+        offset += names[i].size();
+    }
+
+    std::vector<size_t> tables(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        offset = detail::pack_round(offset);
+        tables[i] = offset;
+        offset = detail::pack_round(offset + colors[i].size() * sizeof(float));
+        offset += colors[i].size();
+    }
+
+    std::vector<char> out(detail::pack_round(offset), 0);
+    std::memcpy(out.data(), detail::pack_magic, sizeof(detail::pack_magic));
+    detail::pack_write<uint32_t>(out, 8, detail::pack_version);
+    detail::pack_write<uint32_t>(out, 12, static_cast<uint32_t>(n));
+    detail::pack_write<uint64_t>(out, 16, index);
+    detail::pack_write<uint64_t>(out, 24, text);
+    detail::pack_write<uint64_t>(out, 32, out.size());
+
+    for (size_t i = 0, name = 0; i < n; ++i) {
+        auto& c = colors[i];
+        size_t e = index + i * detail::pack_entry_size;
+        size_t colors8 = detail::pack_round(tables[i] + c.size() * sizeof(float));
+        detail::pack_write<uint32_t>(out, e, static_cast<uint32_t>(name));
+        detail::pack_write<uint32_t>(out, e + 4, static_cast<uint32_t>(names[i].size()));
+        detail::pack_write<uint32_t>(out, e + 8, static_cast<uint32_t>(c.shape(0)));
+        detail::pack_write<uint16_t>(out, e + 12, static_cast<uint16_t>(c.shape(1)));
+        detail::pack_write<uint16_t>(out, e + 14, static_cast<uint16_t>(fixed[i] ? 1 : 0));
+        detail::pack_write<uint64_t>(out, e + 16, tables[i]);
+        detail::pack_write<uint64_t>(out, e + 24, colors8);
+        std::memcpy(out.data() + text + name, names[i].data(), names[i].size());
+        name += names[i].size();
+
+        for (size_t j = 0; j < c.size(); ++j) {
+            float value = static_cast<float>(std::min(std::max(c.flat(j), 0.0), 1.0));
+            detail::pack_write<float>(out, tables[i] + j * sizeof(float), value);
+            out[colors8 + j] = static_cast<char>(detail::srgb_to_srgb8(c.flat(j)));
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    file.close();
+
+    if (!file) {
+        throw std::runtime_error("Cannot write \"" + path + "\"");
+    }
+}
+
+/**
+ * Register all colormaps of a pack, such that they are available by name from
+ * cppcolormap::colormap. Registration is constant time per colormap:
+ * the pack stays mapped and the colours are only read when a colormap is requested.
+ * Existing colormaps with the same names are replaced.
+ *
+ * @param path Path of the pack.
+ * @return Names of the registered colormaps.
+ * @throw std::runtime_error if the file cannot be mapped or is not a valid pack.
+ */
+inline std::vector<std::string> load_colormap_pack(const std::string& path)
+{
+    auto pack = std::make_shared<ColormapPack>(ColormapPack::open(path));
+
+    for (size_t i = 0; i < pack->size(); ++i) {
+        const ColormapPackEntry& entry = (*pack)[i];
+        register_colormap(
+            std::string(entry.name, entry.name_size),
+            [pack, i](size_t N) { return (*pack)[i].colormap(N); },
+            entry.rows
+        );
+    }
+
+    return pack->names();
+}
+
+} // namespace cppcolormap
+
+#endif
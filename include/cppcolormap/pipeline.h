@@ -0,0 +1,447 @@
+/**
+ * Pipelined rendering of frames (e.g. of an animation): map, encode, and write concurrently.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_PIPELINE_H
+#define CPPCOLORMAP_PIPELINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../cppcolormap.h"
+#include "image.h"
+
+namespace cppcolormap {
+
+/**
+ * Timing of one stage of cppcolormap::FramePipeline (summed over the threads of the stage).
+ */
+struct PipelineStage {
+    size_t frames = 0; ///< Number of frames processed.
+    double busy = 0.0; ///< Time spent processing (seconds).
+    double idle = 0.0; ///< Time spent waiting for input (seconds).
+    double blocked = 0.0; ///< Time spent waiting for the next stage (back-pressure, seconds).
+};
+
+/**
+ * Timing of all stages of cppcolormap::FramePipeline.
+ * The slowest stage is the one with the least idle time.
+ */
+struct PipelineStats {
+    PipelineStage submit; ///< Caller of cppcolormap::FramePipeline::submit (copying input).
+    PipelineStage map; ///< Mapping data to colours.
+    PipelineStage encode; ///< Encoding images in memory.
+    PipelineStage write; ///< Writing files.
+};
+
+namespace detail {
+
+/**
+ * Queue with a maximal size: cppcolormap::detail::bounded_queue::push blocks while it is full.
+ */
+template <class T>
+class bounded_queue {
+public:
+    explicit bounded_queue(size_t capacity) : m_capacity(std::max(capacity, size_t(1)))
+    {
+    }
+
+    /**
+     * Add an item, waiting while the queue is full.
+     * Returns `false` (and drops the item) if the queue is aborted.
+     */
+    bool push(T&& item, double& wait)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [&]() { return m_items.size() < m_capacity || m_aborted; });
+        wait += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        if (m_aborted) {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * Take an item, waiting while the queue is empty.
+     * Returns `false` if the queue is closed and empty, or if it is aborted.
+     */
+    bool pop(T& item, double& wait)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [&]() { return !m_items.empty() || m_closed || m_aborted; });
+        wait += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        if (m_aborted || m_items.empty()) {
+            return false;
+        }
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * No more items will be pushed: cppcolormap::detail::bounded_queue::pop drains the queue.
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+    }
+
+    /**
+     * Drop all items and wake all waiting threads.
+     */
+    void abort()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_aborted = true;
+        m_items.clear();
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+private:
+    size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_closed = false;
+    bool m_aborted = false;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+};
+
+} // namespace detail
+
+/**
+ * Render frames (e.g. of an animation) to image files, with the stages
+ *
+ * 1.  map: data to colours (cppcolormap::as_colors, in parallel, see
+ *     cppcolormap::set_num_threads);
+ * 2.  encode: colours to an image in memory (cppcolormap::ImageWriter, one frame per thread);
+ * 3.  write: image to file;
+ *
+ * running concurrently on their own threads, connected by bounded queues.
+ * When a stage falls behind, the queue before it fills up and cppcolormap::FramePipeline::submit
+ * blocks (back-pressure), such that memory use stays bounded.
+ *
+ * Usage:
+ *
+ *      cppcolormap::FramePipeline<double> pipeline(cppcolormap::viridis(), vmin, vmax, w, h);
+ *
+ *      for (size_t i = 0; i < nframes; ++i) {
+ *          pipeline.submit(frame(i).data(), "frame-" + std::to_string(i) + ".png");
+ *      }
+ *
+ *      pipeline.finish();
+ *      auto stats = pipeline.stats();
+ *
+ * @tparam T Type of the data.
+ */
+template <typename T>
+class FramePipeline {
+public:
+    /**
+     * Start the pipeline.
+     *
+     * @param colors Colormap, ``cppcolormap::CompiledColormap<uint8_t>`` with format `rgb` or
+     *      `rgba`.
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @param width Number of data-points per row of each frame.
+     * @param height Number of rows of each frame.
+     * @param encoders Number of threads encoding images.
+     * @param capacity Maximal number of frames waiting between two stages.
+     */
+    FramePipeline(
+        CompiledColormap<uint8_t> colors,
+        double vmin,
+        double vmax,
+        size_t width,
+        size_t height,
+        size_t encoders = 2,
+        size_t capacity = 4
+    )
+        : m_colors(std::move(colors)),
+          m_vmin(vmin),
+          m_vmax(vmax),
+          m_width(width),
+          m_height(height),
+          m_in(capacity),
+          m_mapped(capacity),
+          m_encoded(capacity)
+    {
+        CPPCOLORMAP_ASSERT(vmax > vmin);
+        CPPCOLORMAP_ASSERT(width > 0 && height > 0);
+        CPPCOLORMAP_ASSERT(m_colors.format() == rgb || m_colors.format() == rgba);
+
+        m_map_thread = std::thread([this]() { run(&FramePipeline::map_stage); });
+
+        for (size_t i = 0; i < std::max(encoders, size_t(1)); ++i) {
+            m_encode_threads.emplace_back([this]() { run(&FramePipeline::encode_stage); });
+        }
+
+        m_write_thread = std::thread([this]() { run(&FramePipeline::write_stage); });
+    }
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    /**
+     * Wait for all frames (errors are not reported, call cppcolormap::FramePipeline::finish).
+     */
+    ~FramePipeline()
+    {
+        try {
+            finish();
+        }
+        catch (...) {
+        }
+    }
+
+    /**
+     * Add a frame (moved into the pipeline).
+     * Blocks while the pipeline is full.
+     *
+     * @param frame Data [height, width] (row-major).
+     * @param path Path of the image, its extension sets the format, see cppcolormap::image_format.
+     * @throw Any exception raised by a stage of the pipeline (the pipeline is stopped).
+     */
+    void submit(std::vector<T>&& frame, const std::string& path)
+    {
+        CPPCOLORMAP_ASSERT(frame.size() == m_width * m_height);
+
+        if (m_finished) {
+            throw std::logic_error("FramePipeline already finished");
+        }
+
+        item i;
+        i.format = image_format_from_path(path);
+        i.path = path;
+        i.data = std::move(frame);
+        double blocked = 0.0;
+        bool ok = m_in.push(std::move(i), blocked);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.submit.blocked += blocked;
+            m_stats.submit.frames += ok ? 1 : 0;
+        }
+
+        if (!ok) {
+            finish();
+        }
+    }
+
+    /**
+     * Add a frame (copied).
+     * Blocks while the pipeline is full.
+     *
+     * @param frame Pointer to data [height, width] (row-major).
+     * @param path Path of the image, its extension sets the format, see cppcolormap::image_format.
+     * @throw Any exception raised by a stage of the pipeline (the pipeline is stopped).
+     */
+    void submit(const T* frame, const std::string& path)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<T> data(frame, frame + m_width * m_height);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.submit.busy += seconds_since(t0);
+        }
+
+        submit(std::move(data), path);
+    }
+
+    /**
+     * Wait until all submitted frames are written, and stop the pipeline.
+     *
+     * @throw The first exception raised by a stage of the pipeline.
+     */
+    void finish()
+    {
+        if (!m_finished) {
+            m_finished = true;
+            m_in.close();
+            m_map_thread.join();
+            m_mapped.close();
+            for (auto& t : m_encode_threads) {
+                t.join();
+            }
+            m_encoded.close();
+            m_write_thread.join();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_error) {
+            std::exception_ptr e = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    /**
+     * Timing of each stage so far.
+     */
+    PipelineStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    struct item {
+        std::vector<T> data;
+        std::vector<uint8_t> pixels;
+        std::string bytes;
+        std::string path;
+        image_format format = png;
+    };
+
+    static double seconds_since(std::chrono::steady_clock::time_point t0)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    /**
+     * Run a stage, on error: store the exception and abort all queues.
+     */
+    void run(void (FramePipeline::*stage)())
+    {
+        try {
+            (this->*stage)();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+            m_in.abort();
+            m_mapped.abort();
+            m_encoded.abort();
+        }
+    }
+
+    void map_stage()
+    {
+        item i;
+        PipelineStage s;
+
+        while (m_in.pop(i, s.idle)) {
+            auto t0 = std::chrono::steady_clock::now();
+            i.pixels.resize(m_width * m_height * m_colors.channels());
+            as_colors(i.data.data(), i.data.size(), 1, m_colors, m_vmin, m_vmax, i.pixels.data());
+            std::vector<T>().swap(i.data);
+            s.busy += seconds_since(t0);
+            s.frames++;
+            update(m_stats.map, s);
+            m_mapped.push(std::move(i), s.blocked);
+        }
+
+        update(m_stats.map, s);
+    }
+
+    void encode_stage()
+    {
+        item i;
+        PipelineStage s;
+
+        while (m_mapped.pop(i, s.idle)) {
+            auto t0 = std::chrono::steady_clock::now();
+            std::ostringstream out(std::ios::binary);
+            ImageWriter image(out, m_width, m_height, m_colors.channels(), i.format);
+            image.write_rows(i.pixels.data(), m_height);
+            image.close();
+            std::vector<uint8_t>().swap(i.pixels);
+            i.bytes = out.str();
+            s.busy += seconds_since(t0);
+            s.frames++;
+            update(m_stats.encode, s);
+            m_encoded.push(std::move(i), s.blocked);
+        }
+
+        update(m_stats.encode, s);
+    }
+
+    void write_stage()
+    {
+        item i;
+        PipelineStage s;
+
+        while (m_encoded.pop(i, s.idle)) {
+            auto t0 = std::chrono::steady_clock::now();
+            std::ofstream file(i.path, std::ios::binary | std::ios::trunc);
+            file.write(i.bytes.data(), static_cast<std::streamsize>(i.bytes.size()));
+            file.close();
+            if (!file) {
+                throw std::runtime_error("Writing \"" + i.path + "\" failed");
+            }
+            s.busy += seconds_since(t0);
+            s.frames++;
+            update(m_stats.write, s);
+        }
+
+        update(m_stats.write, s);
+    }
+
+    /**
+     * Add the timing of a thread since its last update to the statistics of a stage.
+     */
+    void update(PipelineStage& stage, PipelineStage& s)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stage.frames += s.frames;
+        stage.busy += s.busy;
+        stage.idle += s.idle;
+        stage.blocked += s.blocked;
+        s = PipelineStage();
+    }
+
+    CompiledColormap<uint8_t> m_colors;
+    double m_vmin;
+    double m_vmax;
+    size_t m_width;
+    size_t m_height;
+    detail::bounded_queue<item> m_in;
+    detail::bounded_queue<item> m_mapped;
+    detail::bounded_queue<item> m_encoded;
+    std::thread m_map_thread;
+    std::vector<std::thread> m_encode_threads;
+    std::thread m_write_thread;
+    bool m_finished = false;
+    mutable std::mutex m_mutex;
+    std::exception_ptr m_error;
+    PipelineStats m_stats;
+};
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * Colormap tables in shared memory, to share them between processes without copies.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_SHARED_H
+#define CPPCOLORMAP_SHARED_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <xtensor/xadapt.hpp>
+
+#include "../cppcolormap.h"
+#include "mmap.h"
+
+namespace cppcolormap {
+
+namespace detail {
+
+/**
+ * Header of a shared colormap table, followed by the colours (row-major, `double`).
+ * The magic is written last, such that a table is only attached once it is complete.
+ */
+struct shared_header {
+    char magic[8];
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t offset;
+    uint64_t reserved[4];
+};
+
+static_assert(sizeof(shared_header) == 64, "Unexpected padding");
+
+constexpr char shared_magic[8] = {'C', 'M', 'A', 'P', 'T', 'B', 'L', '1'};
+
+} // namespace detail
+
+/**
+ * Colormap table (e.g. a large LUT such as ``cppcolormap::viridis(65536)``) stored in a named
+ * shared-memory object or in a memory-mapped file.
+ * One process publishes the table, other processes attach to it read-only without copying it.
+ */
+class SharedColormap {
+public:
+    SharedColormap() = default;
+
+    /**
+     * Publish a colormap in a named shared-memory object.
+     * The object persists until cppcolormap::SharedColormap::unlink is called
+     * (or, on Windows, until it is no longer attached by any process).
+     *
+     * @param name Name of the shared-memory object.
+     * @param colors Colormap [N, ncol].
+     * @return Writable handle (keep it alive on Windows).
+     * @throw std::runtime_error if the object already exists.
+     */
+    template <class T>
+    static SharedColormap publish(const std::string& name, const T& colors)
+    {
+        SharedColormap ret;
+        ret.m_map = MemoryMap::create_shared(name, bytes(colors));
+        ret.write(colors);
+        return ret;
+    }
+
+    /**
+     * Attach to a colormap published by cppcolormap::SharedColormap::publish (read-only).
+     *
+     * @param name Name of the shared-memory object.
+     * @return Handle.
+     * @throw std::runtime_error if the object does not exist or is not a complete table.
+     */
+    static SharedColormap attach(const std::string& name)
+    {
+        SharedColormap ret;
+        ret.m_map = MemoryMap::open_shared(name);
+        ret.read(name);
+        return ret;
+    }
+
+    /**
+     * Remove a named shared-memory object (attached handles stay valid).
+     *
+     * @param name Name of the shared-memory object.
+     * @return `true` if the object was removed.
+     */
+    static bool unlink(const std::string& name)
+    {
+        return MemoryMap::remove_shared(name);
+    }
+
+    /**
+     * Publish a colormap to a file, that can be memory-mapped by other processes.
+     *
+     * @param path Path of the file (overwritten if it exists).
+     * @param colors Colormap [N, ncol].
+     * @return Writable handle.
+     */
+    template <class T>
+    static SharedColormap publish_file(const std::string& path, const T& colors)
+    {
+        SharedColormap ret;
+        ret.m_map = MemoryMap::create_file(path, bytes(colors));
+        ret.write(colors);
+        return ret;
+    }
+
+    /**
+     * Attach to a colormap published by cppcolormap::SharedColormap::publish_file (read-only).
+     *
+     * @param path Path of the file.
+     * @return Handle.
+     * @throw std::runtime_error if the file cannot be mapped or is not a complete table.
+     */
+    static SharedColormap attach_file(const std::string& path)
+    {
+        SharedColormap ret;
+        ret.m_map = MemoryMap::open_file(path);
+        ret.read(path);
+        return ret;
+    }
+
+    /**
+     * Number of colours.
+     */
+    size_t rows() const
+    {
+        return m_rows;
+    }
+
+    /**
+     * Number of components per colour.
+     */
+    size_t cols() const
+    {
+        return m_cols;
+    }
+
+    /**
+     * Pointer to the colours (row-major [rows(), cols()]).
+     */
+    const double* data() const
+    {
+        return m_data;
+    }
+
+    /**
+     * Colours, without copy. The view is valid as long as this handle is alive.
+     *
+     * @return Adaptor [rows(), cols()], e.g. to use in cppcolormap::as_colors.
+     */
+    auto colors() const
+    {
+        std::array<size_t, 2> shape = {m_rows, m_cols};
+        return xt::adapt(m_data, m_rows * m_cols, xt::no_ownership(), shape);
+    }
+
+private:
+    template <class T>
+    static size_t bytes(const T& colors)
+    {
+        CPPCOLORMAP_ASSERT(colors.dimension() == 2);
+        return sizeof(detail::shared_header) + colors.size() * sizeof(double);
+    }
+
+    template <class T>
+    void write(const T& colors)
+    {
+        size_t rows = colors.shape(0);
+        size_t cols = colors.shape(1);
+        auto* header = reinterpret_cast<detail::shared_header*>(m_map.data());
+        header->rows = rows;
+        header->cols = cols;
+        header->offset = sizeof(detail::shared_header);
+        double* data = reinterpret_cast<double*>(m_map.data() + header->offset);
+        detail::with_row_major(colors, [&](const auto* pc) {
+            std::copy(pc, pc + rows * cols, data);
+        });
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, detail::shared_magic, sizeof(header->magic));
+        m_rows = rows;
+        m_cols = cols;
+        m_data = data;
+    }
+
+    void read(const std::string& name)
+    {
+        if (m_map.size() < sizeof(detail::shared_header)) {
+            throw std::runtime_error("\"" + name + "\" is not a colormap table");
+        }
+
+        const auto* header = reinterpret_cast<const detail::shared_header*>(m_map.data());
+
+        if (std::memcmp(header->magic, detail::shared_magic, sizeof(header->magic)) != 0) {
+            throw std::runtime_error("\"" + name + "\" is not a (complete) colormap table");
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t size = m_map.size();
+        uint64_t rows = header->rows;
+        uint64_t cols = header->cols;
+        uint64_t offset = header->offset;
+
+        if (offset < sizeof(detail::shared_header) || offset % alignof(double) != 0) {
+            throw std::runtime_error("\"" + name + "\" is not a colormap table");
+        }
+
+        // rows * cols * sizeof(double) <= size - offset, without overflow
+        if (offset > size || (cols > 0 && rows > (size - offset) / sizeof(double) / cols)) {
+            throw std::runtime_error("\"" + name + "\" is truncated");
+        }
+
+        m_rows = static_cast<size_t>(header->rows);
+        m_cols = static_cast<size_t>(header->cols);
+        m_data = reinterpret_cast<const double*>(m_map.data() + header->offset);
+    }
+
+    MemoryMap m_map;
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+    const double* m_data = nullptr;
+};
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,256 @@
+/**
+ * Streaming (chunked) conversion of data to colours, for data that does not fit in memory.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_STREAM_H
+#define CPPCOLORMAP_STREAM_H
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../cppcolormap.h"
+
+namespace cppcolormap {
+
+/**
+ * Convert a stream of data to colours, one chunk at a time, with a fixed colour-axis.
+ * Memory use is independent of the length of the stream: two input chunks and one output chunk.
+ * While a chunk is mapped (in parallel, see cppcolormap::set_num_threads) the next chunk is read
+ * on a separate thread (double buffering), such that reading and mapping overlap.
+ *
+ * Usage:
+ *
+ *      cppcolormap::StreamMapper<float> mapper(cppcolormap::viridis(), vmin, vmax);
+ *
+ *      mapper.run(
+ *          [&](float* buffer, size_t capacity) {
+ *              return fread(buffer, sizeof(float), capacity, input);
+ *          },
+ *          [&](const uint8_t* pixels, size_t n) {
+ *              fwrite(pixels, 1, n * mapper.channels(), output);
+ *          });
+ *
+ * @tparam T Type of the data.
+ * @tparam O Type of the output, see cppcolormap::CompiledColormap.
+ */
+template <typename T, typename O = uint8_t>
+class StreamMapper {
+public:
+    StreamMapper() = default;
+
+    /**
+     * @param colors Colormap, e.g. ``cppcolormap::CompiledColormap<uint8_t>(cppcolormap::jet())``.
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @param chunk Maximal number of data-points per chunk.
+     */
+    StreamMapper(CompiledColormap<O> colors, double vmin, double vmax, size_t chunk = 1 << 20)
+        : m_colors(std::move(colors)), m_vmin(vmin), m_vmax(vmax), m_chunk(chunk)
+    {
+        CPPCOLORMAP_ASSERT(vmax > vmin);
+        CPPCOLORMAP_ASSERT(chunk > 0);
+    }
+
+    /**
+     * @param colors Colormap, e.g. ``cppcolormap::jet()``.
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @param chunk Maximal number of data-points per chunk.
+     * @param format Channel layout of the output.
+     */
+    StreamMapper(
+        ColormapSpan colors,
+        double vmin,
+        double vmax,
+        size_t chunk = 1 << 20,
+        pixel_format format = rgb
+    )
+        : StreamMapper(CompiledColormap<O>(colors, format), vmin, vmax, chunk)
+    {
+    }
+
+    /**
+     * Maximal number of data-points per chunk.
+     */
+    size_t chunk() const
+    {
+        return m_chunk;
+    }
+
+    /**
+     * Number of output values per data-point (3 or 4).
+     */
+    size_t channels() const
+    {
+        return m_colors.channels();
+    }
+
+    /**
+     * Map all data read from a source.
+     *
+     * @param source
+     *      Function `size_t(T* buffer, size_t capacity)` that writes at most `capacity`
+     *      data-points to `buffer` and returns how many it wrote (`0` signals the end).
+     *      It is called on a separate thread (but never concurrently).
+     *
+     * @param sink
+     *      Function `void(const O* pixels, size_t n)` that consumes the colours of the next
+     *      `n` data-points (`pixels` is `[n, channels()]` and only valid during the call).
+     *      It is called on the calling thread, in order.
+     *
+     * @return Total number of data-points.
+     * @throw Any exception thrown by `source` or `sink` (the stream is stopped).
+     */
+    template <class Source, class Sink>
+    size_t run(Source&& source, Sink&& sink) const
+    {
+        std::array<std::vector<T>, 2> in = {std::vector<T>(m_chunk), std::vector<T>(m_chunk)};
+        std::array<size_t, 2> count = {0, 0};
+        std::array<bool, 2> full = {false, false};
+        std::vector<O> out(m_chunk * m_colors.channels());
+        std::exception_ptr error;
+        bool stop = false;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        std::thread reader([&]() {
+            for (size_t b = 0;; b ^= 1) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return !full[b] || stop; });
+                    if (stop) {
+                        return;
+                    }
+                }
+
+                size_t n = 0;
+                std::exception_ptr e;
+
+                try {
+                    n = source(in[b].data(), m_chunk);
+                    if (n > m_chunk) {
+                        throw std::out_of_range("Source wrote more than the chunk size");
+                    }
+                }
+                catch (...) {
+                    e = std::current_exception();
+                    n = 0;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    error = e;
+                    count[b] = n;
+                    full[b] = true;
+                }
+                cv.notify_all();
+
+                if (n == 0) {
+                    return;
+                }
+            }
+        });
+
+        size_t total = 0;
+
+        try {
+            for (size_t b = 0;; b ^= 1) {
+                size_t n;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return full[b]; });
+                    n = count[b];
+                }
+
+                if (n == 0) {
+                    break;
+                }
+
+                as_colors(in[b].data(), n, 1, m_colors, m_vmin, m_vmax, out.data());
+                sink(static_cast<const O*>(out.data()), n);
+                total += n;
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    full[b] = false;
+                }
+                cv.notify_all();
+            }
+        }
+        catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            cv.notify_all();
+            reader.join();
+            throw;
+        }
+
+        reader.join();
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return total;
+    }
+
+    /**
+     * Map a sequence of spans (e.g. memory-mapped blocks of a file).
+     * Each span is split in chunks, which are copied on a separate thread while the previous
+     * chunk is mapped (such that e.g. page faults of a memory-mapped file overlap with mapping).
+     *
+     * @param first Iterator to the first span (anything with `data()` and `size()`).
+     * @param last Iterator past the last span.
+     * @param sink See cppcolormap::StreamMapper::run.
+     * @return Total number of data-points.
+     */
+    template <class Iterator, class Sink>
+    size_t run(Iterator first, Iterator last, Sink&& sink) const
+    {
+        size_t offset = 0;
+
+        auto source = [&](T* buffer, size_t capacity) -> size_t {
+            while (first != last && offset == static_cast<size_t>((*first).size())) {
+                ++first;
+                offset = 0;
+            }
+
+            if (first == last) {
+                return 0;
+            }
+
+            const auto* data = (*first).data();
+            size_t n = std::min(capacity, static_cast<size_t>((*first).size()) - offset);
+            std::copy(data + offset, data + offset + n, buffer);
+            offset += n;
+            return n;
+        };
+
+        return run(source, std::forward<Sink>(sink));
+    }
+
+private:
+    CompiledColormap<O> m_colors;
+    double m_vmin = 0.0;
+    double m_vmax = 1.0;
+    size_t m_chunk = 1 << 20;
+};
+
+} // namespace cppcolormap
+
+#endif
@@ -0,0 +1,363 @@
+/**
+ * Streaming video output (Y4M or raw RGB24) of colormapped frames, e.g. to pipe into an encoder.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_VIDEO_H
+#define CPPCOLORMAP_VIDEO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../cppcolormap.h"
+
+namespace cppcolormap {
+
+/**
+ * Video stream format, see cppcolormap::VideoWriter.
+ */
+enum video_format {
+    y4m_420, ///< YUV4MPEG2, 4:2:0 chroma subsampling (``C420jpeg``), BT.601 limited range.
+    y4m_444, ///< YUV4MPEG2, no chroma subsampling (``C444``), BT.601 limited range.
+    rgb24 ///< Raw RGB, 8 bits per channel, no header (e.g. ``ffmpeg -f rawvideo -pix_fmt rgb24``).
+};
+
+namespace detail {
+
+inline uint8_t yuv_clamp(double value)
+{
+    return static_cast<uint8_t>(std::min(std::max(std::round(value), 0.0), 255.0));
+}
+
+} // namespace detail
+
+/**
+ * Write colormapped frames as video stream to a file or a pipe (e.g. ``popen("ffmpeg ...")``).
+ * Each frame is written as soon as it is mapped, only one frame is buffered.
+ *
+ * For the Y4M formats the colormap is converted to YUV once: mapping a frame looks up
+ * Y, U, and V directly (for 4:2:0 averaging U and V over 2x2 pixels), such that no RGB
+ * image is formed.
+ *
+ * Usage:
+ *
+ *      FILE* pipe = popen("ffmpeg -i - -c:v libx264 out.mp4", "w");
+ *      cppcolormap::VideoWriter video(pipe, width, height, cppcolormap::viridis(), vmin, vmax);
+ *
+ *      for (size_t i = 0; i < nframes; ++i) {
+ *          video.write_frame(frame(i).data());
+ *      }
+ *
+ *      video.close();
+ *      pclose(pipe);
+ */
+class VideoWriter {
+public:
+    /**
+     * Write to a stream that is opened (and closed) by the caller, e.g. ``stdout`` or a pipe.
+     *
+     * @param file Output stream.
+     * @param width Number of data-points per row of each frame.
+     * @param height Number of rows of each frame.
+     * @param colors Colormap [N, 3] or [N, 4] (alpha is ignored), e.g. ``cppcolormap::viridis()``.
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @param format Stream format.
+     * @param fps Frame rate (only stored in the Y4M header).
+     */
+    VideoWriter(
+        std::FILE* file,
+        size_t width,
+        size_t height,
+        ColormapSpan colors,
+        double vmin,
+        double vmax,
+        video_format format = y4m_420,
+        size_t fps = 25
+    )
+        : m_file(file),
+          m_width(width),
+          m_height(height),
+          m_vmin(vmin),
+          m_vmax(vmax),
+          m_format(format),
+          m_rgb(colors, rgb)
+    {
+        CPPCOLORMAP_ASSERT(file != nullptr);
+        CPPCOLORMAP_ASSERT(width > 0 && height > 0);
+        CPPCOLORMAP_ASSERT(vmax > vmin);
+
+        if (format != rgb24) {
+            compile_yuv();
+            std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" +
+                                 std::to_string(height) + " F" + std::to_string(fps) +
+                                 ":1 Ip A1:1 " + (format == y4m_420 ? "C420jpeg" : "C444") + "\n";
+            write(header.data(), header.size());
+        }
+    }
+
+    /**
+     * Write to a file.
+     *
+     * @param path Path of the file (overwritten if it exists).
+     * @param width Number of data-points per row of each frame.
+     * @param height Number of rows of each frame.
+     * @param colors Colormap [N, 3] or [N, 4] (alpha is ignored), e.g. ``cppcolormap::viridis()``.
+     * @param vmin The lower limit of the color-axis.
+     * @param vmax The upper limit of the color-axis.
+     * @param format Stream format.
+     * @param fps Frame rate (only stored in the Y4M header).
+     * @throw std::runtime_error if the file cannot be opened.
+     */
+    VideoWriter(
+        const std::string& path,
+        size_t width,
+        size_t height,
+        ColormapSpan colors,
+        double vmin,
+        double vmax,
+        video_format format = y4m_420,
+        size_t fps = 25
+    )
+        : VideoWriter(open(path), width, height, colors, vmin, vmax, format, fps)
+    {
+    }
+
+    VideoWriter(const VideoWriter&) = delete;
+    VideoWriter& operator=(const VideoWriter&) = delete;
+
+    ~VideoWriter()
+    {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    /**
+     * Number of frames written.
+     */
+    size_t frames() const
+    {
+        return m_frames;
+    }
+
+    /**
+     * Number of bytes per frame (excluding the Y4M frame header).
+     */
+    size_t frame_size() const
+    {
+        size_t n = m_width * m_height;
+
+        if (m_format == y4m_420) {
+            return n + 2 * ((m_width + 1) / 2) * ((m_height + 1) / 2);
+        }
+
+        return 3 * n;
+    }
+
+    /**
+     * Map and write the next frame.
+     * Large frames are mapped in parallel, see cppcolormap::set_num_threads.
+     *
+     * @param data Pointer to data [height, width] (row-major).
+     * @throw std::runtime_error if writing fails (e.g. a closed pipe).
+     */
+    template <typename T>
+    void write_frame(const T* data)
+    {
+        if (!m_file) {
+            throw std::logic_error("VideoWriter already closed");
+        }
+
+        m_frame.resize(frame_size());
+
+        switch (m_format) {
+        case rgb24:
+            as_colors(data, m_width * m_height, 1, m_rgb, m_vmin, m_vmax, m_frame.data());
+            break;
+        case y4m_444:
+            map_444(data);
+            break;
+        case y4m_420:
+            map_420(data);
+            break;
+        }
+
+        if (m_format != rgb24) {
+            write("FRAME\n", 6);
+        }
+
+        write(m_frame.data(), m_frame.size());
+        m_frames++;
+    }
+
+    /**
+     * Flush the stream (and close it if it was opened by this writer).
+     *
+     * @throw std::runtime_error if flushing fails.
+     */
+    void close()
+    {
+        if (!m_file) {
+            return;
+        }
+
+        bool ok = std::fflush(m_file) == 0;
+
+        if (m_owner) {
+            ok = std::fclose(m_file) == 0 && ok;
+        }
+
+        m_file = nullptr;
+
+        if (!ok) {
+            throw std::runtime_error("Writing video failed");
+        }
+    }
+
+private:
+    using file_ptr = std::unique_ptr<std::FILE, int (*)(std::FILE*)>;
+
+    /**
+     * Take ownership of an opened file: it is closed if writing the header throws.
+     */
+    VideoWriter(
+        file_ptr file,
+        size_t width,
+        size_t height,
+        ColormapSpan colors,
+        double vmin,
+        double vmax,
+        video_format format,
+        size_t fps
+    )
+        : VideoWriter(file.get(), width, height, colors, vmin, vmax, format, fps)
+    {
+        m_owner = true;
+        file.release();
+    }
+
+    static file_ptr open(const std::string& path)
+    {
+        file_ptr ret(std::fopen(path.c_str(), "wb"), &std::fclose);
+
+        if (!ret) {
+            throw std::runtime_error("Cannot open \"" + path + "\" for writing");
+        }
+
+        return ret;
+    }
+
+    void write(const void* data, size_t n)
+    {
+        if (std::fwrite(data, 1, n, m_file) != n) {
+            throw std::runtime_error("Writing video failed");
+        }
+    }
+
+    /**
+     * Convert the (8-bit) colormap to BT.601 limited-range YUV.
+     */
+    void compile_yuv()
+    {
+        size_t N = m_rgb.size();
+        const uint8_t* c = m_rgb.data();
+        m_y.resize(N);
+        m_u.resize(N);
+        m_v.resize(N);
+
+        for (size_t i = 0; i < N; ++i) {
+            double r = c[3 * i] / 255.0;
+            double g = c[3 * i + 1] / 255.0;
+            double b = c[3 * i + 2] / 255.0;
+            m_y[i] = detail::yuv_clamp(16.0 + 65.481 * r + 128.553 * g + 24.966 * b);
+            m_u[i] = detail::yuv_clamp(128.0 - 37.797 * r - 74.203 * g + 112.0 * b);
+            m_v[i] = detail::yuv_clamp(128.0 + 112.0 * r - 93.786 * g - 18.214 * b);
+        }
+    }
+
+    template <typename T>
+    void map_444(const T* data)
+    {
+        size_t n = m_width * m_height;
+        detail::quantiser q(m_vmin, m_vmax, m_rgb.size());
+        uint8_t* Y = m_frame.data();
+        uint8_t* U = Y + n;
+        uint8_t* V = U + n;
+
+        detail::parallel_for(n, get_parallel_grain(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                size_t k = q(data[i]);
+                Y[i] = m_y[k];
+                U[i] = m_u[k];
+                V[i] = m_v[k];
+            }
+        });
+    }
+
+    template <typename T>
+    void map_420(const T* data)
+    {
+        size_t w = m_width;
+        size_t h = m_height;
+        size_t cw = (w + 1) / 2;
+        size_t ch = (h + 1) / 2;
+        detail::quantiser q(m_vmin, m_vmax, m_rgb.size());
+        uint8_t* Y = m_frame.data();
+        uint8_t* U = Y + w * h;
+        uint8_t* V = U + cw * ch;
+        size_t grain = std::max(size_t(1), get_parallel_grain() / (2 * w));
+
+        detail::parallel_for(ch, grain, [&](size_t begin, size_t end) {
+            for (size_t cy = begin; cy < end; ++cy) {
+                size_t rows = std::min(size_t(2), h - 2 * cy);
+                for (size_t cx = 0; cx < cw; ++cx) {
+                    size_t cols = std::min(size_t(2), w - 2 * cx);
+                    size_t su = 0;
+                    size_t sv = 0;
+                    for (size_t dy = 0; dy < rows; ++dy) {
+                        for (size_t dx = 0; dx < cols; ++dx) {
+                            size_t i = (2 * cy + dy) * w + 2 * cx + dx;
+                            size_t k = q(data[i]);
+                            Y[i] = m_y[k];
+                            su += m_u[k];
+                            sv += m_v[k];
+                        }
+                    }
+                    size_t m = rows * cols;
+                    U[cy * cw + cx] = static_cast<uint8_t>((su + m / 2) / m);
+                    V[cy * cw + cx] = static_cast<uint8_t>((sv + m / 2) / m);
+                }
+            }
+        });
+    }
+
+    std::FILE* m_file;
+    bool m_owner = false;
+    size_t m_width;
+    size_t m_height;
+    double m_vmin;
+    double m_vmax;
+    video_format m_format;
+    CompiledColormap<uint8_t> m_rgb;
+    std::vector<uint8_t> m_y;
+    std::vector<uint8_t> m_u;
+    std::vector<uint8_t> m_v;
+    std::vector<uint8_t> m_frame;
+    size_t m_frames = 0;
+};
+
+} // namespace cppcolormap
+
+#endif
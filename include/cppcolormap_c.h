@@ -0,0 +1,283 @@
+/**
+ * C API of cppcolormap (shared library ``cppcolormap_c``, build with ``-DBUILD_C_API=1``),
+ * for use from C and through foreign-function interfaces (e.g. Rust, Julia, Python ctypes).
+ *
+ * Conventions:
+ *
+ * -   Functions that can fail return #CPPCOLORMAP_OK (zero) on success,
+ *     constructors return `NULL` on failure.
+ *     The reason of the last failure on the calling thread is given by cppcolormap_last_error().
+ * -   Colours are components in [0, 1], row-major.
+ * -   The ABI only changes if #CPPCOLORMAP_C_API_VERSION changes.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#ifndef CPPCOLORMAP_C_H
+#define CPPCOLORMAP_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(CPPCOLORMAP_C_EXPORTS)
+#define CPPCOLORMAP_C_API __declspec(dllexport)
+#else
+#define CPPCOLORMAP_C_API __declspec(dllimport)
+#endif
+#else
+#define CPPCOLORMAP_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Version of the ABI, see cppcolormap_api_version().
+ */
+#define CPPCOLORMAP_C_API_VERSION 1
+
+/**
+ * Status codes.
+ */
+enum cppcolormap_status {
+    CPPCOLORMAP_OK = 0, ///< Success.
+    CPPCOLORMAP_ERROR_INVALID_ARGUMENT = 1, ///< Invalid argument (e.g. `NULL` or unknown name).
+    CPPCOLORMAP_ERROR_INTERNAL = 2 ///< Any other error (e.g. out of memory).
+};
+
+/**
+ * Channel layout of the output (same values as cppcolormap::pixel_format).
+ */
+enum cppcolormap_format {
+    CPPCOLORMAP_RGB = 0, ///< Red, green, blue.
+    CPPCOLORMAP_RGBA = 1, ///< Red, green, blue, alpha.
+    CPPCOLORMAP_BGR = 2, ///< Blue, green, red.
+    CPPCOLORMAP_BGRA = 3 ///< Blue, green, red, alpha.
+};
+
+/**
+ * Distance metric of cppcolormap_match() (same values as cppcolormap::metric).
+ */
+enum cppcolormap_metric {
+    CPPCOLORMAP_EUCLIDEAN = 0, ///< Euclidean norm.
+    CPPCOLORMAP_FAST_PERCEPTUAL = 1, ///< Fast best perception algorithm.
+    CPPCOLORMAP_PERCEPTUAL = 2, ///< Best perception algorithm.
+    CPPCOLORMAP_DELTA_E_CIE76 = 3, ///< Euclidean norm in CIELAB.
+    CPPCOLORMAP_DELTA_E_OKLAB = 4 ///< Euclidean norm in Oklab.
+};
+
+/**
+ * Colormap compiled to 8-bit pixels (opaque), see cppcolormap_create().
+ */
+typedef struct cppcolormap_cmap cppcolormap_cmap;
+
+/**
+ * ABI version of the library (compare with #CPPCOLORMAP_C_API_VERSION).
+ */
+CPPCOLORMAP_C_API int cppcolormap_api_version(void);
+
+/**
+ * Version of cppcolormap, e.g. `"1.0.0"` (static storage).
+ */
+CPPCOLORMAP_C_API const char* cppcolormap_version(void);
+
+/**
+ * Message of the last error on the calling thread (empty if there was none).
+ * Valid until the next call on the same thread.
+ */
+CPPCOLORMAP_C_API const char* cppcolormap_last_error(void);
+
+/**
+ * Set the maximum number of threads (see cppcolormap::set_num_threads).
+ */
+CPPCOLORMAP_C_API void cppcolormap_set_num_threads(size_t n);
+
+/**
+ * Create a colormap by name (see cppcolormap::colormap).
+ *
+ * @param name Name of the colormap, e.g. `"viridis"`.
+ * @param N Number of colours (`0` for the default of the colormap).
+ * @param format Channel layout of the output, see #cppcolormap_format.
+ * @return Colormap (free with cppcolormap_destroy()), or `NULL` on failure.
+ */
+CPPCOLORMAP_C_API cppcolormap_cmap* cppcolormap_create(const char* name, size_t N, int format);
+
+/**
+ * Create a colormap from a table of colours.
+ *
+ * @param colors Colours [rows, cols], in [0, 1].
+ * @param rows Number of colours.
+ * @param cols Number of components (3: RGB, 4: RGBA).
+ * @param format Channel layout of the output, see #cppcolormap_format.
+ * @return Colormap (free with cppcolormap_destroy()), or `NULL` on failure.
+ */
+CPPCOLORMAP_C_API cppcolormap_cmap*
+cppcolormap_create_from_table(const double* colors, size_t rows, size_t cols, int format);
+
+/**
+ * Free a colormap (`NULL` is allowed).
+ */
+CPPCOLORMAP_C_API void cppcolormap_destroy(cppcolormap_cmap* cmap);
+
+/**
+ * Number of colours.
+ */
+CPPCOLORMAP_C_API size_t cppcolormap_size(const cppcolormap_cmap* cmap);
+
+/**
+ * Number of bytes per pixel of the output (3 or 4).
+ */
+CPPCOLORMAP_C_API size_t cppcolormap_channels(const cppcolormap_cmap* cmap);
+
+/**
+ * Map data to 8-bit pixels (see cppcolormap::as_colors).
+ * There is one function per type of data: `f32` (`float`), `f64` (`double`),
+ * `i8`, `u8`, `i16`, `u16`, `i32`, `u32`, `i64`, `u64`.
+ *
+ * @param cmap Colormap.
+ * @param data Pointer to the first data-point.
+ * @param n Number of data-points.
+ * @param stride Distance between data-points (in items, `1` for contiguous data).
+ * @param vmin The lower limit of the color-axis.
+ * @param vmax The upper limit of the color-axis (`vmax > vmin`).
+ * @param out Output [n, cppcolormap_channels()].
+ * @return #CPPCOLORMAP_OK on success.
+ */
+CPPCOLORMAP_C_API int cppcolormap_map_f32(
+    const cppcolormap_cmap* cmap,
+    const float* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_f64(
+    const cppcolormap_cmap* cmap,
+    const double* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_i8(
+    const cppcolormap_cmap* cmap,
+    const int8_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_u8(
+    const cppcolormap_cmap* cmap,
+    const uint8_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_i16(
+    const cppcolormap_cmap* cmap,
+    const int16_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_u16(
+    const cppcolormap_cmap* cmap,
+    const uint16_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_i32(
+    const cppcolormap_cmap* cmap,
+    const int32_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_u32(
+    const cppcolormap_cmap* cmap,
+    const uint32_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_i64(
+    const cppcolormap_cmap* cmap,
+    const int64_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/** See cppcolormap_map_f32(). */
+CPPCOLORMAP_C_API int cppcolormap_map_u64(
+    const cppcolormap_cmap* cmap,
+    const uint64_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+);
+
+/**
+ * Find the closest colour in a palette (see cppcolormap::match).
+ *
+ * @param colors Colours [n, 3].
+ * @param n Number of colours.
+ * @param palette Palette [npalette, 3].
+ * @param npalette Number of colours in the palette.
+ * @param metric Distance metric, see #cppcolormap_metric.
+ * @param out Output [n]: index in the palette.
+ * @return #CPPCOLORMAP_OK on success.
+ */
+CPPCOLORMAP_C_API int cppcolormap_match(
+    const double* colors,
+    size_t n,
+    const double* palette,
+    size_t npalette,
+    int metric,
+    size_t* out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1 +1,36 @@
 from ._cppcolormap import *  # noqa: F401, F403
+from ._cppcolormap import colormap
+from ._cppcolormap import colormap_size
+from ._cppcolormap import is_registered
+from ._cppcolormap import registered_colormaps
+
+
+def _registered(name: str, N: int):
+    def func(N: int = N):
+        return colormap(name, N)
+
+    func.__name__ = name
+    func.__qualname__ = name
+    func.__doc__ = f"""Colormap "{name}", see :py:func:`cppcolormap.colormap`.
+
+:param N: Number of colors to output (ignored for color-cycles).
+:return: RGB data.
+"""
+    return func
+
+
+def __getattr__(name: str):
+    """
+    Colormaps (e.g. ``cppcolormap.Reds(N)``) are looked-up in the registry on first use,
+    such that the import time does not depend on the number of colormaps.
+    """
+    if name.startswith("__") or not is_registered(name):
+        raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
+
+    func = _registered(name, colormap_size(name))
+    globals()[name] = func
+    return func
+
+
+def __dir__():
+    return sorted(set(globals()) | set(registered_colormaps()))
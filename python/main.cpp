@@ -1,13 +1,22 @@
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <optional>
+
 #define FORCE_IMPORT_ARRAY
 #include <xtensor-python/pyarray.hpp>
 #include <xtensor-python/pytensor.hpp>
 
+#define PY_UFUNC_UNIQUE_SYMBOL cppcolormap_UFUNC_API
+#include <numpy/ufuncobject.h>
+
 #define CPPCOLORMAP_USE_XTENSOR_PYTHON
 #include <cppcolormap.h>
+#include <cppcolormap/loaders.h>
+#include <cppcolormap/pack.h>
+#include <cppcolormap/shared.h>
 
 namespace py = pybind11;
 
@@ -43,6 +52,388 @@ private:
     py::object original_name_;
 };
 
+/**
+ * Shape and strides (in units of items) of a NumPy array.
+ * The array is copied to C-contiguous only if its strides are not a multiple of the item size.
+ *
+ * @param data NumPy array.
+ * @param shape Shape (output).
+ * @param strides Strides in units of items (output).
+ * @return The array whose buffer `shape` and `strides` refer to.
+ */
+template <typename T>
+py::array_t<T, 0> item_strides(
+    const py::array_t<T, 0>& data,
+    std::vector<size_t>& shape,
+    std::vector<ptrdiff_t>& strides
+)
+{
+    py::array_t<T, 0> a = data;
+    size_t ndim = static_cast<size_t>(a.ndim());
+
+    for (size_t d = 0; d < ndim; ++d) {
+        if (a.strides(d) % static_cast<py::ssize_t>(sizeof(T)) != 0) {
+            a = py::array_t<T, py::array::c_style>::ensure(data);
+            break;
+        }
+    }
+
+    shape.assign(a.shape(), a.shape() + ndim);
+    strides.resize(ndim);
+
+    for (size_t d = 0; d < ndim; ++d) {
+        strides[d] = static_cast<ptrdiff_t>(a.strides(d) / static_cast<py::ssize_t>(sizeof(T)));
+    }
+
+    return a;
+}
+
+/**
+ * Map a NumPy array to colours, operating directly on its buffer (including strides).
+ * The GIL is released while computing.
+ */
+template <typename T>
+py::array_t<double, 0> as_colors_buffer(
+    const py::array_t<T, 0>& data,
+    const py::array_t<double, py::array::c_style | py::array::forcecast>& colors,
+    std::optional<double> vmin,
+    std::optional<double> vmax,
+    std::optional<py::array_t<double, 0>> out
+)
+{
+    if (vmin.has_value() != vmax.has_value()) {
+        throw std::invalid_argument("Specify both vmin and vmax, or neither");
+    }
+
+    if (colors.ndim() != 2 || colors.shape(0) == 0) {
+        throw std::invalid_argument("colors: expected an array of shape (N, 3) or (N, 4), N > 0");
+    }
+
+    std::vector<size_t> shape;
+    std::vector<ptrdiff_t> strides;
+    py::array_t<T, 0> a = item_strides(data, shape, strides);
+    size_t ndim = shape.size();
+    std::vector<size_t> out_shape = shape;
+    size_t ncolors = static_cast<size_t>(colors.shape(0));
+    size_t stride = static_cast<size_t>(colors.shape(1));
+    out_shape.push_back(stride);
+
+    py::array_t<double, 0> ret;
+
+    if (out.has_value()) {
+        ret = *out;
+        bool match = ret.ndim() == static_cast<py::ssize_t>(ndim + 1);
+        for (size_t d = 0; match && d <= ndim; ++d) {
+            match = ret.shape(d) == static_cast<py::ssize_t>(out_shape[d]);
+        }
+        if (!match || !(ret.flags() & py::array::c_style) || !ret.writeable()) {
+            throw std::invalid_argument(
+                "out: expected a writeable C-contiguous array of shape "
+                "data.shape + (colors.shape[1],)"
+            );
+        }
+    }
+    else {
+        ret = py::array_t<double, 0>(out_shape);
+    }
+
+    const T* pd = a.data();
+    const double* pc = colors.data();
+    double* pr = ret.mutable_data();
+
+    double lo;
+    double hi;
+
+    {
+        py::gil_scoped_release release;
+        CPPCOLORMAP_STATS_SCOPE(as_colors);
+
+        if (vmin.has_value()) {
+            lo = *vmin;
+            hi = *vmax;
+        }
+        else {
+            auto range = cppcolormap::detail::strided_minmax(pd, shape, strides);
+            lo = range[0];
+            hi = range[1];
+        }
+
+        if (hi > lo) {
+            cppcolormap::detail::quantiser q(lo, hi, ncolors);
+            cppcolormap::detail::as_colors_strided(pd, shape, strides, q, pc, stride, pr);
+
+            CPPCOLORMAP_STATS_COUNT(
+                a.size(),
+                out.has_value() ? 0 : ret.size() * sizeof(double),
+                cppcolormap::detail::parallel_blocks(a.size(), cppcolormap::get_parallel_grain())
+            );
+        }
+    }
+
+    if (!(hi > lo)) {
+        throw std::invalid_argument("Expected vmax > vmin");
+    }
+
+    return ret;
+}
+
+template <typename T>
+void def_as_colors(py::module& m)
+{
+    m.def(
+        "as_colors",
+        &as_colors_buffer<T>,
+        "Convert data to colors. "
+        "Operates directly on the data (any strides) and releases the GIL. "
+        "See C++ API: :cpp:func:`cppcolormap::as_colors`",
+        py::arg("data"),
+        py::arg("colors"),
+        py::arg("vmin") = py::none(),
+        py::arg("vmax") = py::none(),
+        py::arg("out") = py::none()
+    );
+}
+
+/**
+ * Map a NumPy array to colormap indices of type `I`, see as_indices_buffer().
+ */
+template <typename T, typename I>
+py::array_t<I, 0> as_indices_typed(
+    const py::array_t<T, 0>& a,
+    const std::vector<size_t>& shape,
+    const std::vector<ptrdiff_t>& strides,
+    size_t N,
+    std::optional<double> vmin,
+    std::optional<double> vmax
+)
+{
+    py::array_t<I, 0> ret(shape);
+    const T* pd = a.data();
+    I* pr = ret.mutable_data();
+    double lo;
+    double hi;
+
+    {
+        py::gil_scoped_release release;
+
+        if (vmin.has_value()) {
+            lo = *vmin;
+            hi = *vmax;
+        }
+        else {
+            auto range = cppcolormap::detail::strided_minmax(pd, shape, strides);
+            lo = range[0];
+            hi = range[1];
+        }
+
+        if (hi > lo) {
+            cppcolormap::detail::quantiser q(lo, hi, N);
+            cppcolormap::detail::as_indices_strided(pd, shape, strides, q, pr);
+        }
+    }
+
+    if (!(hi > lo)) {
+        throw std::invalid_argument("Expected vmax > vmin");
+    }
+
+    return ret;
+}
+
+/**
+ * Map a NumPy array to colormap indices, operating directly on its buffer (including strides),
+ * using the smallest sufficient unsigned integer type.
+ * The GIL is released while computing.
+ */
+template <typename T>
+py::object as_indices_buffer(
+    const py::array_t<T, 0>& data,
+    size_t N,
+    std::optional<double> vmin,
+    std::optional<double> vmax
+)
+{
+    if (vmin.has_value() != vmax.has_value()) {
+        throw std::invalid_argument("Specify both vmin and vmax, or neither");
+    }
+
+    if (N == 0) {
+        throw std::invalid_argument("Expected N > 0");
+    }
+
+    std::vector<size_t> shape;
+    std::vector<ptrdiff_t> strides;
+    py::array_t<T, 0> a = item_strides(data, shape, strides);
+
+    if (N <= 256) {
+        return as_indices_typed<T, uint8_t>(a, shape, strides, N, vmin, vmax);
+    }
+    if (N <= 65536) {
+        return as_indices_typed<T, uint16_t>(a, shape, strides, N, vmin, vmax);
+    }
+    return as_indices_typed<T, uint32_t>(a, shape, strides, N, vmin, vmax);
+}
+
+template <typename T>
+void def_as_indices(py::module& m)
+{
+    m.def(
+        "as_indices",
+        &as_indices_buffer<T>,
+        "Convert data to colormap indices, using the smallest sufficient unsigned integer type. "
+        "Operates directly on the data (any strides) and releases the GIL. "
+        "See C++ API: :cpp:func:`cppcolormap::as_indices`",
+        py::arg("data"),
+        py::arg("N"),
+        py::arg("vmin") = py::none(),
+        py::arg("vmax") = py::none()
+    );
+}
+
+/**
+ * Inner loop of the generalised ufunc `as_colors_ufunc` with signature `(),(n,c),(),()->(c)`
+ * (data, colors, vmin, vmax -> color).
+ */
+template <typename T>
+void as_colors_ufunc_loop(char** args, npy_intp const* dimensions, npy_intp const* steps, void*)
+{
+    npy_intp N = dimensions[0];
+    npy_intp n = dimensions[1];
+    npy_intp c = dimensions[2];
+    npy_intp sd = steps[0];
+    npy_intp sc = steps[1];
+    npy_intp slo = steps[2];
+    npy_intp shi = steps[3];
+    npy_intp so = steps[4];
+    npy_intp sc_n = steps[5];
+    npy_intp sc_c = steps[6];
+    npy_intp so_c = steps[7];
+    constexpr npy_intp item = sizeof(double);
+
+    if (n == 0) {
+        for (npy_intp i = 0; i < N; ++i) {
+            for (npy_intp j = 0; j < c; ++j) {
+                *reinterpret_cast<double*>(args[4] + i * so + j * so_c) = NAN;
+            }
+        }
+        return;
+    }
+
+    // common case: one colormap and one range, contiguous colormap and output
+    if (sc == 0 && slo == 0 && shi == 0 && sc_c == item && sc_n == c * item && so_c == item &&
+        so == c * item && sd % static_cast<npy_intp>(sizeof(T)) == 0) {
+        const T* data = reinterpret_cast<const T*>(args[0]);
+        const double* colors = reinterpret_cast<const double*>(args[1]);
+        double* out = reinterpret_cast<double*>(args[4]);
+        ptrdiff_t step = static_cast<ptrdiff_t>(sd / static_cast<npy_intp>(sizeof(T)));
+        double lo = *reinterpret_cast<const double*>(args[2]);
+        double hi = *reinterpret_cast<const double*>(args[3]);
+        size_t nc = static_cast<size_t>(c);
+        cppcolormap::detail::quantiser q(lo, hi, static_cast<size_t>(n));
+
+        cppcolormap::detail::parallel_for(
+            static_cast<size_t>(N),
+            cppcolormap::get_parallel_grain(),
+            [&](size_t begin, size_t end) {
+                cppcolormap::detail::as_colors_kernel(
+                    data + static_cast<ptrdiff_t>(begin) * step,
+                    step,
+                    end - begin,
+                    q,
+                    colors,
+                    nc,
+                    out + begin * nc
+                );
+            }
+        );
+        return;
+    }
+
+    for (npy_intp i = 0; i < N; ++i) {
+        T value = *reinterpret_cast<const T*>(args[0] + i * sd);
+        double lo = *reinterpret_cast<const double*>(args[2] + i * slo);
+        double hi = *reinterpret_cast<const double*>(args[3] + i * shi);
+        size_t k = cppcolormap::detail::quantiser(lo, hi, static_cast<size_t>(n))(value);
+        const char* color = args[1] + i * sc + static_cast<npy_intp>(k) * sc_n;
+        char* out = args[4] + i * so;
+
+        for (npy_intp j = 0; j < c; ++j) {
+            *reinterpret_cast<double*>(out + j * so_c) =
+                *reinterpret_cast<const double*>(color + j * sc_c);
+        }
+    }
+}
+
+/**
+ * Register the generalised ufunc `as_colors_ufunc`.
+ * Loops are ordered such that NumPy selects the smallest type to which the data can be safely cast.
+ */
+void def_as_colors_ufunc(py::module& m)
+{
+    if (_import_umath() < 0) {
+        throw py::error_already_set();
+    }
+
+    static PyUFuncGenericFunction funcs[] = {
+        &as_colors_ufunc_loop<int8_t>,
+        &as_colors_ufunc_loop<uint8_t>,
+        &as_colors_ufunc_loop<int16_t>,
+        &as_colors_ufunc_loop<uint16_t>,
+        &as_colors_ufunc_loop<int32_t>,
+        &as_colors_ufunc_loop<uint32_t>,
+        &as_colors_ufunc_loop<int64_t>,
+        &as_colors_ufunc_loop<uint64_t>,
+        &as_colors_ufunc_loop<float>,
+        &as_colors_ufunc_loop<double>,
+    };
+
+    constexpr size_t nloops = sizeof(funcs) / sizeof(funcs[0]);
+
+    static const char dtypes[nloops] = {
+        NPY_INT8,
+        NPY_UINT8,
+        NPY_INT16,
+        NPY_UINT16,
+        NPY_INT32,
+        NPY_UINT32,
+        NPY_INT64,
+        NPY_UINT64,
+        NPY_FLOAT32,
+        NPY_FLOAT64,
+    };
+
+    // (data, colors, vmin, vmax, out) per loop
+    static char types[5 * nloops];
+
+    for (size_t i = 0; i < nloops; ++i) {
+        types[5 * i] = dtypes[i];
+        std::fill(&types[5 * i + 1], &types[5 * i + 5], static_cast<char>(NPY_FLOAT64));
+    }
+
+    static void* data[nloops] = {nullptr};
+
+    PyObject* ufunc = PyUFunc_FromFuncAndDataAndSignature(
+        funcs,
+        data,
+        types,
+        static_cast<int>(nloops),
+        4,
+        1,
+        PyUFunc_None,
+        "as_colors_ufunc",
+        "Convert data to colors, as generalised ufunc with signature (),(n,c),(),()->(c): "
+        "as_colors_ufunc(data, colors, vmin, vmax[, out=...]). "
+        "See C++ API: :cpp:func:`cppcolormap::as_colors`",
+        0,
+        "(),(n,c),(),()->(c)"
+    );
+
+    if (!ufunc) {
+        throw py::error_already_set();
+    }
+
+    m.add_object("as_colors_ufunc", py::reinterpret_steal<py::object>(ufunc));
+}
+
 PYBIND11_MODULE(_cppcolormap, m)
 {
     // Ensure members to display as `cppcolormap.X` rather than `cppcolormap._cppcolormap.X`
@@ -69,13 +460,58 @@ PYBIND11_MODULE(_cppcolormap, m)
         DOC("rgb2hex")
     );
 
+    m.def(
+        "rgb2hex_array",
+        [](const xt::pytensor<double, 2>& arg) {
+            size_t width = 2 * arg.shape(1) + 1;
+            py::array ret(py::dtype("S" + std::to_string(width)), {arg.shape(0)});
+            cppcolormap::rgb2hex_write(arg, static_cast<char*>(ret.mutable_data()));
+            return ret;
+        },
+        "Convert RGB(A) -> HEX as NumPy fixed-width bytes array. "
+        "See C++ API: :cpp:func:`cppcolormap::rgb2hex_array`",
+        py::arg("arg")
+    );
+
     m.def(
         "hex2rgb",
         py::overload_cast<const std::vector<std::string>&>(&cppcolormap::hex2rgb),
         DOC("hex2rgb")
     );
 
-    m.def("hex2rgb", py::overload_cast<const std::string&>(&cppcolormap::hex2rgb), DOC("hex2rgb"));
+    m.def(
+        "hex2rgba",
+        py::overload_cast<const std::vector<std::string>&>(&cppcolormap::hex2rgba),
+        DOC("hex2rgba")
+    );
+
+    m.def(
+        "hex2rgb_array",
+        [](const py::array& arg, bool alpha) {
+            py::array a = py::array::ensure(arg, py::array::c_style);
+            if (!a || a.dtype().kind() != 'S') {
+                throw std::invalid_argument("Expected a NumPy fixed-width bytes array");
+            }
+            size_t n = static_cast<size_t>(a.size());
+            size_t width = static_cast<size_t>(a.itemsize());
+            size_t ncol = alpha ? 4 : 3;
+            const char* buffer = static_cast<const char*>(a.data());
+            xt::pytensor<double, 2> ret = xt::empty<double>({n, ncol});
+            auto get = [&](size_t i) {
+                std::string_view hex(buffer + i * width, width);
+                return hex.substr(0, hex.find('\0'));
+            };
+            cppcolormap::detail::parse_hex(get, n, ret.data(), ncol);
+            return ret;
+        },
+        "Convert HEX -> RGB(A) from a NumPy fixed-width bytes array "
+        "(e.g. the output of :py:func:`cppcolormap.rgb2hex_array`). "
+        "See C++ API: :cpp:func:`cppcolormap::hex2rgb_write`",
+        py::arg("arg"),
+        py::arg("alpha") = false
+    );
+
+    m.def("hex2rgb", py::overload_cast<std::string_view>(&cppcolormap::hex2rgb), DOC("hex2rgb"));
 
     m.def(
         "interp",
@@ -86,228 +522,379 @@ PYBIND11_MODULE(_cppcolormap, m)
     );
 
     m.def(
-        "as_colors",
-        [](const xt::pyarray<double>& data,
-           const xt::pytensor<double, 2>& colors,
-           double vmin,
-           double vmax) { return cppcolormap::as_colors(data, colors, vmin, vmax); },
-        DOC("as_colors"),
-        py::arg("data"),
-        py::arg("colors"),
-        py::arg("vmin"),
-        py::arg("vmax")
+        "interp",
+        static_cast<xt::pytensor<double, 2> (*)(
+            const xt::pytensor<double, 2>&, size_t, cppcolormap::colorspace
+        )>(&cppcolormap::interp),
+        DOC("interp"),
+        py::arg("arg"),
+        py::arg("N"),
+        py::arg("space")
     );
 
+    py::enum_<cppcolormap::colorspace>(m, "colorspace", ENUM("colorspace"))
+        .value("sRGB", cppcolormap::colorspace::sRGB)
+        .value("linear_RGB", cppcolormap::colorspace::linear_RGB)
+        .value("XYZ", cppcolormap::colorspace::XYZ)
+        .value("CIELAB", cppcolormap::colorspace::CIELAB)
+        .value("Oklab", cppcolormap::colorspace::Oklab)
+        .value("HSV", cppcolormap::colorspace::HSV)
+        .value("HSL", cppcolormap::colorspace::HSL)
+        .export_values();
+
     m.def(
-        "as_colors",
-        [](const xt::pyarray<double>& data, const xt::pytensor<double, 2>& colors) {
-            return cppcolormap::as_colors(data, colors);
-        },
-        DOC("as_colors"),
-        py::arg("data"),
-        py::arg("colors")
+        "convert",
+        &cppcolormap::convert<xt::pytensor<double, 2>>,
+        DOC("convert"),
+        py::arg("arg"),
+        py::arg("source"),
+        py::arg("target")
+    );
+
+    m.def(
+        "convert",
+        &cppcolormap::convert<xt::pytensor<uint8_t, 2>>,
+        DOC("convert"),
+        py::arg("arg"),
+        py::arg("source"),
+        py::arg("target")
     );
 
-    m.def("Accent", &cppcolormap::Accent, DOC("Accent"), py::arg("N") = 8);
-    m.def("Dark2", &cppcolormap::Dark2, DOC("Dark2"), py::arg("N") = 8);
-    m.def("Paired", &cppcolormap::Paired, DOC("Paired"), py::arg("N") = 12);
-    m.def("Spectral", &cppcolormap::Spectral, DOC("Spectral"), py::arg("N") = 11);
-    m.def("Pastel1", &cppcolormap::Pastel1, DOC("Pastel1"), py::arg("N") = 9);
-    m.def("Pastel2", &cppcolormap::Pastel2, DOC("Pastel2"), py::arg("N") = 8);
-    m.def("Set1", &cppcolormap::Set1, DOC("Set1"), py::arg("N") = 9);
-    m.def("Set2", &cppcolormap::Set2, DOC("Set2"), py::arg("N") = 8);
-    m.def("Set3", &cppcolormap::Set3, DOC("Set3"), py::arg("N") = 12);
-    m.def("Blues", &cppcolormap::Blues, DOC("Blues"), py::arg("N") = 9);
-    m.def("Greens", &cppcolormap::Greens, DOC("Greens"), py::arg("N") = 9);
-    m.def("Greys", &cppcolormap::Greys, DOC("Greys"), py::arg("N") = 2);
-    m.def("Oranges", &cppcolormap::Oranges, DOC("Oranges"), py::arg("N") = 9);
-    m.def("Purples", &cppcolormap::Purples, DOC("Purples"), py::arg("N") = 9);
-    m.def("Reds", &cppcolormap::Reds, DOC("Reds"), py::arg("N") = 9);
-    m.def("BuPu", &cppcolormap::BuPu, DOC("BuPu"), py::arg("N") = 9);
-    m.def("GnBu", &cppcolormap::GnBu, DOC("GnBu"), py::arg("N") = 9);
-    m.def("PuBu", &cppcolormap::PuBu, DOC("PuBu"), py::arg("N") = 9);
-    m.def("PuBuGn", &cppcolormap::PuBuGn, DOC("PuBuGn"), py::arg("N") = 9);
-    m.def("PuRd", &cppcolormap::PuRd, DOC("PuRd"), py::arg("N") = 9);
-    m.def("RdPu", &cppcolormap::RdPu, DOC("RdPu"), py::arg("N") = 9);
-    m.def("OrRd", &cppcolormap::OrRd, DOC("OrRd"), py::arg("N") = 9);
-    m.def("RdOrYl", &cppcolormap::RdOrYl, DOC("RdOrYl"), py::arg("N") = 9);
-    m.def("YlGn", &cppcolormap::YlGn, DOC("YlGn"), py::arg("N") = 9);
-    m.def("YlGnBu", &cppcolormap::YlGnBu, DOC("YlGnBu"), py::arg("N") = 9);
-    m.def("YlOrRd", &cppcolormap::YlOrRd, DOC("YlOrRd"), py::arg("N") = 9);
-    m.def("BrBG", &cppcolormap::BrBG, DOC("BrBG"), py::arg("N") = 11);
-    m.def("PuOr", &cppcolormap::PuOr, DOC("PuOr"), py::arg("N") = 11);
-    m.def("RdBu", &cppcolormap::RdBu, DOC("RdBu"), py::arg("N") = 11);
-    m.def("RdGy", &cppcolormap::RdGy, DOC("RdGy"), py::arg("N") = 11);
-    m.def("RdYlBu", &cppcolormap::RdYlBu, DOC("RdYlBu"), py::arg("N") = 11);
-    m.def("RdYlGn", &cppcolormap::RdYlGn, DOC("RdYlGn"), py::arg("N") = 11);
-    m.def("PiYG", &cppcolormap::PiYG, DOC("PiYG"), py::arg("N") = 11);
-    m.def("PRGn", &cppcolormap::PRGn, DOC("PRGn"), py::arg("N") = 11);
-
-    m.def("Accent_r", &cppcolormap::Accent_r, DOC("Accent_r"), py::arg("N") = 8);
-    m.def("Dark2_r", &cppcolormap::Dark2_r, DOC("Dark2_r"), py::arg("N") = 8);
-    m.def("Paired_r", &cppcolormap::Paired_r, DOC("Paired_r"), py::arg("N") = 12);
-    m.def("Spectral_r", &cppcolormap::Spectral_r, DOC("Spectra_r"), py::arg("N") = 11);
-    m.def("Pastel1_r", &cppcolormap::Pastel1_r, DOC("Pastel1_r"), py::arg("N") = 9);
-    m.def("Pastel2_r", &cppcolormap::Pastel2_r, DOC("Pastel2_r"), py::arg("N") = 8);
-    m.def("Set1_r", &cppcolormap::Set1_r, DOC("Set1_r"), py::arg("N") = 9);
-    m.def("Set2_r", &cppcolormap::Set2_r, DOC("Set2_r"), py::arg("N") = 8);
-    m.def("Set3_r", &cppcolormap::Set3_r, DOC("Set3_r"), py::arg("N") = 12);
-    m.def("Blues_r", &cppcolormap::Blues_r, DOC("Blues_r"), py::arg("N") = 9);
-    m.def("Greens_r", &cppcolormap::Greens_r, DOC("Greens_r"), py::arg("N") = 9);
-    m.def("Greys_r", &cppcolormap::Greys_r, DOC("Greys_r"), py::arg("N") = 2);
-    m.def("Oranges_r", &cppcolormap::Oranges_r, DOC("Oranges_r"), py::arg("N") = 9);
-    m.def("Purples_r", &cppcolormap::Purples_r, DOC("Purples_r"), py::arg("N") = 9);
-    m.def("Reds_r", &cppcolormap::Reds_r, DOC("Reds_r"), py::arg("N") = 9);
-    m.def("BuPu_r", &cppcolormap::BuPu_r, DOC("BuPu_r"), py::arg("N") = 9);
-    m.def("GnBu_r", &cppcolormap::GnBu_r, DOC("GnBu_r"), py::arg("N") = 9);
-    m.def("PuBu_r", &cppcolormap::PuBu_r, DOC("PuBu_r"), py::arg("N") = 9);
-    m.def("PuBuGn_r", &cppcolormap::PuBuGn_r, DOC("PuBuGn_r"), py::arg("N") = 9);
-    m.def("PuRd_r", &cppcolormap::PuRd_r, DOC("PuRd_r"), py::arg("N") = 9);
-    m.def("RdPu_r", &cppcolormap::RdPu_r, DOC("RdPu_r"), py::arg("N") = 9);
-    m.def("OrRd_r", &cppcolormap::OrRd_r, DOC("OrRd_r"), py::arg("N") = 9);
-    m.def("RdOrYl_r", &cppcolormap::RdOrYl_r, DOC("RdOrYl_r"), py::arg("N") = 9);
-    m.def("YlGn_r", &cppcolormap::YlGn_r, DOC("YlGn_r"), py::arg("N") = 9);
-    m.def("YlGnBu_r", &cppcolormap::YlGnBu_r, DOC("YlGnBu_r"), py::arg("N") = 9);
-    m.def("YlOrRd_r", &cppcolormap::YlOrRd_r, DOC("YlOrRd_r"), py::arg("N") = 9);
-    m.def("BrBG_r", &cppcolormap::BrBG_r, DOC("BrBG_r"), py::arg("N") = 11);
-    m.def("PuOr_r", &cppcolormap::PuOr_r, DOC("PuOr_r"), py::arg("N") = 11);
-    m.def("RdBu_r", &cppcolormap::RdBu_r, DOC("RdBu_r"), py::arg("N") = 11);
-    m.def("RdGy_r", &cppcolormap::RdGy_r, DOC("RdGy_r"), py::arg("N") = 11);
-    m.def("RdYlBu_r", &cppcolormap::RdYlBu_r, DOC("RdYlBu_r"), py::arg("N") = 11);
-    m.def("RdYlGn_r", &cppcolormap::RdYlGn_r, DOC("RdYlGn_r"), py::arg("N") = 11);
-    m.def("PiYG_r", &cppcolormap::PiYG_r, DOC("PiYG_r"), py::arg("N") = 11);
-    m.def("PRGn_r", &cppcolormap::PRGn_r, DOC("PRGn_r"), py::arg("N") = 11);
-
-    m.def("spring", &cppcolormap::spring, DOC("spring"), py::arg("N") = 256);
-    m.def("summer", &cppcolormap::summer, DOC("summer"), py::arg("N") = 256);
-    m.def("autumn", &cppcolormap::autumn, DOC("autumn"), py::arg("N") = 256);
-    m.def("winter", &cppcolormap::winter, DOC("winter"), py::arg("N") = 256);
-    m.def("bone", &cppcolormap::bone, DOC("bone"), py::arg("N") = 256);
-    m.def("cool", &cppcolormap::cool, DOC("cool"), py::arg("N") = 256);
-    m.def("hot", &cppcolormap::hot, DOC("hot"), py::arg("N") = 256);
-    m.def("copper", &cppcolormap::copper, DOC("copper"), py::arg("N") = 256);
-    m.def("hsv", &cppcolormap::hsv, DOC("hsv"), py::arg("N") = 256);
-    m.def("nipy_spectral", &cppcolormap::nipy_spectral, DOC("nipy_spectral"), py::arg("N") = 256);
-    m.def("terrain", &cppcolormap::terrain, DOC("terrain"), py::arg("N") = 6);
-    m.def("seismic", &cppcolormap::seismic, DOC("seismic"), py::arg("N") = 5);
-    m.def("afmhot", &cppcolormap::afmhot, DOC("afmhot"), py::arg("N") = 256);
-    m.def("magma", &cppcolormap::magma, DOC("magma"), py::arg("N") = 256);
-    m.def("inferno", &cppcolormap::inferno, DOC("inferno"), py::arg("N") = 256);
-    m.def("plasma", &cppcolormap::plasma, DOC("plasma"), py::arg("N") = 256);
-    m.def("viridis", &cppcolormap::viridis, DOC("viridis"), py::arg("N") = 256);
-    m.def("jet", &cppcolormap::jet, DOC("jet"), py::arg("N") = 256);
-
-    m.def("spring_r", &cppcolormap::spring_r, DOC("spring_r"), py::arg("N") = 256);
-    m.def("summer_r", &cppcolormap::summer_r, DOC("summer_r"), py::arg("N") = 256);
-    m.def("autumn_r", &cppcolormap::autumn_r, DOC("autumn_r"), py::arg("N") = 256);
-    m.def("winter_r", &cppcolormap::winter_r, DOC("winter_r"), py::arg("N") = 256);
-    m.def("bone_r", &cppcolormap::bone_r, DOC("bone_r"), py::arg("N") = 256);
-    m.def("cool_r", &cppcolormap::cool_r, DOC("cool_r"), py::arg("N") = 256);
-    m.def("hot_r", &cppcolormap::hot_r, DOC("hot_r"), py::arg("N") = 256);
-    m.def("copper_r", &cppcolormap::copper_r, DOC("copper_r"), py::arg("N") = 256);
-    m.def("hsv_r", &cppcolormap::hsv_r, DOC("hsv_r"), py::arg("N") = 256);
     m.def(
-        "nipy_spectral_r", &cppcolormap::nipy_spectral_r, DOC("nipy_spectral_r"), py::arg("N") = 256
+        "pack_srgb8",
+        &cppcolormap::pack_srgb8<xt::pytensor<double, 2>>,
+        DOC("pack_srgb8"),
+        py::arg("arg"),
+        py::arg("source") = cppcolormap::colorspace::sRGB
     );
-    m.def("terrain_r", &cppcolormap::terrain_r, DOC("terrain_r"), py::arg("N") = 6);
-    m.def("seismic_r", &cppcolormap::seismic_r, DOC("seismic_r"), py::arg("N") = 5);
-    m.def("afmhot_r", &cppcolormap::afmhot_r, DOC("afmhot_r"), py::arg("N") = 256);
-    m.def("magma_r", &cppcolormap::magma_r, DOC("magma_r"), py::arg("N") = 256);
-    m.def("inferno_r", &cppcolormap::inferno_r, DOC("inferno_r"), py::arg("N") = 256);
-    m.def("plasma_r", &cppcolormap::plasma_r, DOC("plasma_r"), py::arg("N") = 256);
-    m.def("viridis_r", &cppcolormap::viridis_r, DOC("viridis_r"), py::arg("N") = 256);
-    m.def("jet_r", &cppcolormap::jet_r, DOC("jet_r"), py::arg("N") = 256);
-
-    m.def("Apricot", &cppcolormap::Apricot, DOC("Apricot"), py::arg("N") = 1);
-    m.def("Aquamarine", &cppcolormap::Aquamarine, DOC("Aquamarine"), py::arg("N") = 1);
-    m.def("Bittersweet", &cppcolormap::Bittersweet, DOC("Bittersweet"), py::arg("N") = 1);
-    m.def("Black", &cppcolormap::Black, DOC("Black"), py::arg("N") = 1);
-    m.def("Blue", &cppcolormap::Blue, DOC("Blue"), py::arg("N") = 1);
-    m.def("BlueGreen", &cppcolormap::BlueGreen, DOC("BlueGreen"), py::arg("N") = 1);
-    m.def("BlueViolet", &cppcolormap::BlueViolet, DOC("BlueViolet"), py::arg("N") = 1);
-    m.def("BrickRed", &cppcolormap::BrickRed, DOC("BrickRed"), py::arg("N") = 1);
-    m.def("Brown", &cppcolormap::Brown, DOC("Brown"), py::arg("N") = 1);
-    m.def("BurntOrange", &cppcolormap::BurntOrange, DOC("BurntOrange"), py::arg("N") = 1);
-    m.def("CadetBlue", &cppcolormap::CadetBlue, DOC("CadetBlue"), py::arg("N") = 1);
-    m.def("CarnationPink", &cppcolormap::CarnationPink, DOC("CarnationPink"), py::arg("N") = 1);
-    m.def("Cerulean", &cppcolormap::Cerulean, DOC("Cerulean"), py::arg("N") = 1);
-    m.def("CornflowerBlue", &cppcolormap::CornflowerBlue, DOC("CornflowerBlue"), py::arg("N") = 1);
-    m.def("Cyan", &cppcolormap::Cyan, DOC("Cyan"), py::arg("N") = 1);
-    m.def("Dandelion", &cppcolormap::Dandelion, DOC("Dandelion"), py::arg("N") = 1);
-    m.def("DarkOrchid", &cppcolormap::DarkOrchid, DOC("DarkOrchid"), py::arg("N") = 1);
-    m.def("Emerald", &cppcolormap::Emerald, DOC("Emerald"), py::arg("N") = 1);
-    m.def("ForestGreen", &cppcolormap::ForestGreen, DOC("ForestGreen"), py::arg("N") = 1);
-    m.def("Fuchsia", &cppcolormap::Fuchsia, DOC("Fuchsia"), py::arg("N") = 1);
-    m.def("Goldenrod", &cppcolormap::Goldenrod, DOC("Goldenrod"), py::arg("N") = 1);
-    m.def("Gray", &cppcolormap::Gray, DOC("Gray"), py::arg("N") = 1);
-    m.def("Green", &cppcolormap::Green, DOC("Green"), py::arg("N") = 1);
-    m.def("GreenYellow", &cppcolormap::GreenYellow, DOC("GreenYellow"), py::arg("N") = 1);
-    m.def("Grey", &cppcolormap::Grey, DOC("Grey"), py::arg("N") = 1);
-    m.def("JungleGreen", &cppcolormap::JungleGreen, DOC("JungleGreen"), py::arg("N") = 1);
-    m.def("Lavender", &cppcolormap::Lavender, DOC("Lavender"), py::arg("N") = 1);
-    m.def("LimeGreen", &cppcolormap::LimeGreen, DOC("LimeGreen"), py::arg("N") = 1);
-    m.def("Magenta", &cppcolormap::Magenta, DOC("Magenta"), py::arg("N") = 1);
-    m.def("Mahogany", &cppcolormap::Mahogany, DOC("Mahogany"), py::arg("N") = 1);
-    m.def("Maroon", &cppcolormap::Maroon, DOC("Maroon"), py::arg("N") = 1);
-    m.def("Melon", &cppcolormap::Melon, DOC("Melon"), py::arg("N") = 1);
-    m.def("MidnightBlue", &cppcolormap::MidnightBlue, DOC("MidnightBlue"), py::arg("N") = 1);
-    m.def("Mulberry", &cppcolormap::Mulberry, DOC("Mulberry"), py::arg("N") = 1);
-    m.def("NavyBlue", &cppcolormap::NavyBlue, DOC("NavyBlue"), py::arg("N") = 1);
-    m.def("OliveGreen", &cppcolormap::OliveGreen, DOC("OliveGreen"), py::arg("N") = 1);
-    m.def("Orange", &cppcolormap::Orange, DOC("Orange"), py::arg("N") = 1);
-    m.def("OrangeRed", &cppcolormap::OrangeRed, DOC("OrangeRed"), py::arg("N") = 1);
-    m.def("Orchid", &cppcolormap::Orchid, DOC("Orchid"), py::arg("N") = 1);
-    m.def("Peach", &cppcolormap::Peach, DOC("Peach"), py::arg("N") = 1);
-    m.def("Periwinkle", &cppcolormap::Periwinkle, DOC("Periwinkle"), py::arg("N") = 1);
-    m.def("PineGreen", &cppcolormap::PineGreen, DOC("PineGreen"), py::arg("N") = 1);
-    m.def("Plum", &cppcolormap::Plum, DOC("Plum"), py::arg("N") = 1);
-    m.def("ProcessBlue", &cppcolormap::ProcessBlue, DOC("ProcessBlue"), py::arg("N") = 1);
-    m.def("Purple", &cppcolormap::Purple, DOC("Purple"), py::arg("N") = 1);
-    m.def("RawSienna", &cppcolormap::RawSienna, DOC("RawSienna"), py::arg("N") = 1);
-    m.def("Red", &cppcolormap::Red, DOC("Red"), py::arg("N") = 1);
-    m.def("RedOrange", &cppcolormap::RedOrange, DOC("RedOrange"), py::arg("N") = 1);
-    m.def("RedViolet", &cppcolormap::RedViolet, DOC("RedViolet"), py::arg("N") = 1);
-    m.def("Rhodamine", &cppcolormap::Rhodamine, DOC("Rhodamine"), py::arg("N") = 1);
-    m.def("RoyalBlue", &cppcolormap::RoyalBlue, DOC("RoyalBlue"), py::arg("N") = 1);
-    m.def("RoyalPurple", &cppcolormap::RoyalPurple, DOC("RoyalPurple"), py::arg("N") = 1);
-    m.def("RubineRed", &cppcolormap::RubineRed, DOC("RubineRed"), py::arg("N") = 1);
-    m.def("Salmon", &cppcolormap::Salmon, DOC("Salmon"), py::arg("N") = 1);
-    m.def("SeaGreen", &cppcolormap::SeaGreen, DOC("SeaGreen"), py::arg("N") = 1);
-    m.def("Sepia", &cppcolormap::Sepia, DOC("Sepia"), py::arg("N") = 1);
-    m.def("SkyBlue", &cppcolormap::SkyBlue, DOC("SkyBlue"), py::arg("N") = 1);
-    m.def("SpringGreen", &cppcolormap::SpringGreen, DOC("SpringGreen"), py::arg("N") = 1);
-    m.def("Tan", &cppcolormap::Tan, DOC("Tan"), py::arg("N") = 1);
-    m.def("TealBlue", &cppcolormap::TealBlue, DOC("TealBlue"), py::arg("N") = 1);
-    m.def("Thistle", &cppcolormap::Thistle, DOC("Thistle"), py::arg("N") = 1);
-    m.def("tueblue", &cppcolormap::tueblue, DOC("tueblue"), py::arg("N") = 1);
-    m.def("tuedarkblue", &cppcolormap::tuedarkblue, DOC("tuedarkblue"), py::arg("N") = 1);
-    m.def("tuelightblue", &cppcolormap::tuelightblue, DOC("tuelightblue"), py::arg("N") = 1);
-    m.def("tuewarmred", &cppcolormap::tuewarmred, DOC("tuewarmred"), py::arg("N") = 1);
-    m.def("Turquoise", &cppcolormap::Turquoise, DOC("Turquoise"), py::arg("N") = 1);
-    m.def("Violet", &cppcolormap::Violet, DOC("Violet"), py::arg("N") = 1);
-    m.def("VioletRed", &cppcolormap::VioletRed, DOC("VioletRed"), py::arg("N") = 1);
-    m.def("White", &cppcolormap::White, DOC("White"), py::arg("N") = 1);
-    m.def("WildStrawberry", &cppcolormap::WildStrawberry, DOC("WildStrawberry"), py::arg("N") = 1);
-    m.def("Yellow", &cppcolormap::Yellow, DOC("Yellow"), py::arg("N") = 1);
-    m.def("YellowGreen", &cppcolormap::YellowGreen, DOC("YellowGreen"), py::arg("N") = 1);
-    m.def("YellowOrange", &cppcolormap::YellowOrange, DOC("YellowOrange"), py::arg("N") = 1);
-
-    m.def("xterm", &cppcolormap::xterm, DOC("xterm"));
-    m.def("tue", &cppcolormap::tue, DOC("tue"));
-
-    m.def("xterm_r", &cppcolormap::xterm_r, DOC("xterm_r"));
-    m.def("tue_r", &cppcolormap::tue_r, DOC("tue_r"));
 
+    def_as_colors_ufunc(m);
+
+    // first: other dtypes are converted to float64
+    def_as_colors<double>(m);
+    def_as_colors<float>(m);
+    def_as_colors<int8_t>(m);
+    def_as_colors<uint8_t>(m);
+    def_as_colors<int16_t>(m);
+    def_as_colors<uint16_t>(m);
+    def_as_colors<int32_t>(m);
+    def_as_colors<int64_t>(m);
+
+    // first: other dtypes are converted to float64
+    def_as_indices<double>(m);
+    def_as_indices<float>(m);
+    def_as_indices<int8_t>(m);
+    def_as_indices<uint8_t>(m);
+    def_as_indices<int16_t>(m);
+    def_as_indices<uint16_t>(m);
+    def_as_indices<int32_t>(m);
+    def_as_indices<int64_t>(m);
+
+    m.def("set_num_threads", &cppcolormap::set_num_threads, DOC("set_num_threads"), py::arg("n"));
+    m.def("get_num_threads", &cppcolormap::get_num_threads, DOC("get_num_threads"));
+
+    m.def(
+        "set_parallel_grain",
+        &cppcolormap::set_parallel_grain,
+        DOC("set_parallel_grain"),
+        py::arg("n")
+    );
+    m.def("get_parallel_grain", &cppcolormap::get_parallel_grain, DOC("get_parallel_grain"));
+
+    py::enum_<cppcolormap::parallel_backend>(m, "parallel_backend", ENUM("parallel_backend"))
+        .value("serial", cppcolormap::parallel_backend::serial)
+        .value("thread_pool", cppcolormap::parallel_backend::thread_pool)
+        .value("openmp", cppcolormap::parallel_backend::openmp)
+        .value("tbb_arena", cppcolormap::parallel_backend::tbb_arena)
+        .value("callback", cppcolormap::parallel_backend::callback)
+        .export_values();
+
+    m.def(
+        "has_parallel_backend",
+        &cppcolormap::has_parallel_backend,
+        DOC("has_parallel_backend"),
+        py::arg("backend")
+    );
+
+    m.def(
+        "set_parallel_backend",
+        &cppcolormap::set_parallel_backend,
+        DOC("set_parallel_backend"),
+        py::arg("backend")
+    );
+
+    m.def("get_parallel_backend", &cppcolormap::get_parallel_backend, DOC("get_parallel_backend"));
+
+    m.def("stats_enabled", &cppcolormap::stats_enabled, DOC("stats_enabled"));
+    m.def("reset_stats", &cppcolormap::reset_stats, DOC("reset_stats"));
+
+    m.def(
+        "stats",
+        []() {
+            auto entry = [](const cppcolormap::StatsEntry& e) {
+                py::dict ret;
+                ret["calls"] = e.calls;
+                ret["elements"] = e.elements;
+                ret["bytes"] = e.bytes;
+                ret["seconds"] = e.seconds;
+                ret["threads"] = e.threads;
+                return ret;
+            };
+            cppcolormap::Stats s = cppcolormap::stats();
+            py::dict ret;
+            ret["as_colors"] = entry(s.as_colors);
+            ret["match"] = entry(s.match);
+            ret["interp"] = entry(s.interp);
+            ret["colormap"] = entry(s.colormap);
+            return ret;
+        },
+        "Statistics (calls, elements, bytes, seconds, threads) per function, as dictionary. "
+        "See C++ API: :cpp:func:`cppcolormap::stats`"
+    );
+
+    // individual colormaps are looked-up lazily (module "__getattr__" in "__init__.py")
     m.def("colormap", &cppcolormap::colormap, DOC("colormap"), py::arg("cmap"), py::arg("N") = 256);
 
+    m.def("is_registered", &cppcolormap::is_registered, DOC("is_registered"), py::arg("cmap"));
+
+    m.def(
+        "registered_colormaps", &cppcolormap::registered_colormaps, DOC("registered_colormaps")
+    );
+
+    m.def(
+        "load_colormap_pack",
+        &cppcolormap::load_colormap_pack,
+        DOC("load_colormap_pack"),
+        py::arg("path")
+    );
+
+    m.def("load_colormaps", &cppcolormap::load_colormaps, DOC("load_colormaps"), py::arg("path"));
+
+    m.def(
+        "write_colormap_pack",
+        [](const std::string& path, std::optional<std::vector<std::string>> names) {
+            cppcolormap::write_colormap_pack(
+                path, names ? *names : cppcolormap::registered_colormaps()
+            );
+        },
+        DOC("write_colormap_pack"),
+        py::arg("path"),
+        py::arg("names") = py::none()
+    );
+
+    m.def(
+        "colormap_size",
+        [](const std::string& cmap) { return cppcolormap::registry_entry(cmap).N; },
+        "Default number of colors of a colormap in the registry. "
+        "See C++ API: :cpp:func:`cppcolormap::registry_entry`",
+        py::arg("cmap")
+    );
+
     m.def("colorcycle", &cppcolormap::colorcycle, DOC("colorcycle"), py::arg("cmap"));
 
     py::enum_<cppcolormap::metric>(m, "metric", ENUM("metric"))
         .value("euclidean", cppcolormap::metric::euclidean)
         .value("fast_perceptual", cppcolormap::metric::fast_perceptual)
         .value("perceptual", cppcolormap::metric::perceptual)
+        .value("delta_e_cie76", cppcolormap::metric::delta_e_cie76)
+        .value("delta_e_oklab", cppcolormap::metric::delta_e_oklab)
         .export_values();
 
-    m.def("match", &cppcolormap::match, DOC("match"));
+    m.def(
+        "match",
+        static_cast<xt::pytensor<size_t, 1> (*)(
+            const xt::pytensor<double, 2>&, const xt::pytensor<double, 2>&, cppcolormap::metric
+        )>(&cppcolormap::match),
+        DOC("match"),
+        py::arg("A"),
+        py::arg("B"),
+        py::arg("distance_metric") = cppcolormap::euclidean
+    );
+
+    m.def(
+        "dither_ordered",
+        [](const xt::pytensor<double, 3>& image,
+           const xt::pytensor<double, 2>& palette,
+           double spread,
+           cppcolormap::metric distance_metric) -> py::object {
+            if (palette.shape(0) <= 256) {
+                return py::cast(
+                    cppcolormap::dither_ordered<uint8_t>(image, palette, spread, distance_metric)
+                );
+            }
+            if (palette.shape(0) <= 65536) {
+                return py::cast(
+                    cppcolormap::dither_ordered<uint16_t>(image, palette, spread, distance_metric)
+                );
+            }
+            return py::cast(
+                cppcolormap::dither_ordered<uint32_t>(image, palette, spread, distance_metric)
+            );
+        },
+        "Quantise an image to a palette using ordered dithering. "
+        "See C++ API: :cpp:func:`cppcolormap::dither_ordered`",
+        py::arg("image"),
+        py::arg("palette"),
+        py::arg("spread"),
+        py::arg("distance_metric") = cppcolormap::metric::euclidean
+    );
+
+    m.def(
+        "dither_ordered",
+        [](const xt::pytensor<double, 3>& image,
+           const xt::pytensor<double, 2>& palette,
+           cppcolormap::metric distance_metric) -> py::object {
+            if (palette.shape(0) <= 256) {
+                return py::cast(
+                    cppcolormap::dither_ordered<uint8_t>(image, palette, distance_metric)
+                );
+            }
+            if (palette.shape(0) <= 65536) {
+                return py::cast(
+                    cppcolormap::dither_ordered<uint16_t>(image, palette, distance_metric)
+                );
+            }
+            return py::cast(
+                cppcolormap::dither_ordered<uint32_t>(image, palette, distance_metric)
+            );
+        },
+        "Quantise an image to a palette using ordered dithering. "
+        "See C++ API: :cpp:func:`cppcolormap::dither_ordered`",
+        py::arg("image"),
+        py::arg("palette"),
+        py::arg("distance_metric") = cppcolormap::metric::euclidean
+    );
+
+    m.def(
+        "dither_floyd_steinberg",
+        [](const xt::pytensor<double, 3>& image,
+           const xt::pytensor<double, 2>& palette,
+           cppcolormap::metric distance_metric,
+           bool serpentine) -> py::object {
+            if (palette.shape(0) <= 256) {
+                return py::cast(cppcolormap::dither_floyd_steinberg<uint8_t>(
+                    image, palette, distance_metric, serpentine
+                ));
+            }
+            if (palette.shape(0) <= 65536) {
+                return py::cast(cppcolormap::dither_floyd_steinberg<uint16_t>(
+                    image, palette, distance_metric, serpentine
+                ));
+            }
+            return py::cast(cppcolormap::dither_floyd_steinberg<uint32_t>(
+                image, palette, distance_metric, serpentine
+            ));
+        },
+        "Quantise an image to a palette using Floyd-Steinberg error diffusion. "
+        "See C++ API: :cpp:func:`cppcolormap::dither_floyd_steinberg`",
+        py::arg("image"),
+        py::arg("palette"),
+        py::arg("distance_metric") = cppcolormap::metric::euclidean,
+        py::arg("serpentine") = true
+    );
+
+    py::enum_<cppcolormap::ansi>(m, "ansi", ENUM("ansi"))
+        .value("truecolor", cppcolormap::ansi::truecolor)
+        .value("xterm256", cppcolormap::ansi::xterm256)
+        .export_values();
+
+    py::class_<cppcolormap::AnsiRenderer>(m, "AnsiRenderer")
+        .def(
+            py::init<const xt::pytensor<double, 2>&, cppcolormap::ansi>(),
+            "See C++ API: :cpp:class:`cppcolormap::AnsiRenderer`",
+            py::arg("colors"),
+            py::arg("mode") = cppcolormap::ansi::truecolor
+        )
+        .def(
+            "render",
+            py::overload_cast<const xt::pytensor<double, 2>&, size_t, size_t, double, double>(
+                &cppcolormap::AnsiRenderer::render<xt::pytensor<double, 2>>
+            ),
+            "See C++ API: :cpp:func:`cppcolormap::AnsiRenderer::render`",
+            py::arg("data"),
+            py::arg("cols"),
+            py::arg("rows"),
+            py::arg("vmin"),
+            py::arg("vmax")
+        )
+        .def(
+            "render",
+            py::overload_cast<const xt::pytensor<double, 2>&, size_t, size_t>(
+                &cppcolormap::AnsiRenderer::render<xt::pytensor<double, 2>>
+            ),
+            "See C++ API: :cpp:func:`cppcolormap::AnsiRenderer::render`",
+            py::arg("data"),
+            py::arg("cols"),
+            py::arg("rows")
+        )
+        .def("__str__", &cppcolormap::AnsiRenderer::str);
+
+    m.def(
+        "as_ansi",
+        &cppcolormap::as_ansi<xt::pytensor<double, 2>, xt::pytensor<double, 2>>,
+        DOC("as_ansi"),
+        py::arg("data"),
+        py::arg("colors"),
+        py::arg("cols"),
+        py::arg("rows"),
+        py::arg("mode") = cppcolormap::ansi::truecolor
+    );
+
+    py::class_<cppcolormap::SharedColormap>(
+        m,
+        "SharedColormap",
+        py::buffer_protocol(),
+        "Colormap in shared memory, exposed read-only via the buffer protocol "
+        "(use ``numpy.asarray``). "
+        "See C++ API: :cpp:class:`cppcolormap::SharedColormap`"
+    )
+        .def_static(
+            "publish",
+            &cppcolormap::SharedColormap::publish<xt::pytensor<double, 2>>,
+            "See C++ API: :cpp:func:`cppcolormap::SharedColormap::publish`",
+            py::arg("name"),
+            py::arg("colors")
+        )
+        .def_static(
+            "attach",
+            &cppcolormap::SharedColormap::attach,
+            "See C++ API: :cpp:func:`cppcolormap::SharedColormap::attach`",
+            py::arg("name")
+        )
+        .def_static(
+            "unlink",
+            &cppcolormap::SharedColormap::unlink,
+            "See C++ API: :cpp:func:`cppcolormap::SharedColormap::unlink`",
+            py::arg("name")
+        )
+        .def_static(
+            "publish_file",
+            &cppcolormap::SharedColormap::publish_file<xt::pytensor<double, 2>>,
+            "See C++ API: :cpp:func:`cppcolormap::SharedColormap::publish_file`",
+            py::arg("path"),
+            py::arg("colors")
+        )
+        .def_static(
+            "attach_file",
+            &cppcolormap::SharedColormap::attach_file,
+            "See C++ API: :cpp:func:`cppcolormap::SharedColormap::attach_file`",
+            py::arg("path")
+        )
+        .def_property_readonly("rows", &cppcolormap::SharedColormap::rows)
+        .def_property_readonly("cols", &cppcolormap::SharedColormap::cols)
+        .def_buffer([](const cppcolormap::SharedColormap& self) {
+            py::ssize_t rows = static_cast<py::ssize_t>(self.rows());
+            py::ssize_t cols = static_cast<py::ssize_t>(self.cols());
+            py::ssize_t item = static_cast<py::ssize_t>(sizeof(double));
+            return py::buffer_info(
+                const_cast<double*>(self.data()),
+                item,
+                py::format_descriptor<double>::format(),
+                2,
+                {rows, cols},
+                {cols * item, item},
+                true
+            );
+        });
 
 } // PYBIND11_MODULE
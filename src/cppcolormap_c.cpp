@@ -0,0 +1,318 @@
+/**
+ * Implementation of the C API, see cppcolormap_c.h.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#include <cppcolormap.h>
+#include <cppcolormap_c.h>
+#include <new>
+#include <string>
+
+struct cppcolormap_cmap {
+    cppcolormap::CompiledColormap<uint8_t> table;
+};
+
+namespace {
+
+std::string& last_error()
+{
+    static thread_local std::string ret;
+    return ret;
+}
+
+/**
+ * Call `func()`, converting exceptions to a status code (and storing the message).
+ */
+template <class F>
+int guard(const F& func)
+{
+    last_error().clear();
+
+    try {
+        func();
+        return CPPCOLORMAP_OK;
+    }
+    catch (const std::invalid_argument& e) {
+        last_error() = e.what();
+        return CPPCOLORMAP_ERROR_INVALID_ARGUMENT;
+    }
+    catch (const std::out_of_range& e) {
+        last_error() = e.what();
+        return CPPCOLORMAP_ERROR_INVALID_ARGUMENT;
+    }
+    catch (const std::exception& e) {
+        last_error() = e.what();
+        return CPPCOLORMAP_ERROR_INTERNAL;
+    }
+    catch (...) {
+        last_error() = "Unknown error";
+        return CPPCOLORMAP_ERROR_INTERNAL;
+    }
+}
+
+void require(bool condition, const char* message)
+{
+    if (!condition) {
+        throw std::invalid_argument(message);
+    }
+}
+
+cppcolormap::pixel_format format(int value)
+{
+    require(value >= CPPCOLORMAP_RGB && value <= CPPCOLORMAP_BGRA, "Unknown pixel format");
+    return static_cast<cppcolormap::pixel_format>(value);
+}
+
+cppcolormap_cmap* create(cppcolormap::ColormapSpan colors, int fmt)
+{
+    require(colors.rows > 0, "Empty colormap");
+    require(colors.cols == 3 || colors.cols == 4, "Colormap must have 3 or 4 columns");
+    return new cppcolormap_cmap{cppcolormap::CompiledColormap<uint8_t>(colors, format(fmt))};
+}
+
+template <typename T>
+int map(
+    const cppcolormap_cmap* cmap,
+    const T* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return guard([&]() {
+        require(cmap != nullptr, "cmap is NULL");
+        require(n == 0 || (data != nullptr && out != nullptr), "data or out is NULL");
+        require(vmax > vmin, "vmax must be larger than vmin");
+        cppcolormap::as_colors(data, n, stride, cmap->table, vmin, vmax, out);
+    });
+}
+
+} // namespace
+
+extern "C" {
+
+int cppcolormap_api_version(void)
+{
+    return CPPCOLORMAP_C_API_VERSION;
+}
+
+const char* cppcolormap_version(void)
+{
+    static const std::string ret = cppcolormap::version();
+    return ret.c_str();
+}
+
+const char* cppcolormap_last_error(void)
+{
+    return last_error().c_str();
+}
+
+void cppcolormap_set_num_threads(size_t n)
+{
+    cppcolormap::set_num_threads(n);
+}
+
+cppcolormap_cmap* cppcolormap_create(const char* name, size_t N, int fmt)
+{
+    cppcolormap_cmap* ret = nullptr;
+
+    guard([&]() {
+        require(name != nullptr, "name is NULL");
+        require(cppcolormap::is_registered(name), "Colormap not recognized");
+        cppcolormap::ColormapEntry entry = cppcolormap::registry_entry(name);
+        cppcolormap::array_type::tensor<double, 2> colors = entry.func(N > 0 ? N : entry.N);
+        ret = create(colors, fmt);
+    });
+
+    return ret;
+}
+
+cppcolormap_cmap*
+cppcolormap_create_from_table(const double* colors, size_t rows, size_t cols, int fmt)
+{
+    cppcolormap_cmap* ret = nullptr;
+
+    guard([&]() {
+        require(colors != nullptr, "colors is NULL");
+        ret = create(cppcolormap::ColormapSpan(colors, rows, cols), fmt);
+    });
+
+    return ret;
+}
+
+void cppcolormap_destroy(cppcolormap_cmap* cmap)
+{
+    delete cmap;
+}
+
+size_t cppcolormap_size(const cppcolormap_cmap* cmap)
+{
+    return cmap ? cmap->table.size() : 0;
+}
+
+size_t cppcolormap_channels(const cppcolormap_cmap* cmap)
+{
+    return cmap ? cmap->table.channels() : 0;
+}
+
+int cppcolormap_map_f32(
+    const cppcolormap_cmap* cmap,
+    const float* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_f64(
+    const cppcolormap_cmap* cmap,
+    const double* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_i8(
+    const cppcolormap_cmap* cmap,
+    const int8_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_u8(
+    const cppcolormap_cmap* cmap,
+    const uint8_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_i16(
+    const cppcolormap_cmap* cmap,
+    const int16_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_u16(
+    const cppcolormap_cmap* cmap,
+    const uint16_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_i32(
+    const cppcolormap_cmap* cmap,
+    const int32_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_u32(
+    const cppcolormap_cmap* cmap,
+    const uint32_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_i64(
+    const cppcolormap_cmap* cmap,
+    const int64_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_map_u64(
+    const cppcolormap_cmap* cmap,
+    const uint64_t* data,
+    size_t n,
+    ptrdiff_t stride,
+    double vmin,
+    double vmax,
+    uint8_t* out
+)
+{
+    return map(cmap, data, n, stride, vmin, vmax, out);
+}
+
+int cppcolormap_match(
+    const double* colors,
+    size_t n,
+    const double* palette,
+    size_t npalette,
+    int metric,
+    size_t* out
+)
+{
+    return guard([&]() {
+        require(npalette > 0 && palette != nullptr, "Empty palette");
+        require(n == 0 || (colors != nullptr && out != nullptr), "colors or out is NULL");
+        require(
+            metric >= CPPCOLORMAP_EUCLIDEAN && metric <= CPPCOLORMAP_DELTA_E_OKLAB, "Unknown metric"
+        );
+        cppcolormap::match(
+            colors,
+            n,
+            cppcolormap::ColormapSpan(palette, npalette, 3),
+            static_cast<cppcolormap::metric>(metric),
+            out
+        );
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,65 @@
+#include <cppcolormap_c.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REQUIRE(expr) \
+    if (!(expr)) { \
+        fprintf(stderr, "%s:%d: assertion failed (%s): %s\n", __FILE__, __LINE__, #expr, \
+                cppcolormap_last_error()); \
+        return 1; \
+    }
+
+int main(void)
+{
+    REQUIRE(cppcolormap_api_version() == CPPCOLORMAP_C_API_VERSION);
+    REQUIRE(strlen(cppcolormap_version()) > 0);
+
+    /* by name */
+    cppcolormap_cmap* cmap = cppcolormap_create("Greys", 256, CPPCOLORMAP_RGBA);
+    REQUIRE(cmap != NULL);
+    REQUIRE(cppcolormap_size(cmap) == 256);
+    REQUIRE(cppcolormap_channels(cmap) == 4);
+
+    float data[4] = {-1.0f, 0.0f, 1.0f, 2.0f};
+    uint8_t out[16];
+    REQUIRE(cppcolormap_map_f32(cmap, data, 4, 1, 0.0, 1.0, out) == CPPCOLORMAP_OK);
+    REQUIRE(out[0] == out[4]);
+    REQUIRE(out[8] == out[12]);
+    REQUIRE(out[0] != out[8]);
+    REQUIRE(out[3] == 255);
+
+    /* strided */
+    uint8_t strided[8];
+    REQUIRE(cppcolormap_map_f32(cmap, data, 2, 2, 0.0, 1.0, strided) == CPPCOLORMAP_OK);
+    REQUIRE(memcmp(strided, out, 4) == 0);
+    REQUIRE(memcmp(strided + 4, out + 8, 4) == 0);
+
+    /* errors */
+    REQUIRE(cppcolormap_map_f32(cmap, data, 4, 1, 1.0, 0.0, out) != CPPCOLORMAP_OK);
+    REQUIRE(strlen(cppcolormap_last_error()) > 0);
+    REQUIRE(cppcolormap_create("not_a_colormap", 0, CPPCOLORMAP_RGB) == NULL);
+    REQUIRE(cppcolormap_create("viridis", 0, 7) == NULL);
+    cppcolormap_destroy(cmap);
+
+    /* from table */
+    double table[6] = {1.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+    cmap = cppcolormap_create_from_table(table, 2, 3, CPPCOLORMAP_BGR);
+    REQUIRE(cmap != NULL);
+    int32_t ints[2] = {0, 10};
+    REQUIRE(cppcolormap_map_i32(cmap, ints, 2, 1, 0.0, 10.0, out) == CPPCOLORMAP_OK);
+    REQUIRE(out[0] == 0 && out[1] == 0 && out[2] == 255);
+    REQUIRE(out[3] == 255 && out[4] == 0 && out[5] == 0);
+    cppcolormap_destroy(cmap);
+
+    /* match */
+    double colors[6] = {0.9, 0.1, 0.1, 0.1, 0.1, 0.8};
+    size_t idx[2];
+    REQUIRE(cppcolormap_match(colors, 2, table, 2, CPPCOLORMAP_EUCLIDEAN, idx) == CPPCOLORMAP_OK);
+    REQUIRE(idx[0] == 0 && idx[1] == 1);
+    REQUIRE(cppcolormap_match(colors, 2, table, 2, CPPCOLORMAP_DELTA_E_OKLAB, idx) == 0);
+    REQUIRE(idx[0] == 0 && idx[1] == 1);
+
+    printf("All tests passed\n");
+    return 0;
+}
@@ -1,6 +1,22 @@
 #include <catch2/catch_all.hpp>
 
 #include <cppcolormap.h>
+#include <cppcolormap/gif.h>
+#include <cppcolormap/image.h>
+#include <cppcolormap/loaders.h>
+#include <cppcolormap/npy.h>
+#include <cppcolormap/pack.h>
+#include <cppcolormap/pipeline.h>
+#include <cppcolormap/shared.h>
+#include <cppcolormap/stream.h>
+#include <cppcolormap/video.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 TEST_CASE("cppcolormap::colormap", "cppcolormap.h")
 {
@@ -198,3 +214,1339 @@ TEST_CASE("cppcolormap::as_colors", "cppcolormap.h")
     auto m = cppcolormap::as_colors(data, c);
     REQUIRE(xt::allclose(c, m));
 }
+
+TEST_CASE("cppcolormap::register_colormap", "cppcolormap.h")
+{
+    auto names = cppcolormap::registered_colormaps();
+    REQUIRE(std::is_sorted(names.begin(), names.end()));
+    REQUIRE(std::find(names.begin(), names.end(), "jet_r") != names.end());
+    REQUIRE(std::find(names.begin(), names.end(), "tue") != names.end());
+
+    REQUIRE(cppcolormap::registry_entry("Accent").N == 8);
+    REQUIRE(xt::allclose(cppcolormap::colormap("xterm"), cppcolormap::xterm()));
+    REQUIRE(xt::allclose(cppcolormap::colormap("Reds", 20), cppcolormap::Reds(20)));
+    REQUIRE_THROWS(cppcolormap::colormap("not_a_colormap"));
+
+    REQUIRE(!cppcolormap::is_registered("my_reds"));
+    cppcolormap::register_colormap("my_reds", [](size_t N) { return cppcolormap::Reds(N); }, 9);
+    REQUIRE(cppcolormap::is_registered("my_reds"));
+    REQUIRE(xt::allclose(cppcolormap::colormap("my_reds", 20), cppcolormap::Reds(20)));
+}
+
+TEST_CASE("cppcolormap::rgb2hex", "cppcolormap.h")
+{
+    xt::xtensor<double, 2> c = {{0.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, {0.0, 0.0, 0.0}};
+    xt::xtensor<double, 2> a = {{0.0, 0.0, 1.0, 0.5}, {1.0, 0.0, 0.0, 1.0}};
+
+    std::vector<std::string> hex = cppcolormap::rgb2hex(c);
+    REQUIRE(hex == std::vector<std::string>{"#0000ff", "#ffffff", "#000000"});
+
+    cppcolormap::HexArray h = cppcolormap::rgb2hex_array(c);
+    REQUIRE(h.size() == 3);
+    REQUIRE(h.width() == 7);
+    REQUIRE(h[0] == "#0000ff");
+    REQUIRE(std::string(h.data(), h.size() * h.width()) == "#0000ff#ffffff#000000");
+
+    cppcolormap::HexArray ha = cppcolormap::rgb2hex_array(a);
+    REQUIRE(ha.width() == 9);
+    REQUIRE(ha[0] == "#0000ff7f");
+    REQUIRE(ha[1] == "#ff0000ff");
+
+    auto jet = cppcolormap::jet(1000);
+    auto hjet = cppcolormap::rgb2hex_array(jet);
+    xt::xtensor<double, 1> rgb = cppcolormap::hex2rgb(std::string(hjet[500]));
+    xt::xtensor<double, 1> ref = xt::view(jet, 500, xt::all());
+    REQUIRE(xt::allclose(rgb, ref, 0.0, 1.0 / 255.0));
+}
+
+TEST_CASE("cppcolormap::hex2rgb", "cppcolormap.h")
+{
+    xt::xtensor<double, 2> c = {{0.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, {0.0, 0.0, 0.0}};
+    xt::xtensor<double, 2> a = {{0.0, 0.0, 1.0, 1.0}, {1.0, 1.0, 1.0, 0.0}, {0.0, 0.0, 0.0, 1.0}};
+
+    std::vector<std::string> hex = {"#0000ff", "#ffffff00", "000"};
+    REQUIRE(xt::allclose(cppcolormap::hex2rgb(hex), c));
+    REQUIRE(xt::allclose(cppcolormap::hex2rgba(hex), a));
+    REQUIRE(xt::allclose(cppcolormap::hex2rgb("#FFF"), xt::xtensor<double, 1>{1.0, 1.0, 1.0}));
+
+    std::vector<std::string_view> views = {"#0000ff", "#fff", "#000000"};
+    REQUIRE(xt::allclose(cppcolormap::hex2rgb(views.begin(), views.end()), c));
+
+    auto jet = cppcolormap::jet(1000);
+    auto h = cppcolormap::rgb2hex_array(jet);
+    REQUIRE(xt::allclose(cppcolormap::hex2rgb(h), jet, 0.0, 1.0 / 255.0));
+
+    std::vector<std::string> bad = {"#0000ff", "#ff", "#00000g"};
+    REQUIRE_THROWS_WITH(cppcolormap::hex2rgb(bad), "Invalid hex colour \"#ff\" at index 1");
+    REQUIRE_THROWS(cppcolormap::hex2rgb("#00000g"));
+}
+
+TEST_CASE("cppcolormap::as_indices", "cppcolormap.h")
+{
+    auto c = cppcolormap::Greys(5);
+    xt::xtensor<double, 1> data = xt::arange<double>(c.shape(0));
+    xt::xtensor<uint8_t, 1> idx = xt::arange<uint8_t>(c.shape(0));
+    REQUIRE(xt::all(xt::equal(cppcolormap::as_indices<uint8_t>(data, c.shape(0)), idx)));
+
+    xt::xtensor<int, 1> integers = xt::arange<int>(c.shape(0));
+    REQUIRE(xt::all(xt::equal(cppcolormap::as_indices<uint8_t>(integers, c.shape(0)), idx)));
+    REQUIRE(xt::allclose(cppcolormap::as_colors(integers, c), c));
+
+    size_t n = 1000000;
+    auto v = cppcolormap::viridis();
+    xt::xtensor<double, 1> x = xt::linspace<double>(-0.5, 1.5, n);
+    auto i = cppcolormap::as_indices<uint16_t>(x, v.shape(0), 0.0, 1.0);
+    auto m = cppcolormap::as_colors(x, v, 0.0, 1.0);
+    REQUIRE(i(0) == 0);
+    REQUIRE(i(n - 1) == v.shape(0) - 1);
+    REQUIRE(m.shape(0) == n);
+    REQUIRE(m.shape(1) == 3);
+
+    size_t nthreads = cppcolormap::get_num_threads();
+    cppcolormap::set_num_threads(1);
+    REQUIRE(xt::all(xt::equal(cppcolormap::as_indices<uint16_t>(x, v.shape(0), 0.0, 1.0), i)));
+    REQUIRE(xt::all(xt::equal(cppcolormap::as_colors(x, v, 0.0, 1.0), m)));
+    cppcolormap::set_num_threads(nthreads);
+
+    std::vector<uint16_t> ip(n);
+    cppcolormap::as_indices(x.data(), n, 1, v.shape(0), 0.0, 1.0, ip.data());
+    REQUIRE(std::equal(ip.begin(), ip.end(), i.begin()));
+    cppcolormap::as_indices(x.data() + 1, n / 2, 2, v.shape(0), 0.0, 1.0, ip.data());
+    for (size_t k = 0; k < n / 2; ++k) {
+        REQUIRE(ip[k] == i(2 * k + 1));
+    }
+
+    for (size_t k = 0; k < n; k += 997) {
+        for (size_t j = 0; j < 3; ++j) {
+            REQUIRE(m(k, j) == v(i(k), j));
+        }
+    }
+}
+
+TEST_CASE("cppcolormap::CompiledColormap", "cppcolormap.h")
+{
+    auto c = cppcolormap::jet();
+    xt::xtensor<double, 1> x = xt::linspace<double>(-0.5, 1.5, 1000);
+    auto ref = cppcolormap::as_colors(x, c, 0.0, 1.0);
+    auto ref8 = cppcolormap::pack_srgb8(ref);
+
+    SECTION("uint8, rgba")
+    {
+        cppcolormap::CompiledColormap<uint8_t> cmap(c, cppcolormap::rgba);
+        REQUIRE(cmap.channels() == 4);
+        std::vector<uint8_t> out(4 * x.size());
+        cppcolormap::as_colors(x.data(), x.size(), 1, cmap, 0.0, 1.0, out.data());
+        for (size_t i = 0; i < x.size(); ++i) {
+            REQUIRE(out[4 * i] == ref8(i, 0));
+            REQUIRE(out[4 * i + 1] == ref8(i, 1));
+            REQUIRE(out[4 * i + 2] == ref8(i, 2));
+            REQUIRE(out[4 * i + 3] == 255);
+        }
+    }
+
+    SECTION("float, bgr, strided")
+    {
+        std::vector<float> out(3 * x.size() / 2);
+        cppcolormap::as_colors(
+            x.data(), x.size() / 2, 2, c, 0.0, 1.0, out.data(), cppcolormap::bgr
+        );
+        for (size_t i = 0; i < x.size() / 2; ++i) {
+            REQUIRE(out[3 * i] == static_cast<float>(ref(2 * i, 2)));
+            REQUIRE(out[3 * i + 1] == static_cast<float>(ref(2 * i, 1)));
+            REQUIRE(out[3 * i + 2] == static_cast<float>(ref(2 * i, 0)));
+        }
+    }
+
+    SECTION("ColormapSpan")
+    {
+        cppcolormap::ColormapSpan span(c.data(), c.shape(0), c.shape(1));
+        std::vector<double> out(3 * x.size());
+        cppcolormap::as_colors(x.data(), x.size(), 1, span, 0.0, 1.0, out.data());
+        REQUIRE(std::equal(out.begin(), out.end(), ref.data()));
+
+        xt::xtensor<double, 1> flat = xt::zeros<double>({size_t(6)});
+        REQUIRE_THROWS_AS(cppcolormap::ColormapSpan(flat), std::invalid_argument);
+    }
+}
+
+TEST_CASE("cppcolormap::set_parallel_backend", "cppcolormap.h")
+{
+    xt::xtensor<double, 2> field = xt::empty<double>({size_t(128), size_t(200)});
+    for (size_t i = 0; i < field.size(); ++i) {
+        field.flat(i) = std::sin(0.001 * static_cast<double>(i));
+    }
+    auto v = cppcolormap::viridis();
+    auto xterm = cppcolormap::xterm();
+
+    size_t nthreads = cppcolormap::get_num_threads();
+    size_t grain = cppcolormap::get_parallel_grain();
+    auto backend = cppcolormap::get_parallel_backend();
+
+    cppcolormap::set_parallel_backend(cppcolormap::parallel_backend::serial);
+    auto ref = cppcolormap::as_colors(field, v, -1.0, 1.0);
+    auto image = cppcolormap::as_colors(field, v);
+    auto dither = cppcolormap::dither_floyd_steinberg<uint8_t>(
+        image, xterm, cppcolormap::euclidean, false
+    );
+
+    std::atomic<size_t> calls(0);
+    cppcolormap::set_parallel_callback([&](size_t n, size_t g, const auto& func) {
+        ++calls;
+        for (size_t begin = 0; begin < n; begin += g) {
+            func(begin, std::min(begin + g, n));
+        }
+    });
+    REQUIRE(cppcolormap::get_parallel_backend() == cppcolormap::parallel_backend::callback);
+
+    cppcolormap::set_num_threads(4);
+    cppcolormap::set_parallel_grain(1000);
+
+    for (auto b : {cppcolormap::parallel_backend::serial,
+                   cppcolormap::parallel_backend::thread_pool,
+                   cppcolormap::parallel_backend::openmp,
+                   cppcolormap::parallel_backend::tbb_arena,
+                   cppcolormap::parallel_backend::callback}) {
+        if (!cppcolormap::has_parallel_backend(b)) {
+            REQUIRE_THROWS(cppcolormap::set_parallel_backend(b));
+            continue;
+        }
+        cppcolormap::set_parallel_backend(b);
+        REQUIRE(xt::all(xt::equal(cppcolormap::as_colors(field, v, -1.0, 1.0), ref)));
+        REQUIRE(xt::all(xt::equal(
+            cppcolormap::dither_floyd_steinberg<uint8_t>(
+                image, xterm, cppcolormap::euclidean, false
+            ),
+            dither
+        )));
+    }
+
+    REQUIRE(calls > 0);
+
+    cppcolormap::set_parallel_callback(nullptr);
+    REQUIRE(!cppcolormap::has_parallel_backend(cppcolormap::parallel_backend::callback));
+
+    // the configuration may be changed while other threads map
+    auto pool = cppcolormap::has_parallel_backend(cppcolormap::parallel_backend::tbb_arena)
+                    ? cppcolormap::parallel_backend::tbb_arena
+                    : cppcolormap::parallel_backend::thread_pool;
+    std::atomic<bool> stop(false);
+    std::thread config([&]() {
+        for (size_t i = 0; !stop; ++i) {
+            cppcolormap::set_num_threads(1 + i % 4);
+            cppcolormap::set_parallel_grain(500 + i % 1000);
+            if (i % 3 == 0) {
+                cppcolormap::set_parallel_callback(nullptr);
+            }
+            else if (i % 3 == 1) {
+                auto b = i % 2 ? pool : cppcolormap::parallel_backend::thread_pool;
+                cppcolormap::set_parallel_backend(b);
+            }
+            else {
+                cppcolormap::set_parallel_callback([](size_t n, size_t, const auto& func) {
+                    func(0, n);
+                });
+            }
+        }
+    });
+
+    std::atomic<bool> equal(true);
+    auto map = [&]() {
+        for (size_t i = 0; i < 50; ++i) {
+            if (!xt::all(xt::equal(cppcolormap::as_colors(field, v, -1.0, 1.0), ref))) {
+                equal = false;
+            }
+        }
+    };
+    std::thread other(map);
+    map();
+    other.join();
+    stop = true;
+    config.join();
+    REQUIRE(equal);
+
+    cppcolormap::set_parallel_callback(nullptr);
+    cppcolormap::set_parallel_backend(backend);
+    cppcolormap::set_parallel_grain(grain);
+    cppcolormap::set_num_threads(nthreads);
+}
+
+TEST_CASE("cppcolormap::detail::as_colors_strided", "cppcolormap.h")
+{
+    auto c = cppcolormap::jet();
+    xt::xtensor<double, 2> data = xt::empty<double>({size_t(300), size_t(400)});
+    for (size_t i = 0; i < data.size(); ++i) {
+        data.flat(i) = std::sin(0.001 * static_cast<double>(i));
+    }
+
+    // transposed, every second column
+    xt::xtensor<double, 2> ref = xt::empty<double>({size_t(200), size_t(300)});
+    for (size_t i = 0; i < 200; ++i) {
+        for (size_t j = 0; j < 300; ++j) {
+            ref(i, j) = data(j, 2 * i);
+        }
+    }
+
+    std::vector<size_t> shape = {200, 300};
+    std::vector<ptrdiff_t> strides = {2, 400};
+    auto range = cppcolormap::detail::strided_minmax(data.data(), shape, strides);
+    REQUIRE(range[0] == xt::amin(ref)());
+    REQUIRE(range[1] == xt::amax(ref)());
+
+    cppcolormap::detail::quantiser q(range[0], range[1], c.shape(0));
+    xt::xtensor<double, 3> ret = xt::empty<double>({size_t(200), size_t(300), size_t(3)});
+    cppcolormap::detail::as_colors_strided(data.data(), shape, strides, q, c.data(), 3, ret.data());
+    REQUIRE(xt::allclose(ret, cppcolormap::as_colors(ref, c)));
+}
+
+TEST_CASE("cppcolormap::convert", "cppcolormap.h")
+{
+    std::vector<cppcolormap::colorspace> spaces{
+        cppcolormap::sRGB,
+        cppcolormap::linear_RGB,
+        cppcolormap::XYZ,
+        cppcolormap::CIELAB,
+        cppcolormap::Oklab,
+        cppcolormap::HSV,
+        cppcolormap::HSL
+    };
+
+    auto c = cppcolormap::jet(64);
+
+    for (auto from : spaces) {
+        for (auto to : spaces) {
+            auto a = cppcolormap::convert(c, cppcolormap::sRGB, from);
+            auto b = cppcolormap::convert(a, from, to);
+            auto r = cppcolormap::convert(b, to, cppcolormap::sRGB);
+            REQUIRE(xt::allclose(c, r, 1e-6, 1e-6));
+        }
+    }
+
+    xt::xtensor<double, 2> white = {{1.0, 1.0, 1.0}};
+    xt::xtensor<double, 2> lab = {{100.0, 0.0, 0.0}};
+    xt::xtensor<double, 2> ok = {{1.0, 0.0, 0.0}};
+    auto white_lab = cppcolormap::convert(white, cppcolormap::sRGB, cppcolormap::CIELAB);
+    auto white_ok = cppcolormap::convert(white, cppcolormap::sRGB, cppcolormap::Oklab);
+    REQUIRE(xt::allclose(white_lab, lab, 1e-4, 1e-4));
+    REQUIRE(xt::allclose(white_ok, ok, 1e-4, 1e-4));
+
+    auto p = cppcolormap::pack_srgb8(c);
+    auto q = cppcolormap::convert(p, cppcolormap::sRGB, cppcolormap::sRGB);
+    REQUIRE(xt::allclose(q, c, 0.0, 0.5 / 255.0));
+
+    auto q_ok = cppcolormap::convert(p, cppcolormap::sRGB, cppcolormap::Oklab);
+    REQUIRE(xt::allclose(q_ok, cppcolormap::convert(q, cppcolormap::sRGB, cppcolormap::Oklab)));
+
+    auto l = cppcolormap::convert(c, cppcolormap::sRGB, cppcolormap::linear_RGB);
+    REQUIRE(xt::all(xt::equal(cppcolormap::pack_srgb8(l, cppcolormap::linear_RGB), p)));
+}
+
+TEST_CASE("cppcolormap::match", "cppcolormap.h")
+{
+    auto c = cppcolormap::tue();
+    xt::xtensor<size_t, 1> idx = xt::arange<size_t>(c.shape(0));
+
+    REQUIRE(xt::all(xt::equal(cppcolormap::match(c, c), idx)));
+    REQUIRE(xt::all(xt::equal(cppcolormap::match(c, c, cppcolormap::delta_e_cie76), idx)));
+    REQUIRE(xt::all(xt::equal(cppcolormap::match(c, c, cppcolormap::delta_e_oklab), idx)));
+
+    // compare to brute force
+    auto xterm = cppcolormap::xterm();
+    auto jet = cppcolormap::jet(1000);
+    auto metrics = {cppcolormap::euclidean, cppcolormap::fast_perceptual, cppcolormap::perceptual};
+
+    for (auto m : metrics) {
+        auto res = cppcolormap::match(jet, xterm, m);
+
+        for (size_t i = 0; i < jet.shape(0); ++i) {
+            size_t jmin = 0;
+            double dmin = std::numeric_limits<double>::infinity();
+            for (size_t j = 0; j < xterm.shape(0); ++j) {
+                double dr = jet(i, 0) - xterm(j, 0);
+                double dg = jet(i, 1) - xterm(j, 1);
+                double db = jet(i, 2) - xterm(j, 2);
+                double rm = 0.5 * (jet(i, 0) + xterm(j, 0));
+                double d = dr * dr + dg * dg + db * db;
+                if (m == cppcolormap::fast_perceptual) {
+                    d = 0.3 * dr * dr + 0.59 * dg * dg + 0.11 * db * db;
+                }
+                else if (m == cppcolormap::perceptual) {
+                    d = 2.0 * dr * dr + 4.0 * dg * dg + 3.0 * db * db + rm * (dr * dr - db * db);
+                }
+                if (d < dmin) {
+                    dmin = d;
+                    jmin = j;
+                }
+            }
+            REQUIRE(res(i) == jmin);
+        }
+    }
+}
+
+TEST_CASE("cppcolormap::dither", "cppcolormap.h")
+{
+    auto palette = cppcolormap::tue();
+    size_t n = palette.shape(0);
+
+    SECTION("exact colours")
+    {
+        xt::xtensor<double, 3> image = xt::empty<double>({size_t(2), n, size_t(3)});
+        for (size_t y = 0; y < 2; ++y) {
+            for (size_t x = 0; x < n; ++x) {
+                for (size_t k = 0; k < 3; ++k) {
+                    image(y, x, k) = palette(x, k);
+                }
+            }
+        }
+
+        auto a = cppcolormap::dither_floyd_steinberg<uint8_t>(image, palette);
+        auto b = cppcolormap::dither_ordered<uint8_t>(image, palette, 0.0);
+
+        for (size_t y = 0; y < 2; ++y) {
+            for (size_t x = 0; x < n; ++x) {
+                REQUIRE(a(y, x) == x);
+                REQUIRE(b(y, x) == x);
+            }
+        }
+    }
+
+    SECTION("mean preserved")
+    {
+        xt::xtensor<double, 2> bw = {{0.0, 0.0, 0.0}, {1.0, 1.0, 1.0}};
+        xt::xtensor<double, 3> image = xt::empty<double>({size_t(64), size_t(64), size_t(3)});
+        std::fill(image.begin(), image.end(), 0.25);
+
+        auto a = cppcolormap::dither_floyd_steinberg(image, bw);
+        auto b = cppcolormap::dither_ordered(image, bw, 1.0);
+        double ma = static_cast<double>(std::accumulate(a.begin(), a.end(), size_t(0)));
+        double mb = static_cast<double>(std::accumulate(b.begin(), b.end(), size_t(0)));
+        REQUIRE(std::abs(ma / static_cast<double>(a.size()) - 0.25) < 0.01);
+        REQUIRE(std::abs(mb / static_cast<double>(b.size()) - 0.25) < 0.01);
+    }
+
+    SECTION("pipelined equals serial")
+    {
+        xt::xtensor<double, 2> field = xt::empty<double>({size_t(256), size_t(256)});
+        for (size_t i = 0; i < field.size(); ++i) {
+            field.flat(i) = std::sin(0.001 * static_cast<double>(i));
+        }
+        auto image = cppcolormap::as_colors(field, cppcolormap::viridis());
+        auto xterm = cppcolormap::xterm();
+
+        size_t nthreads = cppcolormap::get_num_threads();
+        cppcolormap::set_num_threads(4);
+        auto a = cppcolormap::dither_floyd_steinberg<uint8_t>(
+            image, xterm, cppcolormap::euclidean, false
+        );
+        auto b = cppcolormap::dither_ordered<uint8_t>(image, xterm);
+
+        cppcolormap::set_num_threads(1);
+        auto c = cppcolormap::dither_floyd_steinberg<uint8_t>(
+            image, xterm, cppcolormap::euclidean, false
+        );
+        auto d = cppcolormap::dither_ordered<uint8_t>(image, xterm);
+        cppcolormap::set_num_threads(nthreads);
+
+        REQUIRE(xt::all(xt::equal(a, c)));
+        REQUIRE(xt::all(xt::equal(b, d)));
+    }
+}
+
+TEST_CASE("cppcolormap::AnsiRenderer", "cppcolormap.h")
+{
+    xt::xtensor<double, 2> c = {{1.0, 0.0, 0.0}, {0.0, 0.0, 1.0}};
+    std::string half = "\xe2\x96\x80";
+    std::string reset = "\x1b[0m\n";
+
+    SECTION("truecolor")
+    {
+        xt::xtensor<double, 2> data = {{0.0, 0.0, 1.0}, {0.0, 1.0, 1.0}};
+        cppcolormap::AnsiRenderer renderer(c);
+        std::string out = renderer.render(data, 3, 1, 0.0, 1.0);
+        std::string red = "255;0;0m";
+        std::string blue = "0;0;255m";
+        REQUIRE(
+            out == "\x1b[48;2;" + red + " " + "\x1b[48;2;" + blue + "\x1b[38;2;" + red + half +
+                       " " + reset
+        );
+        REQUIRE(renderer.str() == out);
+    }
+
+    SECTION("run-length")
+    {
+        xt::xtensor<double, 2> data = xt::zeros<double>({size_t(10), size_t(200)});
+        std::string out = cppcolormap::as_ansi(data, c, 200, 5, cppcolormap::xterm256);
+        std::string line = "\x1b[48;5;196m" + std::string(200, ' ') + reset;
+        REQUIRE(out == line + line + line + line + line);
+    }
+}
+
+TEST_CASE("cppcolormap::SharedColormap", "cppcolormap/shared.h")
+{
+    auto c = cppcolormap::viridis(1000);
+
+    SECTION("shared memory")
+    {
+        std::string name = "cppcolormap-test-" + std::to_string(std::rand());
+        cppcolormap::SharedColormap::unlink(name);
+
+        auto a = cppcolormap::SharedColormap::publish(name, c);
+        REQUIRE_THROWS(cppcolormap::SharedColormap::publish(name, c));
+
+        auto b = cppcolormap::SharedColormap::attach(name);
+        REQUIRE(b.rows() == 1000);
+        REQUIRE(b.cols() == 3);
+        REQUIRE(xt::all(xt::equal(b.colors(), c)));
+        REQUIRE(xt::allclose(cppcolormap::as_colors(c, b.colors()), cppcolormap::as_colors(c, c)));
+
+        cppcolormap::SharedColormap::unlink(name);
+    }
+
+    SECTION("file")
+    {
+        std::string path = "cppcolormap-test.cmap";
+        cppcolormap::SharedColormap::publish_file(path, c);
+        auto b = cppcolormap::SharedColormap::attach_file(path);
+        REQUIRE(xt::all(xt::equal(b.colors(), c)));
+
+        // "rows * cols" that overflows
+        uint64_t rows = uint64_t(1) << 62;
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        file.close();
+        REQUIRE_THROWS(cppcolormap::SharedColormap::attach_file(path));
+        std::remove(path.c_str());
+    }
+
+    REQUIRE_THROWS(cppcolormap::SharedColormap::attach("cppcolormap-test-does-not-exist"));
+}
+
+TEST_CASE("cppcolormap::StreamMapper", "cppcolormap/stream.h")
+{
+    auto c = cppcolormap::viridis(256);
+    cppcolormap::CompiledColormap<uint8_t> cmap(c, cppcolormap::rgba);
+    std::vector<float> x(12345);
+
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] = static_cast<float>(i % 1000) / 900.0f;
+    }
+
+    std::vector<uint8_t> ref(4 * x.size());
+    cppcolormap::as_colors(x.data(), x.size(), 1, cmap, 0.0, 1.0, ref.data());
+
+    cppcolormap::StreamMapper<float> mapper(cmap, 0.0, 1.0, 1000);
+    std::vector<uint8_t> out;
+    auto sink = [&](const uint8_t* pixels, size_t n) {
+        out.insert(out.end(), pixels, pixels + n * mapper.channels());
+    };
+
+    SECTION("source")
+    {
+        size_t offset = 0;
+        auto source = [&](float* buffer, size_t capacity) {
+            size_t n = std::min(capacity, x.size() - offset);
+            std::copy(x.begin() + offset, x.begin() + offset + n, buffer);
+            offset += n;
+            return n;
+        };
+
+        REQUIRE(mapper.run(source, sink) == x.size());
+        REQUIRE(out == ref);
+    }
+
+    SECTION("spans")
+    {
+        std::vector<std::vector<float>> spans = {
+            std::vector<float>(x.begin(), x.begin() + 2500),
+            std::vector<float>(),
+            std::vector<float>(x.begin() + 2500, x.end()),
+        };
+
+        REQUIRE(mapper.run(spans.begin(), spans.end(), sink) == x.size());
+        REQUIRE(out == ref);
+    }
+
+    SECTION("exceptions")
+    {
+        auto endless = [](float* buffer, size_t capacity) {
+            std::fill(buffer, buffer + capacity, 0.5f);
+            return capacity;
+        };
+        auto failing_source = [](float*, size_t) -> size_t {
+            throw std::runtime_error("source");
+        };
+        auto failing_sink = [](const uint8_t*, size_t) { throw std::runtime_error("sink"); };
+
+        REQUIRE_THROWS_WITH(mapper.run(failing_source, sink), "source");
+        REQUIRE_THROWS_WITH(mapper.run(endless, failing_sink), "sink");
+    }
+}
+
+TEST_CASE("cppcolormap::npy_as_colors", "cppcolormap/npy.h")
+{
+    std::string input = "cppcolormap-test-input.npy";
+    std::string output = "cppcolormap-test-output.npy";
+    xt::xtensor<int16_t, 2> x = xt::empty<int16_t>({20, 15});
+    std::iota(x.begin(), x.end(), int16_t(-100));
+
+    {
+        std::string header = cppcolormap::npy_header("<i2", {20, 15});
+        REQUIRE(header.size() % 64 == 0);
+        FILE* f = std::fopen(input.c_str(), "wb");
+        std::fwrite(header.data(), 1, header.size(), f);
+        std::fwrite(x.data(), sizeof(int16_t), x.size(), f);
+        std::fclose(f);
+    }
+
+    auto in = cppcolormap::NpyFile::open(input);
+    REQUIRE(in.header().descr == "<i2");
+    REQUIRE(in.header().shape == std::vector<size_t>{20, 15});
+    REQUIRE_THROWS(in.data<double>());
+    REQUIRE(std::equal(x.begin(), x.end(), in.data<int16_t>()));
+    REQUIRE(cppcolormap::limits(in) == std::make_pair(-100.0, 199.0));
+
+    cppcolormap::CompiledColormap<uint8_t> cmap(cppcolormap::viridis(), cppcolormap::rgba);
+    auto lim = cppcolormap::npy_as_colors(input, output, cmap);
+    REQUIRE(lim == std::make_pair(-100.0, 199.0));
+
+    std::vector<uint8_t> ref(4 * x.size());
+    cppcolormap::as_colors(x.data(), x.size(), 1, cmap, -100.0, 199.0, ref.data());
+
+    {
+        auto out = cppcolormap::NpyFile::open(output);
+        REQUIRE(out.header().descr == "|u1");
+        REQUIRE(out.header().shape == std::vector<size_t>{20, 15, 4});
+        REQUIRE(out.header().offset % 64 == 0);
+        REQUIRE(std::equal(ref.begin(), ref.end(), out.data<uint8_t>()));
+    }
+
+    REQUIRE_THROWS(cppcolormap::NpyFile::open("cppcolormap-test-does-not-exist.npy"));
+    REQUIRE_THROWS_AS(
+        cppcolormap::npy_as_colors(input, output, cmap, 1.0, 1.0), std::invalid_argument
+    );
+    REQUIRE_THROWS_AS(
+        cppcolormap::npy_as_colors(input, "./" + input, cmap, -1.0, 1.0), std::invalid_argument
+    );
+    REQUIRE(cppcolormap::NpyFile::open(input).header().descr == "<i2");
+
+    using cppcolormap::read_npy_header;
+    std::string object = cppcolormap::npy_header("|O", {3});
+    std::string huge = cppcolormap::npy_header("<f8", {size_t(1) << 62, 8});
+    std::string empty = cppcolormap::npy_header("<f8", {0, 5});
+    REQUIRE_THROWS_AS(read_npy_header(object.data(), object.size()), std::runtime_error);
+    REQUIRE_THROWS_AS(read_npy_header(huge.data(), huge.size()), std::runtime_error);
+    REQUIRE(read_npy_header(empty.data(), empty.size()).size() == 0);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+std::vector<uint8_t> read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+uint32_t read_be32(const uint8_t* p)
+{
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+std::vector<uint8_t> decode_qoi(const std::vector<uint8_t>& file, size_t channels)
+{
+    size_t n = read_be32(&file[4]) * read_be32(&file[8]);
+    std::vector<uint8_t> ret;
+    std::array<std::array<uint8_t, 4>, 64> index = {};
+    std::array<uint8_t, 4> px = {0, 0, 0, 255};
+    size_t p = 14;
+
+    while (ret.size() < n * channels) {
+        uint8_t b = file[p++];
+        size_t run = 1;
+        if (b == 0xFE) {
+            px = {file[p], file[p + 1], file[p + 2], px[3]};
+            p += 3;
+        }
+        else if (b == 0xFF) {
+            px = {file[p], file[p + 1], file[p + 2], file[p + 3]};
+            p += 4;
+        }
+        else if ((b & 0xC0) == 0x00) {
+            px = index[b];
+        }
+        else if ((b & 0xC0) == 0x40) {
+            px[0] += ((b >> 4) & 3) - 2;
+            px[1] += ((b >> 2) & 3) - 2;
+            px[2] += (b & 3) - 2;
+        }
+        else if ((b & 0xC0) == 0x80) {
+            int vg = (b & 0x3F) - 32;
+            uint8_t b2 = file[p++];
+            px[0] += vg - 8 + ((b2 >> 4) & 0xF);
+            px[1] += vg;
+            px[2] += vg - 8 + (b2 & 0xF);
+        }
+        else {
+            run = (b & 0x3F) + 1;
+        }
+        index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64] = px;
+        for (size_t i = 0; i < run; ++i) {
+            ret.insert(ret.end(), px.begin(), px.begin() + channels);
+        }
+    }
+
+    REQUIRE(ret.size() == n * channels);
+    REQUIRE(std::vector<uint8_t>(file.begin() + p, file.end()) ==
+            std::vector<uint8_t>{0, 0, 0, 0, 0, 0, 0, 1});
+    return ret;
+}
+
+std::vector<uint8_t> decode_png(const std::vector<uint8_t>& file, std::vector<std::string>& chunks)
+{
+    std::vector<uint8_t> z;
+    size_t p = 8;
+
+    while (p < file.size()) {
+        size_t len = read_be32(&file[p]);
+        chunks.emplace_back(file.begin() + p + 4, file.begin() + p + 8);
+        uint32_t crc = cppcolormap::detail::crc32(0, &file[p + 4], len + 4);
+        REQUIRE(crc == read_be32(&file[p + 8 + len]));
+        if (chunks.back() == "IDAT") {
+            z.insert(z.end(), file.begin() + p + 8, file.begin() + p + 8 + len);
+        }
+        p += 12 + len;
+    }
+
+    std::vector<uint8_t> ret;
+    size_t q = 2;
+    REQUIRE((z[0] * 256 + z[1]) % 31 == 0);
+
+    for (bool last = false; !last;) {
+        last = z[q] & 1;
+        size_t len = z[q + 1] | z[q + 2] << 8;
+        REQUIRE((len ^ (z[q + 3] | z[q + 4] << 8)) == 0xFFFF);
+        ret.insert(ret.end(), z.begin() + q + 5, z.begin() + q + 5 + len);
+        q += 5 + len;
+    }
+
+    REQUIRE(read_be32(&z[q]) == cppcolormap::detail::adler32(1, ret.data(), ret.size()));
+    REQUIRE(q + 4 == z.size());
+    return ret;
+}
+
+TEST_CASE("cppcolormap::ImageWriter", "cppcolormap/image.h")
+{
+    size_t h = 100;
+    size_t w = 300;
+    xt::xtensor<double, 2> x = xt::empty<double>({h, w});
+
+    for (size_t i = 0; i < h; ++i) {
+        for (size_t j = 0; j < w; ++j) {
+            x(i, j) = i < 40 ? 0.5 : std::sin(0.1 * i) * std::cos(0.05 * j);
+        }
+    }
+
+    auto reference = [&](size_t nc, cppcolormap::CompiledColormap<uint8_t>& cmap) {
+        cmap = cppcolormap::CompiledColormap<uint8_t>(
+            cppcolormap::viridis(), nc == 3 ? cppcolormap::rgb : cppcolormap::rgba
+        );
+        std::vector<uint8_t> ret(h * w * nc);
+        cppcolormap::as_colors(x.data(), x.size(), 1, cmap, -1.0, 1.0, ret.data());
+        return ret;
+    };
+
+    SECTION("ppm")
+    {
+        for (size_t nc : {3, 4}) {
+            cppcolormap::CompiledColormap<uint8_t> cmap;
+            auto ref = reference(nc, cmap);
+            cppcolormap::write_image("test.ppm", x, cmap, -1.0, 1.0);
+            auto file = read_file("test.ppm");
+            std::string head = "P6\n300 100\n255\n";
+            REQUIRE(std::string(file.begin(), file.begin() + head.size()) == head);
+            for (size_t i = 0; i < h * w; ++i) {
+                for (size_t c = 0; c < 3; ++c) {
+                    REQUIRE(file[head.size() + i * 3 + c] == ref[i * nc + c]);
+                }
+            }
+            std::remove("test.ppm");
+        }
+    }
+
+    SECTION("bmp")
+    {
+        for (size_t nc : {3, 4}) {
+            cppcolormap::CompiledColormap<uint8_t> cmap;
+            auto ref = reference(nc, cmap);
+            cppcolormap::write_image("test.bmp", x, cmap, -1.0, 1.0);
+            auto file = read_file("test.bmp");
+            REQUIRE(file.size() == 54 + h * w * nc);
+            for (size_t i = 0; i < h * w; ++i) {
+                REQUIRE(file[54 + i * nc] == ref[i * nc + 2]);
+                REQUIRE(file[54 + i * nc + 1] == ref[i * nc + 1]);
+                REQUIRE(file[54 + i * nc + 2] == ref[i * nc]);
+            }
+            std::remove("test.bmp");
+        }
+    }
+
+    SECTION("qoi")
+    {
+        for (size_t nc : {3, 4}) {
+            cppcolormap::CompiledColormap<uint8_t> cmap;
+            auto ref = reference(nc, cmap);
+            cppcolormap::write_image("test.qoi", x, cmap, -1.0, 1.0);
+            auto file = read_file("test.qoi");
+            REQUIRE(file.size() < ref.size() / 2);
+            REQUIRE(decode_qoi(file, nc) == ref);
+            std::remove("test.qoi");
+        }
+    }
+
+    SECTION("png")
+    {
+        for (size_t nc : {3, 4}) {
+            cppcolormap::CompiledColormap<uint8_t> cmap;
+            auto ref = reference(nc, cmap);
+            cppcolormap::write_image("test.png", x, cmap, -1.0, 1.0);
+            std::vector<std::string> chunks;
+            auto data = decode_png(read_file("test.png"), chunks);
+            REQUIRE(chunks.front() == "IHDR");
+            REQUIRE(chunks.back() == "IEND");
+            REQUIRE(data.size() == h * (w * nc + 1));
+            for (size_t i = 0; i < h; ++i) {
+                REQUIRE(data[i * (w * nc + 1)] == 0);
+                auto row = data.begin() + i * (w * nc + 1) + 1;
+                REQUIRE(std::equal(row, row + w * nc, ref.begin() + i * w * nc));
+            }
+            std::remove("test.png");
+        }
+    }
+
+    SECTION("indexed png")
+    {
+        auto c = cppcolormap::viridis(16);
+        auto idx = cppcolormap::as_indices<uint8_t>(x, 16, -1.0, 1.0);
+        cppcolormap::write_indexed_image("test.png", x, c, -1.0, 1.0);
+        std::vector<std::string> chunks;
+        auto data = decode_png(read_file("test.png"), chunks);
+        REQUIRE(chunks == std::vector<std::string>{"IHDR", "PLTE", "IDAT", "IEND"});
+        for (size_t i = 0; i < h; ++i) {
+            auto row = data.begin() + i * (w + 1) + 1;
+            REQUIRE(std::equal(row, row + w, &idx(i, 0)));
+        }
+        std::remove("test.png");
+    }
+
+    SECTION("errors")
+    {
+        REQUIRE_THROWS(cppcolormap::ImageWriter("test.jpg", w, h));
+        REQUIRE_THROWS(cppcolormap::ImageWriter("test.qoi", w, h, cppcolormap::viridis(16)));
+        REQUIRE_THROWS_AS(
+            cppcolormap::ImageWriter("test.png", w, h, cppcolormap::viridis(300)),
+            std::invalid_argument
+        );
+        cppcolormap::ImageWriter image("test.qoi", 2, 2);
+        uint8_t row[6] = {0, 0, 0, 0, 0, 0};
+        image.write_row(row);
+        REQUIRE_THROWS(image.close());
+        std::remove("test.qoi");
+
+        cppcolormap::CompiledColormap<uint8_t> cmap(cppcolormap::viridis());
+        auto c = cppcolormap::viridis(16);
+        REQUIRE_THROWS_AS(
+            cppcolormap::write_image("test.png", x, cmap, 1.0, 1.0), std::invalid_argument
+        );
+        REQUIRE_THROWS_AS(
+            cppcolormap::write_indexed_image("test.png", x, c, 1.0, 1.0), std::invalid_argument
+        );
+    }
+}
+
+TEST_CASE("cppcolormap::FramePipeline", "cppcolormap/pipeline.h")
+{
+    size_t h = 40;
+    size_t w = 60;
+    size_t nframes = 12;
+    std::vector<std::string> ext = {".png", ".qoi", ".bmp"};
+    cppcolormap::CompiledColormap<uint8_t> cmap(cppcolormap::viridis());
+    std::vector<xt::xtensor<double, 2>> frames;
+
+    for (size_t f = 0; f < nframes; ++f) {
+        xt::xtensor<double, 2> x = xt::empty<double>({h, w});
+        for (size_t i = 0; i < h; ++i) {
+            for (size_t j = 0; j < w; ++j) {
+                x(i, j) = std::sin(0.1 * (i + f)) * std::cos(0.05 * j);
+            }
+        }
+        frames.push_back(x);
+    }
+
+    SECTION("frames")
+    {
+        cppcolormap::FramePipeline<double> pipeline(cmap, -1.0, 1.0, w, h, 2, 2);
+
+        for (size_t f = 0; f < nframes; ++f) {
+            std::string path = "test-frame-" + std::to_string(f) + ext[f % 3];
+            if (f % 2 == 0) {
+                pipeline.submit(frames[f].data(), path);
+            }
+            else {
+                pipeline.submit(std::vector<double>(frames[f].begin(), frames[f].end()), path);
+            }
+        }
+
+        pipeline.finish();
+        auto stats = pipeline.stats();
+        REQUIRE(stats.submit.frames == nframes);
+        REQUIRE(stats.map.frames == nframes);
+        REQUIRE(stats.encode.frames == nframes);
+        REQUIRE(stats.write.frames == nframes);
+
+        for (size_t f = 0; f < nframes; ++f) {
+            std::string path = "test-frame-" + std::to_string(f) + ext[f % 3];
+            cppcolormap::write_image("test-ref" + ext[f % 3], frames[f], cmap, -1.0, 1.0);
+            REQUIRE(read_file(path) == read_file("test-ref" + ext[f % 3]));
+            std::remove(path.c_str());
+            std::remove(("test-ref" + ext[f % 3]).c_str());
+        }
+    }
+
+    SECTION("errors")
+    {
+        cppcolormap::FramePipeline<double> pipeline(cmap, -1.0, 1.0, w, h, 1, 1);
+        REQUIRE_THROWS(pipeline.submit(frames[0].data(), "test-frame.jpg"));
+        pipeline.submit(frames[0].data(), "does-not-exist/test-frame.png");
+        REQUIRE_THROWS_WITH(pipeline.finish(), "Writing \"does-not-exist/test-frame.png\" failed");
+        REQUIRE_THROWS(pipeline.submit(frames[0].data(), "test-frame.png"));
+    }
+}
+
+TEST_CASE("cppcolormap::VideoWriter", "cppcolormap/video.h")
+{
+    size_t h = 7;
+    size_t w = 9;
+    size_t nframes = 3;
+    auto c = cppcolormap::viridis();
+    cppcolormap::CompiledColormap<uint8_t> cmap(c);
+    std::vector<std::vector<double>> frames(nframes, std::vector<double>(h * w));
+
+    for (size_t f = 0; f < nframes; ++f) {
+        for (size_t i = 0; i < h * w; ++i) {
+            frames[f][i] = std::sin(0.1 * i + f);
+        }
+    }
+
+    auto record = [&](cppcolormap::video_format format) {
+        {
+            cppcolormap::VideoWriter video("test.y4m", w, h, c, -1.0, 1.0, format, 30);
+            for (auto& frame : frames) {
+                video.write_frame(frame.data());
+            }
+            REQUIRE(video.frames() == nframes);
+        }
+        auto ret = read_file("test.y4m");
+        std::remove("test.y4m");
+        return ret;
+    };
+
+    SECTION("rgb24")
+    {
+        auto file = record(cppcolormap::rgb24);
+        REQUIRE(file.size() == nframes * h * w * 3);
+        std::vector<uint8_t> ref(h * w * 3);
+        for (size_t f = 0; f < nframes; ++f) {
+            cppcolormap::as_colors(frames[f].data(), h * w, 1, cmap, -1.0, 1.0, ref.data());
+            REQUIRE(std::equal(ref.begin(), ref.end(), file.begin() + f * ref.size()));
+        }
+    }
+
+    SECTION("y4m")
+    {
+        std::string header = "YUV4MPEG2 W9 H7 F30:1 Ip A1:1 C444\n";
+        auto full = record(cppcolormap::y4m_444);
+        REQUIRE(std::string(full.begin(), full.begin() + header.size()) == header);
+        REQUIRE(full.size() == header.size() + nframes * (6 + 3 * h * w));
+
+        std::vector<uint8_t> rgb(h * w * 3);
+        auto frame = full.begin() + header.size() + 6;
+        cppcolormap::as_colors(frames[0].data(), h * w, 1, cmap, -1.0, 1.0, rgb.data());
+
+        for (size_t i = 0; i < h * w; ++i) {
+            double r = rgb[3 * i] / 255.0;
+            double g = rgb[3 * i + 1] / 255.0;
+            double b = rgb[3 * i + 2] / 255.0;
+            double y = 16.0 + 65.481 * r + 128.553 * g + 24.966 * b;
+            double v = 128.0 + 112.0 * r - 93.786 * g - 18.214 * b;
+            REQUIRE(std::abs(y - frame[i]) <= 0.5);
+            REQUIRE(std::abs(v - frame[2 * h * w + i]) <= 0.5);
+        }
+
+        std::string header420 = "YUV4MPEG2 W9 H7 F30:1 Ip A1:1 C420jpeg\n";
+        auto sub = record(cppcolormap::y4m_420);
+        size_t cw = 5;
+        size_t ch = 4;
+        size_t size = h * w + 2 * cw * ch;
+        REQUIRE(sub.size() == header420.size() + nframes * (6 + size));
+
+        for (size_t f = 0; f < nframes; ++f) {
+            auto Y = full.begin() + header.size() + f * (6 + 3 * h * w) + 6;
+            auto U = Y + h * w;
+            auto Ys = sub.begin() + header420.size() + f * (6 + size) + 6;
+            auto Us = Ys + h * w;
+            REQUIRE(std::equal(Y, Y + h * w, Ys));
+            for (size_t cy = 0; cy < ch; ++cy) {
+                for (size_t cx = 0; cx < cw; ++cx) {
+                    size_t s = 0;
+                    size_t m = 0;
+                    for (size_t y = 2 * cy; y < std::min(2 * cy + 2, h); ++y) {
+                        for (size_t x = 2 * cx; x < std::min(2 * cx + 2, w); ++x) {
+                            s += U[y * w + x];
+                            m++;
+                        }
+                    }
+                    REQUIRE(Us[cy * cw + cx] == (s + m / 2) / m);
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> decode_gif_lzw(const std::vector<uint8_t>& z, size_t min_code_size, size_t n)
+{
+    size_t clear = size_t(1) << min_code_size;
+    std::vector<std::vector<uint8_t>> dict;
+    std::vector<uint8_t> ret;
+    size_t width = 0;
+    size_t bit = 0;
+    bool first = true;
+
+    auto reset = [&]() {
+        dict.resize(clear + 2);
+        for (size_t i = 0; i < clear; ++i) {
+            dict[i] = {static_cast<uint8_t>(i)};
+        }
+        width = min_code_size + 1;
+        first = true;
+    };
+
+    reset();
+    size_t prev = 0;
+
+    while (true) {
+        REQUIRE(bit + width <= 8 * z.size());
+        size_t code = 0;
+        for (size_t i = 0; i < width; ++i, ++bit) {
+            code |= size_t((z[bit / 8] >> (bit % 8)) & 1) << i;
+        }
+        if (code == clear) {
+            reset();
+            continue;
+        }
+        if (code == clear + 1) {
+            break;
+        }
+        if (first) {
+            REQUIRE(code < clear);
+            first = false;
+        }
+        else {
+            REQUIRE(code <= dict.size());
+            std::vector<uint8_t> entry = dict[prev];
+            entry.push_back(code < dict.size() ? dict[code][0] : dict[prev][0]);
+            REQUIRE(dict.size() < 4096);
+            dict.push_back(entry);
+            if (dict.size() == (size_t(1) << width) && width < 12) {
+                width++;
+            }
+        }
+        ret.insert(ret.end(), dict[code].begin(), dict[code].end());
+        prev = code;
+    }
+
+    REQUIRE(ret.size() == n);
+    REQUIRE((bit + 7) / 8 == z.size());
+    return ret;
+}
+
+std::vector<std::vector<uint8_t>>
+decode_gif(const std::vector<uint8_t>& file, std::vector<uint8_t>& palette)
+{
+    REQUIRE(std::string(file.begin(), file.begin() + 6) == "GIF89a");
+    size_t w = file[6] | file[7] << 8;
+    size_t h = file[8] | file[9] << 8;
+    size_t p = 13 + 3 * (size_t(2) << (file[10] & 7));
+    palette.assign(file.begin() + 13, file.begin() + p);
+    std::vector<std::vector<uint8_t>> ret;
+
+    while (file[p] != 0x3B) {
+        if (file[p] == 0x21) {
+            p += 2;
+            while (file[p] != 0) {
+                p += file[p] + 1;
+            }
+            p++;
+            continue;
+        }
+        REQUIRE(file[p] == 0x2C);
+        REQUIRE(size_t(file[p + 5] | file[p + 6] << 8) == w);
+        REQUIRE(size_t(file[p + 7] | file[p + 8] << 8) == h);
+        size_t min_code_size = file[p + 10];
+        std::vector<uint8_t> z;
+        p += 11;
+        while (file[p] != 0) {
+            z.insert(z.end(), file.begin() + p + 1, file.begin() + p + 1 + file[p]);
+            p += file[p] + 1;
+        }
+        p++;
+        ret.push_back(decode_gif_lzw(z, min_code_size, w * h));
+    }
+
+    REQUIRE(p + 1 == file.size());
+    return ret;
+}
+
+TEST_CASE("cppcolormap::GifWriter", "cppcolormap/gif.h")
+{
+    size_t h = 150;
+    size_t w = 201;
+    size_t nframes = 3;
+    xt::xtensor<double, 3> x = xt::empty<double>({nframes, h, w});
+
+    for (size_t f = 0; f < nframes; ++f) {
+        for (size_t i = 0; i < h; ++i) {
+            for (size_t j = 0; j < w; ++j) {
+                x(f, i, j) = std::sin(0.05 * i * j + f) + std::cos(0.3 * j - 0.2 * f);
+            }
+        }
+    }
+
+    for (size_t N : {2, 5, 16, 256}) {
+        auto c = cppcolormap::viridis(N);
+        cppcolormap::write_gif("test.gif", x, c, -2.0, 2.0, 5);
+        std::vector<uint8_t> palette;
+        auto frames = decode_gif(read_file("test.gif"), palette);
+        REQUIRE(frames.size() == nframes);
+        REQUIRE(palette.size() >= 3 * N);
+
+        for (size_t i = 0; i < 3 * N; ++i) {
+            REQUIRE(palette[i] == cppcolormap::detail::srgb_to_srgb8(c.data()[i]));
+        }
+
+        std::vector<uint8_t> ref(h * w);
+
+        for (size_t f = 0; f < nframes; ++f) {
+            cppcolormap::as_indices(&x(f, 0, 0), h * w, 1, N, -2.0, 2.0, ref.data());
+            REQUIRE(frames[f] == ref);
+        }
+    }
+
+    std::remove("test.gif");
+
+    SECTION("constant")
+    {
+        std::vector<uint8_t> zeros(h * w, 0);
+        std::ostringstream out;
+        {
+            cppcolormap::GifWriter gif(out, w, h, cppcolormap::viridis(4));
+            gif.write_frame(zeros.data());
+            gif.write_frame(zeros.data());
+            REQUIRE(gif.frames() == 2);
+        }
+        std::string str = out.str();
+        std::vector<uint8_t> palette;
+        auto frames = decode_gif(std::vector<uint8_t>(str.begin(), str.end()), palette);
+        REQUIRE(frames.size() == 2);
+        REQUIRE(frames[0] == zeros);
+        REQUIRE(str.size() < 1000);
+    }
+
+    SECTION("errors")
+    {
+        std::vector<uint8_t> indices(h * w, 0);
+        indices.back() = 5;
+        std::ostringstream out;
+        cppcolormap::GifWriter gif(out, w, h, cppcolormap::viridis(5));
+        REQUIRE_THROWS_AS(gif.write_frame(indices.data()), std::invalid_argument);
+        REQUIRE(gif.frames() == 0);
+        REQUIRE_THROWS_AS(
+            cppcolormap::GifWriter(out, w, h, cppcolormap::viridis(257)), std::invalid_argument
+        );
+    }
+}
+
+TEST_CASE("cppcolormap::ColormapPack", "cppcolormap/pack.h")
+{
+    std::string path = "test.cmpack";
+    cppcolormap::write_colormap_pack(path);
+    auto names = cppcolormap::registered_colormaps();
+    auto pack = cppcolormap::ColormapPack::open(path);
+
+    REQUIRE(pack.size() == names.size());
+    REQUIRE(pack.names() == names);
+
+    for (size_t i = 0; i < pack.size(); ++i) {
+        auto& entry = pack[i];
+        auto ref = cppcolormap::colormap(names[i], cppcolormap::registry_entry(names[i]).N);
+        REQUIRE(pack.find(names[i]) == i);
+        REQUIRE(entry.rows == ref.shape(0));
+        REQUIRE(entry.cols == ref.shape(1));
+        REQUIRE(reinterpret_cast<uintptr_t>(entry.colors) % 64 == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(entry.colors8) % 64 == 0);
+        for (size_t j = 0; j < ref.size(); ++j) {
+            REQUIRE(std::abs(entry.colors[j] - ref.flat(j)) < 1e-6);
+            REQUIRE(entry.colors8[j] == cppcolormap::detail::srgb_to_srgb8(ref.flat(j)));
+        }
+    }
+
+    REQUIRE(pack.at("xterm").fixed);
+    REQUIRE(!pack.at("viridis").fixed);
+    REQUIRE(pack.find("not-a-colormap") == pack.size());
+
+    SECTION("load")
+    {
+        auto reds = [](size_t N) { return cppcolormap::Reds(N); };
+        cppcolormap::register_colormap("pack_reds", reds, 9);
+        cppcolormap::write_colormap_pack(path, {"pack_reds", "tue"});
+        cppcolormap::register_colormap("pack_reds", [](size_t N) { return cppcolormap::Blues(N); });
+
+        auto loaded = cppcolormap::load_colormap_pack(path);
+        REQUIRE(loaded == std::vector<std::string>{"pack_reds", "tue"});
+        REQUIRE(cppcolormap::registry_entry("pack_reds").N == 9);
+        REQUIRE(xt::allclose(cppcolormap::colormap("pack_reds", 9), cppcolormap::Reds(9)));
+        REQUIRE(xt::allclose(cppcolormap::colormap("pack_reds", 20), cppcolormap::Reds(20)));
+        REQUIRE(xt::allclose(cppcolormap::colormap("tue", 3), cppcolormap::tue()));
+    }
+
+    SECTION("invalid")
+    {
+        std::vector<uint8_t> data = read_file(path);
+
+        // offset of the colours of the first entry, such that `offset + size` wraps
+        std::vector<uint8_t> wrap = data;
+        size_t index = cppcolormap::detail::pack_read<uint64_t>(
+            reinterpret_cast<const char*>(wrap.data()) + 16
+        );
+        std::fill(wrap.begin() + index + 16, wrap.begin() + index + 24, 0xFF);
+        wrap[index + 16] = 0xC0;
+        std::ofstream(path, std::ios::binary)
+            .write(reinterpret_cast<const char*>(wrap.data()), wrap.size());
+        REQUIRE_THROWS(cppcolormap::ColormapPack::open(path));
+
+        data.resize(data.size() - 64);
+        std::ofstream(path, std::ios::binary)
+            .write(reinterpret_cast<const char*>(data.data()), data.size());
+        REQUIRE_THROWS(cppcolormap::ColormapPack::open(path));
+        REQUIRE_THROWS(cppcolormap::ColormapPack::open("cppcolormap-test-does-not-exist.cmpack"));
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("cppcolormap::load_colormaps", "cppcolormap/loaders.h")
+{
+    using cppcolormap::parse_colormaps;
+    using T = xt::xtensor<double, 2>;
+
+    SECTION("csv")
+    {
+        auto fmt = cppcolormap::colormap_file_format::csv_table;
+        auto ret = parse_colormaps("r,g,b\n0,0,0\n# comment\n\n 0.5, 0.25 ,1\n1,1,1\n", fmt, "a");
+        REQUIRE(ret.size() == 1);
+        REQUIRE(ret[0].name == "a");
+        REQUIRE(ret[0].size() == 3);
+        REQUIRE(xt::allclose(ret[0].colors, T{{0, 0, 0}, {0.5, 0.25, 1}, {1, 1, 1}}));
+
+        auto tsv = parse_colormaps("0\t0\t255\t255\n255\t0\t0\t51\n", fmt, "b");
+        REQUIRE(xt::allclose(tsv[0].colors, T{{0, 0, 1, 1}, {1, 0, 0, 0.2}}));
+
+        auto hex = parse_colormaps("#000000\n#ff0000\n", fmt, "c");
+        REQUIRE(xt::allclose(hex[0].colors, T{{0, 0, 0}, {1, 0, 0}}));
+
+        REQUIRE_THROWS(parse_colormaps("0,0,0\n1,1\n", fmt, "d"));
+        REQUIRE_THROWS(parse_colormaps("0,0,0\nx,1,1\n", fmt, "e"));
+    }
+
+    SECTION("cpt")
+    {
+        std::string text = "# COLOR_MODEL = RGB\n"
+                           "-1 0 0 255 0 255/255/255\n"
+                           "0 #ffffff 1 255 0 0 L\n"
+                           "B 0 0 0\nF 255 255 255\nN 128 128 128\n";
+        auto fmt = cppcolormap::colormap_file_format::gmt_cpt;
+        auto ret = parse_colormaps(text, fmt, "bwr");
+        REQUIRE(ret[0].size() == 256);
+        T ref = {{0, 0, 1}, {0.5, 0.5, 1}, {1, 1, 1}, {1, 0.5, 0.5}, {1, 0, 0}};
+        REQUIRE(xt::allclose(ret[0](5), ref));
+
+        REQUIRE_THROWS(parse_colormaps("# COLOR_MODEL = HSV\n", fmt, "e"));
+    }
+
+    SECTION("xml")
+    {
+        std::string text = "<ColorMaps>\n"
+                           "<ColorMap name=\"Two\" space=\"RGB\">\n"
+                           "  <Point x=\"-2\" o=\"1\" r=\"0\" g=\"0\" b=\"0\"/>\n"
+                           "  <Point x=\"2\" o=\"1\" r=\"1\" g=\"0.5\" b=\"0\"/>\n"
+                           "  <NaN r=\"1\" g=\"1\" b=\"0\"/>\n"
+                           "</ColorMap>\n"
+                           "<ColorMap space='RGB' name='Jump'>\n"
+                           "  <Point x='0' r='0' g='0' b='0'/><Point x='0.5' r='0' g='0' b='0'/>\n"
+                           "  <Point x='0.5' r='1' g='1' b='1'/><Point x='1' r='1' g='1' b='1'/>\n"
+                           "</ColorMap>\n"
+                           "</ColorMaps>\n";
+        auto ret = parse_colormaps(text, cppcolormap::colormap_file_format::paraview_xml, "file");
+        REQUIRE(ret.size() == 2);
+        REQUIRE(ret[0].name == "Two");
+        REQUIRE(ret[1].name == "Jump");
+        REQUIRE(xt::allclose(ret[0](3), T{{0, 0, 0}, {0.5, 0.25, 0}, {1, 0.5, 0}}));
+        REQUIRE(xt::allclose(ret[1](4), T{{0, 0, 0}, {0, 0, 0}, {1, 1, 1}, {1, 1, 1}}));
+    }
+
+    SECTION("json")
+    {
+        auto fmt = cppcolormap::colormap_file_format::json;
+        std::string paraview = R"([{"ColorSpace": "Diverging", "Name": "Cool \"n\" warm",
+                                    "NanColor": [1, 1, 0], "RGBPoints": [0, 0, 0, 1, 1, 1, 0, 0]},
+                                   {"Name": "Cat", "IndexedColors": [1, 0, 0, 0, 1, 0]},
+                                   {"Name": "Opacity only", "Points": [0, 0, 0.5, 0]}])";
+        auto ret = parse_colormaps(paraview, fmt, "file");
+        REQUIRE(ret.size() == 2);
+        REQUIRE(ret[0].name == "Cool \"n\" warm");
+        REQUIRE(xt::allclose(ret[0](3), T{{0, 0, 1}, {0.5, 0, 0.5}, {1, 0, 0}}));
+        REQUIRE(ret[1].name == "Cat");
+        REQUIRE(ret[1].size() == 2);
+        REQUIRE(xt::allclose(ret[1].colors, T{{1, 0, 0}, {0, 1, 0}}));
+
+        std::string lists = R"({"version": 2, "meta": {"a": [1, 2]}, "bw": [[0, 0, 0], [1, 1, 1]],
+                                "rg": ["#ff0000", "#00ff00"], "flags": [true, null]})";
+        auto members = parse_colormaps(lists, fmt, "file");
+        REQUIRE(members.size() == 2);
+        REQUIRE(members[0].name == "bw");
+        REQUIRE(members[1].name == "rg");
+        REQUIRE(xt::allclose(members[1].colors, T{{1, 0, 0}, {0, 1, 0}}));
+
+        std::string single = R"({"name": "mpl", "colors": [[0, 0, 0, 1], [1, 1, 1, 0.5]]})";
+        auto mpl = parse_colormaps(single, fmt, "file");
+        REQUIRE(mpl[0].name == "mpl");
+        REQUIRE(mpl[0].colors.shape(1) == 4);
+
+        REQUIRE_THROWS(parse_colormaps(R"({"x": 1})", fmt, "file"));
+        REQUIRE_THROWS(parse_colormaps(R"([{"colors": [[0, 0]]}])", fmt, "file"));
+    }
+
+    SECTION("load")
+    {
+        std::string name = "cppcolormap-test-loaders";
+        std::ofstream(name + ".csv") << "0 0 0\n128 128 128\n255 255 255\n";
+        REQUIRE(cppcolormap::load_colormaps(name + ".csv") == std::vector<std::string>{name});
+        REQUIRE(cppcolormap::registry_entry(name).N == 3);
+        auto c = cppcolormap::colormap(name, 5);
+        REQUIRE(xt::allclose(c, cppcolormap::interp(cppcolormap::colormap(name, 3), 5)));
+        REQUIRE(std::abs(c(2, 0) - 128.0 / 255.0) < 1e-12);
+        std::remove((name + ".csv").c_str());
+
+        REQUIRE_THROWS(cppcolormap::load_colormaps("cppcolormap-test-does-not-exist.cpt"));
+        REQUIRE_THROWS(cppcolormap::load_colormaps("colormap.unknown"));
+    }
+}
@@ -0,0 +1,42 @@
+#include <catch2/catch_all.hpp>
+
+#define CPPCOLORMAP_ENABLE_STATS
+#include <cppcolormap.h>
+
+TEST_CASE("cppcolormap::stats", "cppcolormap.h")
+{
+    REQUIRE(cppcolormap::stats_enabled());
+    cppcolormap::reset_stats();
+
+    xt::xtensor<double, 2> colors = cppcolormap::colormap("Reds", 9);
+    xt::xtensor<double, 2> data = {{0.0, 1.0, 2.0}, {3.0, 4.0, 5.0}};
+    auto c = cppcolormap::as_colors(data, colors, 0.0, 5.0);
+    c = cppcolormap::as_colors(data, colors);
+    auto i = cppcolormap::interp(colors, 20);
+    auto idx = cppcolormap::match(colors, i);
+
+    cppcolormap::Stats s = cppcolormap::stats();
+
+    REQUIRE(s.as_colors.calls == 2);
+    REQUIRE(s.as_colors.elements == 12);
+    REQUIRE(s.as_colors.bytes == 2 * c.size() * sizeof(double));
+    REQUIRE(s.as_colors.threads == 1);
+    REQUIRE(s.as_colors.seconds >= 0.0);
+
+    REQUIRE(s.match.calls == 1);
+    REQUIRE(s.match.elements == 9);
+
+    REQUIRE(s.colormap.calls == 1);
+    REQUIRE(s.colormap.elements == 9);
+    REQUIRE(s.colormap.bytes == 9 * 3 * sizeof(double));
+
+    // "Reds" is interpolated internally
+    REQUIRE(s.interp.calls == 2);
+    REQUIRE(s.interp.elements == 9 + 20);
+
+    cppcolormap::reset_stats();
+    s = cppcolormap::stats();
+    REQUIRE(s.as_colors.calls == 0);
+    REQUIRE(s.interp.calls == 0);
+    REQUIRE(s.interp.seconds == 0.0);
+}
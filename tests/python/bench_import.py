@@ -0,0 +1,50 @@
+"""
+Import-time benchmark.
+
+Measures the wall-clock time of starting a fresh interpreter that imports ``cppcolormap``,
+relative to one that only imports NumPy (on which ``cppcolormap`` depends).
+The difference is the cost of loading the extension module, which should not depend on the
+number of colormaps (these are looked-up in the registry on first use).
+
+Usage::
+
+    python tests/python/bench_import.py [--repeat 50]
+"""
+import argparse
+import statistics
+import subprocess
+import sys
+import time
+
+
+def measure(code: str, repeat: int) -> list:
+    ret = []
+    for _ in range(repeat):
+        tic = time.perf_counter()
+        subprocess.run([sys.executable, "-c", code], check=True)
+        ret.append(time.perf_counter() - tic)
+    return ret
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--repeat", type=int, default=50, help="Number of interpreter starts")
+    args = parser.parse_args()
+
+    cases = {
+        "numpy": "import numpy",
+        "cppcolormap": "import cppcolormap",
+        "cppcolormap + lookup": "import cppcolormap; cppcolormap.viridis()",
+    }
+
+    result = {name: measure(code, args.repeat) for name, code in cases.items()}
+    base = statistics.median(result["numpy"])
+
+    for name, t in result.items():
+        med = statistics.median(t)
+        print(f"{name:>22s}: median {1e3 * med:7.2f} ms, min {1e3 * min(t):7.2f} ms, ", end="")
+        print(f"extra {1e3 * (med - base):7.2f} ms")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,152 @@
+"""
+Throughput benchmark against matplotlib and NumPy baselines.
+
+Measures the time (and throughput in elements/s) of
+``as_colors``, ``match``, ``interp``, and colormap construction,
+and compares them with ``matplotlib.colors.Colormap.__call__`` and with a reference implementation
+in pure NumPy (based on ``numpy.take``).
+The smallest size measures the binding overhead.
+matplotlib is optional: its baselines are skipped if it is not installed.
+
+Usage::
+
+    python tests/python/bench_throughput.py [--max-size 1e7] [--min-time 0.2] [--json out.json]
+
+Note that ``--max-size 1e8`` needs several GB of memory (the output of ``as_colors`` is 24 bytes
+per element).
+"""
+import argparse
+import json
+import statistics
+import time
+
+import cppcolormap
+import numpy as np
+
+try:
+    import matplotlib
+    import matplotlib.colors
+except ImportError:
+    matplotlib = None
+
+
+def timeit(func, min_time: float) -> float:
+    """
+    Median wall-time of ``func()`` (repeated at least three times, and at least ``min_time``).
+    """
+    func()
+    t = []
+    while len(t) < 3 or sum(t) < min_time:
+        tic = time.perf_counter()
+        func()
+        t.append(time.perf_counter() - tic)
+    return statistics.median(t)
+
+
+def mpl_colormap(name: str, N: int):
+    if hasattr(matplotlib, "colormaps"):
+        return matplotlib.colormaps[name].resampled(N)
+    import matplotlib.cm
+
+    return matplotlib.cm.get_cmap(name, N)
+
+
+def numpy_as_colors(data, colors, vmin, vmax):
+    n = colors.shape[0]
+    idx = ((data - vmin) / (vmax - vmin) * (n - 1)).astype(np.intp)
+    np.clip(idx, 0, n - 1, out=idx)
+    return np.take(colors, idx, axis=0)
+
+
+def numpy_match(A, B, chunk=65536):
+    ret = np.empty(A.shape[0], dtype=np.intp)
+    for i in range(0, A.shape[0], chunk):
+        a = A[i : i + chunk]
+        ret[i : i + chunk] = np.argmin(((a[:, np.newaxis, :] - B[np.newaxis]) ** 2).sum(-1), axis=1)
+    return ret
+
+
+def numpy_interp(colors, N):
+    x = np.linspace(0, 1, colors.shape[0])
+    xi = np.linspace(0, 1, N)
+    return np.stack([np.interp(xi, x, colors[:, j]) for j in range(colors.shape[1])], axis=1)
+
+
+class Runner:
+    def __init__(self, min_time: float):
+        self.min_time = min_time
+        self.results = []
+
+    def run(self, group: str, size: int, cases: dict):
+        t = {name: timeit(func, self.min_time) for name, func in cases.items()}
+        base = t["cppcolormap"]
+        for name, dt in t.items():
+            print(
+                f"{group:>12s} {size:>10d} {name:>12s}: {1e3 * dt:10.3f} ms, "
+                f"{size / dt:10.3e} elements/s, {dt / base:6.2f}x cppcolormap"
+            )
+            self.results.append(dict(group=group, size=size, implementation=name, seconds=dt))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--max-size", type=float, default=1e7, help="Largest number of elements")
+    parser.add_argument("--min-time", type=float, default=0.2, help="Minimal time per case [s]")
+    parser.add_argument("--json", type=str, help="Write results to JSON file")
+    args = parser.parse_args()
+
+    sizes = [int(10**i) for i in range(3, 9) if 10**i <= args.max_size]
+    runner = Runner(args.min_time)
+    rng = np.random.default_rng(0)
+
+    colors = cppcolormap.viridis(256)
+    cmap = matplotlib.colors.ListedColormap(colors) if matplotlib else None
+
+    for n in [1] + sizes:
+        data = rng.random(n)
+        ref = cppcolormap.as_colors(data, colors, 0.0, 1.0)
+        assert np.array_equal(numpy_as_colors(data, colors, 0.0, 1.0), ref)
+        cases = {
+            "cppcolormap": lambda: cppcolormap.as_colors(data, colors, 0.0, 1.0),
+            "numpy": lambda: numpy_as_colors(data, colors, 0.0, 1.0),
+        }
+        if matplotlib:
+            cases["matplotlib"] = lambda: cmap(data)
+        runner.run("as_colors", n, cases)
+
+    palette = cppcolormap.tue()
+    for n in [1] + [s for s in sizes if s <= 1e6]:
+        A = rng.random((n, 3))
+        cases = {
+            "cppcolormap": lambda: cppcolormap.match(A, palette, cppcolormap.euclidean),
+            "numpy": lambda: numpy_match(A, palette),
+        }
+        runner.run("match", n, cases)
+
+    base = cppcolormap.Reds(9)
+    for n in [s for s in sizes if s <= 1e6]:
+        cases = {
+            "cppcolormap": lambda: cppcolormap.interp(base, n),
+            "numpy": lambda: numpy_interp(base, n),
+        }
+        if matplotlib:
+            lin = matplotlib.colors.LinearSegmentedColormap.from_list("Reds", base, N=n)
+            xi = np.linspace(0, 1, n)
+            cases["matplotlib"] = lambda: lin(xi)
+        runner.run("interp", n, cases)
+
+    for name in ["viridis", "jet", "Reds", "Spectral"]:
+        cases = {"cppcolormap": lambda: cppcolormap.colormap(name, 256)}
+        if matplotlib:
+            cases["matplotlib"] = lambda: mpl_colormap(name, 256)(np.arange(256))
+        runner.run(name, 256, cases)
+
+    if args.json:
+        with open(args.json, "w") as file:
+            json.dump(
+                dict(version=cppcolormap.version(), benchmarks=runner.results), file, indent=2
+            )
+
+
+if __name__ == "__main__":
+    main()
@@ -1,4 +1,7 @@
+import os
+
 import cppcolormap
+import numpy as np
 
 cmaps = [
     "Accent",
@@ -182,3 +185,149 @@ cmaps = [
 
 for cmap in cmaps:
     c = cppcolormap.colormap(cmap)
+
+c = cppcolormap.jet()
+
+for space in [
+    cppcolormap.linear_RGB,
+    cppcolormap.XYZ,
+    cppcolormap.CIELAB,
+    cppcolormap.Oklab,
+    cppcolormap.HSV,
+    cppcolormap.HSL,
+]:
+    d = cppcolormap.convert(c, cppcolormap.sRGB, space)
+    assert np.allclose(cppcolormap.convert(d, space, cppcolormap.sRGB), c)
+
+c8 = cppcolormap.pack_srgb8(c)
+assert c8.dtype == np.uint8
+assert np.allclose(cppcolormap.convert(c8, cppcolormap.sRGB, cppcolormap.sRGB), c, atol=0.5 / 255)
+
+# strided input: reversed rows, the first three columns of RGBA, column-major
+rgba = np.hstack((c, np.ones((c.shape[0], 1))))
+lab = cppcolormap.convert(c, cppcolormap.sRGB, cppcolormap.CIELAB)
+assert np.allclose(cppcolormap.convert(c[::-1], cppcolormap.sRGB, cppcolormap.CIELAB), lab[::-1])
+assert np.allclose(cppcolormap.convert(rgba[:, :3], cppcolormap.sRGB, cppcolormap.CIELAB), lab)
+d = cppcolormap.convert(c8[::-1], cppcolormap.sRGB, cppcolormap.sRGB)
+assert np.array_equal(d, c8[::-1] / 255)
+assert np.array_equal(cppcolormap.pack_srgb8(np.asfortranarray(c)), c8)
+assert np.array_equal(cppcolormap.pack_srgb8(c[::-1]), c8[::-1])
+ok = cppcolormap.interp(c, 7, cppcolormap.Oklab)
+assert np.allclose(cppcolormap.interp(np.asfortranarray(c), 7, cppcolormap.Oklab), ok)
+assert np.allclose(cppcolormap.interp(rgba[:, :3], 7, cppcolormap.Oklab), ok)
+
+data = np.linspace(0, 1, 1000)
+idx = cppcolormap.as_indices(data, c.shape[0], 0, 1)
+assert idx.dtype == np.uint8
+assert np.allclose(c[idx], cppcolormap.as_colors(data, c, 0, 1))
+assert cppcolormap.as_indices(data, 1000).dtype == np.uint16
+
+grid = np.linspace(0, 1, 6 * 8, dtype=np.float32).reshape(6, 8)
+for view in [grid[::-1, ::2], grid.T, np.asfortranarray(grid)]:
+    expect = cppcolormap.as_indices(np.ascontiguousarray(view), 7, 0, 1)
+    assert np.all(cppcolormap.as_indices(view, 7, 0, 1) == expect)
+
+image = cppcolormap.as_colors(np.linspace(0, 1, 64 * 64).reshape(64, 64), c)
+xterm = cppcolormap.xterm()
+expect = cppcolormap.match(c[::-1].copy(), xterm)
+assert np.all(cppcolormap.match(c[::-1], np.asfortranarray(xterm)) == expect)
+assert cppcolormap.dither_floyd_steinberg(image, xterm).dtype == np.uint8
+assert cppcolormap.dither_ordered(image, xterm).shape == (64, 64)
+
+out = cppcolormap.as_ansi(np.zeros((4, 10)), c, 10, 2)
+assert out.count("\n") == 2
+
+grid = np.linspace(0, 1, 4 * 10).reshape(4, 10)
+expect = cppcolormap.AnsiRenderer(c).render(grid.T.copy(), 4, 5, 0, 1)
+assert cppcolormap.AnsiRenderer(c).render(grid.T, 4, 5, 0, 1) == expect
+
+h = cppcolormap.rgb2hex_array(np.array([[0.0, 0.0, 1.0], [1.0, 1.0, 1.0]]))
+assert h.dtype == np.dtype("S7")
+assert list(h) == [b"#0000ff", b"#ffffff"]
+rgba = np.array([[0.0, 0.0, 1.0, 0.5], [1.0, 1.0, 1.0, 0.5]])
+assert list(cppcolormap.rgb2hex_array(rgba[:, :3])) == list(h)
+assert cppcolormap.rgb2hex(rgba[::-1, :3]) == ["#ffffff", "#0000ff"]
+assert np.allclose(cppcolormap.hex2rgb_array(h), [[0, 0, 1], [1, 1, 1]])
+assert np.allclose(cppcolormap.hex2rgba(["#fff", "#00000000"]), [[1, 1, 1, 1], [0, 0, 0, 0]])
+
+data = np.linspace(0, 1, 2000).reshape(40, 50)
+ref = cppcolormap.as_colors(data, c, 0, 1)
+for dtype in [np.float32, np.int8, np.uint8, np.int16, np.uint16, np.int32, np.int64]:
+    d = (data * 100).astype(dtype)
+    assert np.allclose(cppcolormap.as_colors(d, c), cppcolormap.as_colors(d.astype(float), c))
+assert np.allclose(cppcolormap.as_colors(data.T, c, 0, 1), ref.transpose(1, 0, 2))
+assert np.allclose(cppcolormap.as_colors(data[::2, ::3], c, 0, 1), ref[::2, ::3])
+out = np.empty(data.shape + (3,))
+assert cppcolormap.as_colors(data, c, 0, 1, out=out) is not None
+assert np.allclose(out, ref)
+reverse = cppcolormap.as_colors(data, c[::-1].copy(), 0, 1)
+assert np.allclose(cppcolormap.as_colors(data, c[::-1], 0, 1), reverse)
+
+try:
+    cppcolormap.as_colors(np.ones(10), c)
+    raise AssertionError("expected ValueError")
+except ValueError:
+    pass
+
+for dtype in [np.float64, np.float32, np.int16, np.uint8]:
+    d = (data * 100).astype(dtype)
+    ref_d = cppcolormap.as_colors(d, c, 0, 100)
+    assert np.allclose(cppcolormap.as_colors_ufunc(d, c, 0, 100), ref_d)
+out = np.empty(data.shape + (3,))
+cppcolormap.as_colors_ufunc(data, c, 0, 1, out=out)
+assert np.allclose(out, ref)
+lowest = cppcolormap.as_colors_ufunc(data[:, 0], c, data[:, 0], 1.0)
+assert np.allclose(lowest, c[np.zeros(40, int)])
+
+assert np.allclose(cppcolormap.Reds(20), cppcolormap.colormap("Reds", 20))
+assert cppcolormap.Accent().shape[0] == 8
+assert np.allclose(cppcolormap.tue(), cppcolormap.colorcycle("tue"))
+assert "viridis_r" in dir(cppcolormap)
+assert "viridis_r" in cppcolormap.registered_colormaps()
+assert not hasattr(cppcolormap, "not_a_colormap")
+
+pack = f"cppcolormap-test-{os.getpid()}.cmpack"
+ref = cppcolormap.colormap("viridis", 100)
+cppcolormap.write_colormap_pack(pack, ["viridis", "tue"])
+assert cppcolormap.load_colormap_pack(pack) == ["tue", "viridis"]
+assert np.allclose(cppcolormap.colormap("viridis", 100), ref, atol=1e-6)
+os.remove(pack)
+
+table = f"cppcolormap-test-{os.getpid()}.csv"
+with open(table, "w") as file:
+    file.write("0,0,0\n255,255,255\n")
+assert cppcolormap.load_colormaps(table) == [table[:-4]]
+assert np.allclose(cppcolormap.colormap(table[:-4], 3), [[0, 0, 0], [0.5, 0.5, 0.5], [1, 1, 1]])
+os.remove(table)
+
+name = f"cppcolormap-test-{os.getpid()}"
+shared = cppcolormap.SharedColormap.publish(name, cppcolormap.viridis(1000))
+attached = cppcolormap.SharedColormap.attach(name)
+view = np.asarray(attached)
+assert not view.flags.writeable
+assert np.allclose(view, cppcolormap.viridis(1000))
+cppcolormap.SharedColormap.unlink(name)
+
+table = cppcolormap.viridis(1000)[::-1]
+shared = cppcolormap.SharedColormap.publish(name, table)
+assert np.array_equal(np.asarray(cppcolormap.SharedColormap.attach(name)), table)
+cppcolormap.SharedColormap.unlink(name)
+
+stats = cppcolormap.stats()
+assert set(stats) == {"as_colors", "match", "interp", "colormap"}
+if cppcolormap.stats_enabled():
+    cppcolormap.reset_stats()
+    cppcolormap.as_colors(data, c, 0, 1)
+    stats = cppcolormap.stats()
+    assert stats["as_colors"]["calls"] == 1
+    assert stats["as_colors"]["elements"] == data.size
+
+backend = cppcolormap.get_parallel_backend()
+grain = cppcolormap.get_parallel_grain()
+cppcolormap.set_parallel_backend(cppcolormap.serial)
+serial = cppcolormap.as_colors(data, c, 0, 1)
+cppcolormap.set_parallel_backend(cppcolormap.thread_pool)
+cppcolormap.set_parallel_grain(100)
+assert np.allclose(cppcolormap.as_colors(data, c, 0, 1), serial)
+cppcolormap.set_parallel_grain(grain)
+cppcolormap.set_parallel_backend(backend)
@@ -0,0 +1,147 @@
+/**
+ * Convert a ``.npy`` file to colours (a ``.npy`` file of 8-bit pixels), using memory mapping.
+ *
+ * Usage::
+ *
+ *     cppcolormap-npy INPUT.npy OUTPUT.npy [--cmap viridis] [--N 256]
+ *         [--vmin VALUE --vmax VALUE] [--format rgb|rgba|bgr|bgra] [--threads N]
+ *
+ * Without `--vmin` and `--vmax` the limits of the data are used.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cppcolormap.h>
+#include <cppcolormap/npy.h>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " INPUT.npy OUTPUT.npy [--cmap NAME] [--N N]"
+              << " [--vmin VALUE --vmax VALUE] [--format rgb|rgba|bgr|bgra] [--threads N]\n";
+    return 1;
+}
+
+/**
+ * Parse a non-negative integer (the whole string).
+ */
+bool parse(const char* str, size_t& out)
+{
+    char* end;
+    errno = 0;
+    unsigned long long value = std::strtoull(str, &end, 10);
+    out = static_cast<size_t>(value);
+    return std::isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0;
+}
+
+/**
+ * Parse a finite floating-point number (the whole string).
+ */
+bool parse(const char* str, double& out)
+{
+    char* end;
+    errno = 0;
+    out = std::strtod(str, &end);
+    return end != str && *end == '\0' && errno == 0 && std::isfinite(out);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> files;
+    std::string cmap = "viridis";
+    std::string format = "rgb";
+    size_t N = 256;
+    size_t threads = 0;
+    double vmin = 0.0;
+    double vmax = 0.0;
+    bool vmin_set = false;
+    bool vmax_set = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cmap" && i + 1 < argc) {
+            cmap = argv[++i];
+        }
+        else if (arg == "--N" && i + 1 < argc) {
+            if (!parse(argv[++i], N) || N == 0) {
+                return usage(argv[0]);
+            }
+        }
+        else if (arg == "--vmin" && i + 1 < argc) {
+            if (!parse(argv[++i], vmin)) {
+                return usage(argv[0]);
+            }
+            vmin_set = true;
+        }
+        else if (arg == "--vmax" && i + 1 < argc) {
+            if (!parse(argv[++i], vmax)) {
+                return usage(argv[0]);
+            }
+            vmax_set = true;
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            if (!parse(argv[++i], threads) || threads == 0) {
+                return usage(argv[0]);
+            }
+            cppcolormap::set_num_threads(threads);
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            return usage(argv[0]);
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.size() != 2 || vmin_set != vmax_set || (vmin_set && !(vmax > vmin))) {
+        return usage(argv[0]);
+    }
+
+    cppcolormap::pixel_format fmt;
+
+    if (format == "rgb") {
+        fmt = cppcolormap::rgb;
+    }
+    else if (format == "rgba") {
+        fmt = cppcolormap::rgba;
+    }
+    else if (format == "bgr") {
+        fmt = cppcolormap::bgr;
+    }
+    else if (format == "bgra") {
+        fmt = cppcolormap::bgra;
+    }
+    else {
+        return usage(argv[0]);
+    }
+
+    try {
+        cppcolormap::CompiledColormap<uint8_t> colors(cppcolormap::colormap(cmap, N), fmt);
+
+        if (vmin_set) {
+            cppcolormap::npy_as_colors(files[0], files[1], colors, vmin, vmax);
+        }
+        else {
+            auto lim = cppcolormap::npy_as_colors(files[0], files[1], colors);
+            std::cout << "vmin = " << lim.first << ", vmax = " << lim.second << "\n";
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * Export colormaps to a binary pack, or list the content of a pack.
+ *
+ * Usage::
+ *
+ *     cppcolormap-pack OUTPUT.cmpack [--load INPUT ...] [NAME ...]
+ *     cppcolormap-pack --list INPUT.cmpack
+ *
+ * Without names all built-in colormaps, and all colormaps loaded with ``--load``,
+ * are exported, see cppcolormap::write_colormap_pack.
+ * The inputs are packs (``.cmpack``) or colormap files (``.csv``, ``.tsv``, ``.txt``, ``.cpt``,
+ * ``.xml``, ``.json``), see cppcolormap::load_colormaps.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#include <cppcolormap.h>
+#include <cppcolormap/loaders.h>
+#include <cppcolormap/pack.h>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " OUTPUT.cmpack [--load INPUT ...] [NAME ...]\n"
+              << "       " << name << " --list INPUT.cmpack\n";
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    std::vector<std::string> load;
+    std::string list;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--load" && i + 1 < argc) {
+            load.push_back(argv[++i]);
+        }
+        else if (arg == "--list" && i + 1 < argc) {
+            list = argv[++i];
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            return usage(argv[0]);
+        }
+        else {
+            args.push_back(arg);
+        }
+    }
+
+    if (list.empty() == args.empty()) {
+        return usage(argv[0]);
+    }
+
+    try {
+        if (!list.empty()) {
+            auto pack = cppcolormap::ColormapPack::open(list);
+            for (size_t i = 0; i < pack.size(); ++i) {
+                auto& entry = pack[i];
+                std::cout << std::string(entry.name, entry.name_size) << " " << entry.rows << "x"
+                          << entry.cols << (entry.fixed ? " (cycle)" : "") << "\n";
+            }
+            return 0;
+        }
+
+        for (auto& path : load) {
+            if (path.size() > 7 && path.compare(path.size() - 7, 7, ".cmpack") == 0) {
+                cppcolormap::load_colormap_pack(path);
+            }
+            else {
+                cppcolormap::load_colormaps(path);
+            }
+        }
+
+        std::vector<std::string> names(args.begin() + 1, args.end());
+
+        if (names.empty()) {
+            names = cppcolormap::registered_colormaps();
+        }
+
+        cppcolormap::write_colormap_pack(args[0], names);
+        std::cout << names.size() << " colormaps written to " << args[0] << "\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+/**
+ * Render a 2-d field (``.npy`` or raw binary) to an image.
+ *
+ * Usage::
+ *
+ *     cppcolormap-render INPUT OUTPUT [--cmap viridis] [--N 256] [--vmin VALUE --vmax VALUE]
+ *         [--size WIDTHxHEIGHT] [--raw HEIGHTxWIDTH --dtype f8] [--alpha] [--indexed]
+ *         [--flip] [--threads N]
+ *
+ * The input is memory-mapped. The image format follows from the extension of OUTPUT
+ * (``.ppm``, ``.bmp``, ``.qoi``, ``.png``), see cppcolormap::ImageWriter.
+ * Without ``--vmin`` and ``--vmax`` the limits of the data are used.
+ * With ``--size`` the field is resampled (nearest neighbour).
+ * With ``--flip`` the first row of the field is the bottom row of the image.
+ * With ``--indexed`` (an 8-bit palette PNG) ``--N`` is at most 256.
+ *
+ * @file
+ * @copyright Copyright. Tom de Geus. All rights reserved.
+ * \license This project is released under the GPLv3 License.
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cppcolormap.h>
+#include <cppcolormap/image.h>
+#include <cppcolormap/mmap.h>
+#include <cppcolormap/npy.h>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct Options {
+    std::string input;
+    std::string output;
+    std::string cmap = "viridis";
+    size_t N = 256;
+    double vmin = 0.0;
+    double vmax = 0.0;
+    bool limits = false;
+    size_t width = 0;
+    size_t height = 0;
+    size_t raw_width = 0;
+    size_t raw_height = 0;
+    std::string dtype;
+    bool alpha = false;
+    bool indexed = false;
+    bool flip = false;
+};
+
+int usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " INPUT OUTPUT [--cmap NAME] [--N N]"
+              << " [--vmin VALUE --vmax VALUE] [--size WIDTHxHEIGHT]"
+              << " [--raw HEIGHTxWIDTH --dtype f4|f8|i1|u1|i2|u2|i4|u4|i8|u8]"
+              << " [--alpha] [--indexed] [--flip] [--threads N]\n";
+    return 1;
+}
+
+/**
+ * Parse a non-negative integer (the whole string).
+ */
+bool parse(const char* str, size_t& out)
+{
+    char* end;
+    errno = 0;
+    unsigned long long value = std::strtoull(str, &end, 10);
+    out = static_cast<size_t>(value);
+    return std::isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0;
+}
+
+/**
+ * Parse a finite floating-point number (the whole string).
+ */
+bool parse(const char* str, double& out)
+{
+    char* end;
+    errno = 0;
+    out = std::strtod(str, &end);
+    return end != str && *end == '\0' && errno == 0 && std::isfinite(out);
+}
+
+/**
+ * Parse `AxB`, with `A > 0` and `B > 0`.
+ */
+bool parse_size(const std::string& arg, size_t& a, size_t& b)
+{
+    size_t i = arg.find('x');
+
+    if (i == std::string::npos) {
+        return false;
+    }
+
+    return parse(arg.substr(0, i).c_str(), a) && parse(arg.substr(i + 1).c_str(), b) && a > 0 &&
+           b > 0;
+}
+
+template <typename T>
+void render(const T* data, size_t h, size_t w, const Options& opt)
+{
+    if (h == 0 || w == 0) {
+        throw std::runtime_error("Input is empty");
+    }
+
+    double vmin = opt.vmin;
+    double vmax = opt.vmax;
+
+    if (!opt.limits) {
+        std::tie(vmin, vmax) = cppcolormap::limits(data, h * w);
+        if (!(vmax > vmin)) {
+            vmax = vmin + 1.0;
+        }
+        std::cout << "vmin = " << vmin << ", vmax = " << vmax << "\n";
+    }
+
+    size_t W = opt.width ? opt.width : w;
+    size_t H = opt.height ? opt.height : h;
+    bool direct = W == w && H == h && !opt.flip;
+    auto colors = cppcolormap::colormap(opt.cmap, opt.N);
+    std::unique_ptr<cppcolormap::ImageWriter> image;
+    cppcolormap::CompiledColormap<uint8_t> cmap;
+    size_t nc = 1;
+
+    if (opt.indexed) {
+        image = std::make_unique<cppcolormap::ImageWriter>(opt.output, W, H, colors);
+    }
+    else {
+        cmap = cppcolormap::CompiledColormap<uint8_t>(
+            colors, opt.alpha ? cppcolormap::rgba : cppcolormap::rgb
+        );
+        nc = cmap.channels();
+        image = std::make_unique<cppcolormap::ImageWriter>(opt.output, W, H, nc);
+    }
+
+    std::vector<size_t> col(W);
+
+    for (size_t x = 0; x < W; ++x) {
+        col[x] = (2 * x + 1) * w / (2 * W);
+    }
+
+    size_t block = std::max(size_t(1), std::min(H, cppcolormap::get_parallel_grain() / W));
+    std::vector<T> rows(direct ? 0 : block * W);
+    std::vector<uint8_t> pixels(block * W * nc);
+
+    for (size_t y = 0; y < H; y += block) {
+        size_t n = std::min(block, H - y);
+        const T* src = data + y * w;
+
+        if (!direct) {
+            for (size_t i = 0; i < n; ++i) {
+                size_t r = (2 * (y + i) + 1) * h / (2 * H);
+                const T* row = data + (opt.flip ? h - 1 - r : r) * w;
+                for (size_t x = 0; x < W; ++x) {
+                    rows[i * W + x] = row[col[x]];
+                }
+            }
+            src = rows.data();
+        }
+
+        if (opt.indexed) {
+            cppcolormap::as_indices(src, n * W, 1, colors.shape(0), vmin, vmax, pixels.data());
+        }
+        else {
+            cppcolormap::as_colors(src, n * W, 1, cmap, vmin, vmax, pixels.data());
+        }
+
+        image->write_rows(pixels.data(), n);
+    }
+
+    image->close();
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    std::vector<std::string> files;
+    bool vmin_set = false;
+    bool vmax_set = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cmap" && i + 1 < argc) {
+            opt.cmap = argv[++i];
+        }
+        else if (arg == "--N" && i + 1 < argc) {
+            if (!parse(argv[++i], opt.N) || opt.N == 0) {
+                return usage(argv[0]);
+            }
+        }
+        else if (arg == "--vmin" && i + 1 < argc) {
+            if (!parse(argv[++i], opt.vmin)) {
+                return usage(argv[0]);
+            }
+            vmin_set = true;
+        }
+        else if (arg == "--vmax" && i + 1 < argc) {
+            if (!parse(argv[++i], opt.vmax)) {
+                return usage(argv[0]);
+            }
+            vmax_set = true;
+        }
+        else if (arg == "--size" && i + 1 < argc) {
+            if (!parse_size(argv[++i], opt.width, opt.height)) {
+                return usage(argv[0]);
+            }
+        }
+        else if (arg == "--raw" && i + 1 < argc) {
+            if (!parse_size(argv[++i], opt.raw_height, opt.raw_width)) {
+                return usage(argv[0]);
+            }
+        }
+        else if (arg == "--dtype" && i + 1 < argc) {
+            opt.dtype = argv[++i];
+        }
+        else if (arg == "--alpha") {
+            opt.alpha = true;
+        }
+        else if (arg == "--indexed") {
+            opt.indexed = true;
+        }
+        else if (arg == "--flip") {
+            opt.flip = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            size_t threads;
+            if (!parse(argv[++i], threads) || threads == 0) {
+                return usage(argv[0]);
+            }
+            cppcolormap::set_num_threads(threads);
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            return usage(argv[0]);
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.size() != 2 || vmin_set != vmax_set || (opt.raw_width > 0) != !opt.dtype.empty()) {
+        return usage(argv[0]);
+    }
+
+    if ((vmin_set && !(opt.vmax > opt.vmin)) || (opt.indexed && opt.N > 256)) {
+        return usage(argv[0]);
+    }
+
+    opt.input = files[0];
+    opt.output = files[1];
+    opt.limits = vmin_set;
+
+    try {
+        if (opt.raw_width > 0) {
+            std::string descr = (opt.dtype.back() == '1' ? "|" : "<") + opt.dtype;
+            auto map = cppcolormap::MemoryMap::open_file(opt.input);
+            size_t h = opt.raw_height;
+            size_t w = opt.raw_width;
+
+            cppcolormap::detail::npy_dispatch(descr, [&](auto tag) {
+                using T = decltype(tag);
+                if (h > map.size() / sizeof(T) / w) {
+                    throw std::runtime_error("Input smaller than --raw size");
+                }
+                render(reinterpret_cast<const T*>(map.data()), h, w, opt);
+            });
+        }
+        else {
+            auto file = cppcolormap::NpyFile::open(opt.input);
+            const auto& header = file.header();
+
+            if (header.shape.empty() || header.shape.size() > 2 || header.fortran_order) {
+                throw std::runtime_error("Input must be a C-ordered 1-d or 2-d array");
+            }
+
+            size_t h = header.shape.size() == 2 ? header.shape[0] : 1;
+            size_t w = header.shape.back();
+
+            cppcolormap::detail::npy_dispatch(header.descr, [&](auto tag) {
+                using T = decltype(tag);
+                render(file.data<T>(), h, w, opt);
+            });
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}